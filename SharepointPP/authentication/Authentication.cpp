@@ -7,19 +7,28 @@
 #include "STSRequest.h"
 #include "../common/tinyxml2.h"
 
+#include "../common/PercentEncoding.h"
+#include "../common/XmlDocumentPool.h"
+#include "../common/XmlPath.h"
 #include "../common/WebRequest.h"
 #include "../common/WebResponse.h"
 #include "../common/TimeUtils.h"
 
 using Microsoft::Sharepoint::Authentication;
+using Microsoft::Sharepoint::CookieJar;
+using Microsoft::Sharepoint::PercentEncoding;
 using Microsoft::Sharepoint::SecurityDigest;
 using Microsoft::Sharepoint::WebRequest;
+using Microsoft::Sharepoint::XmlDocumentPool;
+using Microsoft::Sharepoint::XmlPath;
 
-Authentication::Authentication()
+Authentication::Authentication() :
+	m_cookieJar(std::make_shared<CookieJar>())
 {
 }
 
-Authentication::Authentication(std::string && username, std::string && password, const std::string &endpoint)
+Authentication::Authentication(std::string && username, std::string && password, const std::string &endpoint) :
+	m_cookieJar(std::make_shared<CookieJar>())
 {
 	setSharepointEndpoint(endpoint);
 	if (!login(std::move(username), std::move(password))) {
@@ -77,12 +86,17 @@ WebRequest::CookieContainerType Authentication::getSecurityCookies() const
 	return m_securityCookies;
 }
 
+std::shared_ptr<CookieJar> Authentication::getCookieJar() const
+{
+	return m_cookieJar;
+}
+
 WebRequest Authentication::getPreparedRequest() const
 {
 	WebRequest newRequest;
 	newRequest.addHeader("X-RequestDigest", m_requestDigest.value());
 	newRequest.addHeader("accept", "application/xml;odata=verbose");
-	newRequest.setCookies(m_securityCookies);
+	newRequest.setCookieJar(m_cookieJar);
 	return newRequest;
 }
 
@@ -97,13 +111,14 @@ bool Authentication::login(std::string && username, std::string && password)
 		WebResponse stsResponse = stsRequest.post(m_stsEndpoint, std::move(preparedSoapRequest));
 		if (stsResponse.httpStatusCode() >= 0) {
 			// got the response from the sts server
-			std::string responseData = stsResponse.response();
+			std::string responseData = stsResponse.takeResponse();
 			if (responseData.length() > 0) {
 				// parse the response from the sts server to get the binary security token
 				std::string securityCode = parseSTSResponse(std::move(responseData), m_endpoint);
 				if (securityCode.length() > 0) {
 					// send the security token to the default login page of the sharepoint server
 					WebRequest loginPageRequest;
+					loginPageRequest.setCookieJar(m_cookieJar);
 					WebResponse loginPageResponse = loginPageRequest.post(m_defaultLoginPage, std::move(securityCode));
 					if (loginPageResponse.httpStatusCode() >= 0) {
 						// got both important cookies from the default login page of the sharepoint server
@@ -111,11 +126,11 @@ bool Authentication::login(std::string && username, std::string && password)
 						if (m_securityCookies.size() > 0) {
 							WebRequest contextInfoRequest;
 							contextInfoRequest.setContentType("application/x-www-form-urlencoded");
-							contextInfoRequest.setCookies(m_securityCookies);
+							contextInfoRequest.setCookieJar(m_cookieJar);
 							WebResponse contextInfoResponse = contextInfoRequest.post(m_contextInfoUrl, "");
 							if (contextInfoResponse.httpStatusCode() >= 0) {
 								// got the request digest from the sharepoint server
-								responseData = contextInfoResponse.response();
+								responseData = contextInfoResponse.takeResponse();
 								parseContextInfoResponse(std::move(responseData));
 								if (tokenIsValid()) {
 									return true;
@@ -132,102 +147,31 @@ bool Authentication::login(std::string && username, std::string && password)
 
 std::string Authentication::getPreparedSoapData(std::string && username, std::string && password, const std::string & endpoint)
 {
-	tinyxml2::XMLDocument doc;
-	//doc.LoadFile("STSRequest.xml");
-	doc.Parse(STSRequest::Value);
-	tinyxml2::XMLElement *envelope = doc.FirstChildElement("s:Envelope");
-	if(envelope != nullptr) {
-		tinyxml2::XMLElement *header =  envelope->FirstChildElement("s:Header");
-		if(header != nullptr) {
-			tinyxml2::XMLElement *security = header->FirstChildElement("o:Security");
-			if(security != nullptr) {
-				tinyxml2::XMLElement *usernameToken = security->FirstChildElement("o:UsernameToken");
-				if(usernameToken != nullptr) {
-					tinyxml2::XMLElement *usernameElement = usernameToken->FirstChildElement("o:Username");
-					tinyxml2::XMLElement *passwordElement = usernameToken->FirstChildElement("o:Password");
-					if(usernameElement != nullptr && passwordElement != nullptr) {
-						usernameElement->SetText(username.data());
-						passwordElement->SetText(password.data());
-					} else {
-						printf("no username/password element found...\n");
-						return std::string();
-					}
-				} else {
-					printf("no usernameToken element found...\n");
-					return std::string();
-				}
-			} else {
-				printf("no security element found...\n");
-				return std::string();
-			}
-		} else {
-			printf("no header element found...\n");
-			return std::string();
-		}
-		tinyxml2::XMLElement *body = envelope->FirstChildElement("s:Body");
-		if(body != nullptr) {
-			tinyxml2::XMLElement *requestSecurityToken = body->FirstChildElement("t:RequestSecurityToken");
-			if(requestSecurityToken != nullptr) {
-				tinyxml2::XMLElement *appliesTo = requestSecurityToken->FirstChildElement("wsp:AppliesTo");
-				if(appliesTo != nullptr) {
-					tinyxml2::XMLElement *endpointReference = appliesTo->FirstChildElement("a:EndpointReference");
-					if(endpointReference != nullptr) {
-						tinyxml2::XMLElement *address = endpointReference->FirstChildElement("a:Address");
-						if(address != nullptr) {
-							address->SetText(endpoint.data());
-						} else {
-							return std::string();
-						}
-					} else {
-						return std::string();
-					}
-				} else {
-					return std::string();
-				}
-			} else {
-				return std::string();
-			}
-		} else {
-			return std::string();
-		}
-	} else {
-		return std::string();
-	}
-	tinyxml2::XMLPrinter printer;
-	doc.Print(&printer);
-	return std::string(printer.CStr(), printer.CStrSize());
+	// the envelope is precompiled, only the escaped values are filled in
+	return STSRequest::build(username, password, endpoint);
 }
 
 std::string Authentication::parseSTSResponse(std::string && responseXml, const std::string & endpoint)
 {
-	tinyxml2::XMLDocument doc;
-	doc.Parse(responseXml.data());
-	tinyxml2::XMLElement *envelope = doc.FirstChildElement("S:Envelope");
-	if(envelope != nullptr) {
-		tinyxml2::XMLElement *body = envelope->FirstChildElement("S:Body");
-		if(body != nullptr) {
-			tinyxml2::XMLElement *requestSecurityTokenResponse = body->FirstChildElement("wst:RequestSecurityTokenResponse");
-			if(requestSecurityTokenResponse != nullptr) {
-				tinyxml2::XMLElement *appliesTo = requestSecurityTokenResponse->FirstChildElement("wsp:AppliesTo");
-				if(appliesTo != nullptr) {
-					tinyxml2::XMLElement *endpointReference = appliesTo->FirstChildElement("wsa:EndpointReference");
-					if(endpointReference != nullptr) {
-						tinyxml2::XMLElement *address = endpointReference->FirstChildElement("wsa:Address");
-						if(address != nullptr) {
-							if(strcmp(address->GetText(), endpoint.data()) != 0) {
-								return std::string();
-							}
-						}
-					}
-				}
-				tinyxml2::XMLElement *requestedSecurityToken = requestSecurityTokenResponse->FirstChildElement("wst:RequestedSecurityToken");
-				if(requestedSecurityToken != nullptr) {
-					tinyxml2::XMLElement *binarySecurityToken = requestedSecurityToken->FirstChildElement("wsse:BinarySecurityToken");
-					if(binarySecurityToken != nullptr) {
-						return WebRequest::getUnescapedString(binarySecurityToken->GetText());
-					}
-				}
-			}
+	static const XmlPath responsePath(
+		"S:Envelope/S:Body/wst:RequestSecurityTokenResponse", stsResponseNamespaces());
+	static const XmlPath addressPath(
+		"wsp:AppliesTo/wsa:EndpointReference/wsa:Address", stsResponseNamespaces());
+	static const XmlPath binarySecurityTokenPath(
+		"wst:RequestedSecurityToken/wsse:BinarySecurityToken", stsResponseNamespaces());
+	XmlDocumentPool::DocumentLease doc(XmlDocumentPool::document());
+	// the document takes over the response body and parses it in place
+	doc->ParseInSitu(std::move(responseXml));
+	const tinyxml2::XMLElement *requestSecurityTokenResponse = responsePath.first(*doc);
+	if(requestSecurityTokenResponse != nullptr) {
+		const char *address = addressPath.text(*requestSecurityTokenResponse);
+		if(address != nullptr && strcmp(address, endpoint.data()) != 0) {
+			return std::string();
+		}
+		const char *binarySecurityToken = binarySecurityTokenPath.text(*requestSecurityTokenResponse);
+		if(binarySecurityToken != nullptr) {
+			// decode straight from the parsed text, without an intermediate copy
+			return PercentEncoding::decode(binarySecurityToken);
 		}
 	}
 	return std::string();
@@ -235,24 +179,46 @@ std::string Authentication::parseSTSResponse(std::string && responseXml, const s
 
 void Authentication::parseContextInfoResponse(std::string && responseXml)
 {
-	tinyxml2::XMLDocument doc;
-	doc.Parse(responseXml.data());
-	tinyxml2::XMLElement *getContextWebInformation = doc.FirstChildElement("d:GetContextWebInformation");
-	if (getContextWebInformation != nullptr) {
-		tinyxml2::XMLElement *formDigestTimeoutSeconds = getContextWebInformation->FirstChildElement("d:FormDigestTimeoutSeconds");
-		size_t timeout = 0;
-		std::string securityDigestValue;
-		if (formDigestTimeoutSeconds != nullptr) {
-			std::stringstream ss(formDigestTimeoutSeconds->GetText());
-			ss >> timeout;
-		}
-		tinyxml2::XMLElement *formDigestValue = getContextWebInformation->FirstChildElement("d:FormDigestValue");
-		if (formDigestValue != nullptr) {
-			securityDigestValue = std::string(formDigestValue->GetText());
-		}
-		if (securityDigestValue.length() > 0 && timeout > 0) {
-			SecurityDigest newSecurityDigest(securityDigestValue, timeout);
-			m_requestDigest = newSecurityDigest;
-		}
+	static const XmlPath timeoutPath(
+		"d:GetContextWebInformation/d:FormDigestTimeoutSeconds", contextInfoNamespaces());
+	static const XmlPath digestPath(
+		"d:GetContextWebInformation/d:FormDigestValue", contextInfoNamespaces());
+	XmlDocumentPool::DocumentLease doc(XmlDocumentPool::document());
+	// the document takes over the response body and parses it in place
+	doc->ParseInSitu(std::move(responseXml));
+	size_t timeout = 0;
+	std::string securityDigestValue;
+	const char *formDigestTimeoutSeconds = timeoutPath.text(*doc);
+	if (formDigestTimeoutSeconds != nullptr) {
+		std::stringstream ss(formDigestTimeoutSeconds);
+		ss >> timeout;
 	}
-}
\ No newline at end of file
+	const char *formDigestValue = digestPath.text(*doc);
+	if (formDigestValue != nullptr) {
+		securityDigestValue = std::string(formDigestValue);
+	}
+	if (securityDigestValue.length() > 0 && timeout > 0) {
+		SecurityDigest newSecurityDigest(securityDigestValue, timeout);
+		m_requestDigest = newSecurityDigest;
+	}
+}
+
+const XmlPath::NamespaceContainerType &Authentication::stsResponseNamespaces()
+{
+	static const XmlPath::NamespaceContainerType namespaces {
+		{"S", "http://www.w3.org/2003/05/soap-envelope"},
+		{"wsa", "http://www.w3.org/2005/08/addressing"},
+		{"wsse", "http://docs.oasis-open.org/wss/2004/01/oasis-200401-wss-wssecurity-secext-1.0.xsd"},
+		{"wst", "http://schemas.xmlsoap.org/ws/2005/02/trust"},
+		{"wsp", "http://schemas.xmlsoap.org/ws/2004/09/policy"}
+	};
+	return namespaces;
+}
+
+const XmlPath::NamespaceContainerType &Authentication::contextInfoNamespaces()
+{
+	static const XmlPath::NamespaceContainerType namespaces {
+		{"d", "http://schemas.microsoft.com/ado/2007/08/dataservices"}
+	};
+	return namespaces;
+}
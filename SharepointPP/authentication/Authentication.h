@@ -1,14 +1,22 @@
 #pragma once
 #include <string>
 #include <chrono>
+#include <memory>
 
 #include "SecurityDigest.h"
+#include "../common/CookieJar.h"
 #include "../common/WebRequest.h"
+#include "../common/XmlPath.h"
 
 namespace Microsoft {
 namespace Sharepoint {
 class Authentication
 {
+	// runs the steps of many logins concurrently
+	friend class LoginScheduler;
+	// measures the response parsing on its own
+	friend class Benchmark;
+
 public:
 	__declspec(dllexport)
 		Authentication();
@@ -42,6 +50,9 @@ public:
 		SecurityDigest getRequestDigest() const;
 	__declspec(dllexport)
 		WebRequest::CookieContainerType getSecurityCookies() const;
+	__declspec(dllexport)
+		std::shared_ptr<CookieJar> getCookieJar() const;
+	// the prepared request shares the cookie jar of this authentication
 	__declspec(dllexport)
 		WebRequest getPreparedRequest() const;
 
@@ -50,6 +61,8 @@ private:
 	static std::string getPreparedSoapData(std::string && username, std::string && password, const std::string & endpoint);
 	static std::string parseSTSResponse(std::string &&responseXml, const std::string &endpoint);
 	void parseContextInfoResponse(std::string &&responseXml);
+	static const XmlPath::NamespaceContainerType &stsResponseNamespaces();
+	static const XmlPath::NamespaceContainerType &contextInfoNamespaces();
 
 private:
 	std::string m_endpoint;
@@ -60,6 +73,7 @@ private:
 private:
 	SecurityDigest m_requestDigest;
 	WebRequest::CookieContainerType m_securityCookies;
+	std::shared_ptr<CookieJar> m_cookieJar;
 };
 
 }  // namespace Sharepoint
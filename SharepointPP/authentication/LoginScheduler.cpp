@@ -0,0 +1,179 @@
+#include "LoginScheduler.h"
+
+#include <algorithm>
+#include <map>
+#include <tuple>
+#include <utility>
+
+#include "../common/Url.h"
+#include "../common/WebRequest.h"
+
+using Microsoft::Sharepoint::Authentication;
+using Microsoft::Sharepoint::CookieJar;
+using Microsoft::Sharepoint::LoginScheduler;
+using Microsoft::Sharepoint::WebRequest;
+using Microsoft::Sharepoint::WebResponse;
+
+LoginScheduler::LoginScheduler(AsyncEngine &engine) :
+	m_engine(engine)
+{
+}
+
+LoginScheduler::~LoginScheduler()
+{
+}
+
+void LoginScheduler::addSite(const std::string & username, const std::string & password, const std::string & siteUrl)
+{
+	m_sites.push_back(Site{username, password, siteUrl});
+}
+
+void LoginScheduler::setSTSEndpoint(const std::string & stsEndpoint)
+{
+	m_stsEndpoint = stsEndpoint;
+}
+
+LoginScheduler::LoginContainerType LoginScheduler::run()
+{
+	m_logins.clear();
+	m_tenants.clear();
+	m_start = std::chrono::steady_clock::now();
+
+	// the sites of one user on one host share their tenant login
+	std::map<std::tuple<std::string, std::string, std::string>, size_t> tenantIndex;
+	for (const Site &site : m_sites) {
+		Login login {site.siteUrl, Authentication(), std::chrono::milliseconds(0)};
+		// normalizes the site url like every endpoint
+		login.authentication.setSharepointEndpoint(site.siteUrl);
+		const std::string siteEndpoint = login.authentication.m_endpoint;
+		const Url url(siteEndpoint);
+		const std::string hostEndpoint = std::string(url.protocolPrefix()) + std::string(url.host());
+		login.authentication.setSharepointEndpoint(hostEndpoint);
+		login.authentication.setSTSEndpoint(m_stsEndpoint);
+		login.authentication.setContextInfoUrl(siteEndpoint + "/_api/contextinfo");
+
+		auto key = std::make_tuple(site.username, site.password, hostEndpoint);
+		auto tenant = tenantIndex.find(key);
+		if (tenant == tenantIndex.end()) {
+			tenant = tenantIndex.emplace(std::move(key), m_tenants.size()).first;
+			m_tenants.push_back(Tenant{site.username, site.password, hostEndpoint,
+				std::make_shared<CookieJar>(), std::vector<size_t>()});
+		}
+		login.authentication.m_cookieJar = m_tenants[tenant->second].cookieJar;
+		m_tenants[tenant->second].logins.push_back(m_logins.size());
+		m_logins.push_back(std::move(login));
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_remaining = m_logins.size();
+	}
+	// the tenants don't move anymore, the completions refer to them
+	for (Tenant &tenant : m_tenants) {
+		requestSecurityToken(tenant);
+	}
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_done.wait(lock, [this]() { return m_remaining == 0; });
+	}
+
+	m_timeToAllAuthenticated = std::chrono::milliseconds(0);
+	for (const Login &login : m_logins) {
+		m_timeToAllAuthenticated = std::max(m_timeToAllAuthenticated, login.elapsed);
+	}
+	// the passwords aren't needed after the login anymore
+	for (Tenant &tenant : m_tenants) {
+		tenant.password.clear();
+	}
+	return std::move(m_logins);
+}
+
+std::chrono::milliseconds LoginScheduler::timeToAllAuthenticated() const
+{
+	return m_timeToAllAuthenticated;
+}
+
+size_t LoginScheduler::stsRequestCount() const
+{
+	return m_tenants.size();
+}
+
+void LoginScheduler::requestSecurityToken(Tenant & tenant)
+{
+	WebRequest stsRequest;
+	stsRequest.setContentType("application/xml");
+	m_engine.post(stsRequest, Url(m_stsEndpoint),
+		Authentication::getPreparedSoapData(std::string(tenant.username), std::string(tenant.password), tenant.endpoint),
+		[this, &tenant](WebResponse &&response) {
+			onSecurityToken(tenant, std::move(response));
+		});
+}
+
+void LoginScheduler::onSecurityToken(Tenant & tenant, WebResponse && response)
+{
+	std::string securityCode;
+	if (response.httpStatusCode() >= 0) {
+		securityCode = Authentication::parseSTSResponse(response.takeResponse(), tenant.endpoint);
+	}
+	if (securityCode.length() == 0) {
+		failTenant(tenant);
+		return;
+	}
+	// send the security token to the default login page of the host once for all its sites
+	WebRequest loginPageRequest;
+	loginPageRequest.setCookieJar(tenant.cookieJar);
+	const Authentication &authentication = m_logins[tenant.logins.front()].authentication;
+	m_engine.post(loginPageRequest, Url(authentication.m_defaultLoginPage), std::move(securityCode),
+		[this, &tenant](WebResponse &&response) {
+			onLoginPage(tenant, std::move(response));
+		});
+}
+
+void LoginScheduler::onLoginPage(Tenant & tenant, WebResponse && response)
+{
+	WebRequest::CookieContainerType securityCookies;
+	if (response.httpStatusCode() >= 0) {
+		securityCookies = response.cookies();
+	}
+	if (securityCookies.size() == 0) {
+		failTenant(tenant);
+		return;
+	}
+	// the cookies are in the jar, fetch the digests of all sites at once
+	for (size_t login : tenant.logins) {
+		Authentication &authentication = m_logins[login].authentication;
+		authentication.m_securityCookies = securityCookies;
+		WebRequest contextInfoRequest;
+		contextInfoRequest.setContentType("application/x-www-form-urlencoded");
+		contextInfoRequest.setCookieJar(tenant.cookieJar);
+		m_engine.post(contextInfoRequest, Url(authentication.m_contextInfoUrl), std::string(),
+			[this, login](WebResponse &&response) {
+				onContextInfo(login, std::move(response));
+			});
+	}
+}
+
+void LoginScheduler::onContextInfo(size_t login, WebResponse && response)
+{
+	if (response.httpStatusCode() >= 0) {
+		m_logins[login].authentication.parseContextInfoResponse(response.takeResponse());
+	}
+	completeLogin(login);
+}
+
+void LoginScheduler::failTenant(const Tenant & tenant)
+{
+	for (size_t login : tenant.logins) {
+		completeLogin(login);
+	}
+}
+
+void LoginScheduler::completeLogin(size_t login)
+{
+	m_logins[login].elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now() - m_start);
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (--m_remaining == 0) {
+		m_done.notify_all();
+	}
+}
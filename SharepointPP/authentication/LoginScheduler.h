@@ -0,0 +1,102 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Authentication.h"
+#include "../common/AsyncEngine.h"
+#include "../common/CookieJar.h"
+#include "../common/WebResponse.h"
+
+namespace Microsoft {
+namespace Sharepoint {
+// Logs in to many sites at once over an AsyncEngine.
+// The sites of one user on one host share a single STS request and a
+// single login page post, and with it the cookie jar. Once the cookies
+// are there, the context infos of all these sites are requested in
+// parallel. Logins of different users and hosts overlap completely.
+class LoginScheduler
+{
+public:
+	struct Login
+	{
+		std::string siteUrl;
+		Authentication authentication;
+		// from the start of run() until this site has its digest or failed
+		std::chrono::milliseconds elapsed;
+	};
+	typedef std::vector<Login> LoginContainerType;
+
+public:
+	__declspec(dllexport)
+		explicit LoginScheduler(AsyncEngine &engine);
+	__declspec(dllexport)
+		~LoginScheduler();
+	LoginScheduler(const LoginScheduler &other) = delete;
+	LoginScheduler &operator=(const LoginScheduler &other) = delete;
+
+public:
+	// the site url is the url of a site collection, like
+	// https://host.sharepoint.com/sites/name, or the root site https://host.sharepoint.com
+	__declspec(dllexport)
+		void addSite(const std::string &username, const std::string &password, const std::string &siteUrl);
+	// the sts endpoint url has to be in the form https://host/extSTS.srf
+	__declspec(dllexport)
+		void setSTSEndpoint(const std::string &stsEndpoint);
+
+public:
+	// logs in to all added sites, in the order they were added;
+	// a site failed to log in when its authentication has no valid token
+	__declspec(dllexport)
+		LoginScheduler::LoginContainerType run();
+	// the time the last run() took until every site was logged in or failed
+	__declspec(dllexport)
+		std::chrono::milliseconds timeToAllAuthenticated() const;
+	// the STS requests of the last run(), one per user and host
+	__declspec(dllexport)
+		size_t stsRequestCount() const;
+
+private:
+	struct Site
+	{
+		std::string username;
+		std::string password;
+		std::string siteUrl;
+	};
+	struct Tenant
+	{
+		std::string username;
+		std::string password;
+		std::string endpoint;
+		std::shared_ptr<CookieJar> cookieJar;
+		std::vector<size_t> logins;
+	};
+
+private:
+	void requestSecurityToken(Tenant &tenant);
+	void onSecurityToken(Tenant &tenant, WebResponse &&response);
+	void onLoginPage(Tenant &tenant, WebResponse &&response);
+	void onContextInfo(size_t login, WebResponse &&response);
+	void failTenant(const Tenant &tenant);
+	void completeLogin(size_t login);
+
+private:
+	AsyncEngine &m_engine;
+	std::string m_stsEndpoint {"https://login.microsoftonline.com/extSTS.srf"};
+	std::vector<Site> m_sites;
+
+private:
+	// state of the running run()
+	LoginContainerType m_logins;
+	std::vector<Tenant> m_tenants;
+	std::chrono::steady_clock::time_point m_start;
+	std::chrono::milliseconds m_timeToAllAuthenticated {0};
+	std::mutex m_mutex;
+	std::condition_variable m_done;
+	size_t m_remaining {0};
+};
+}  // namespace Sharepoint
+}  // namespace Microsoft
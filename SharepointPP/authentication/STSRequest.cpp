@@ -1,35 +1,114 @@
 #include "STSRequest.h"
 
-const char *STSRequest::Value = "<s:Envelope \
-	xmlns:s=\"http://www.w3.org/2003/05/soap-envelope\" \
-	xmlns:a=\"http://www.w3.org/2005/08/addressing\" \
-	xmlns:u=\"http://docs.oasis-open.org/wss/2004/01/oasis-200401-wss-wssecurity-utility-1.0.xsd\"> \
-	<s:Header> \
-		<a:Action s:mustUnderstand=\"1\">http://schemas.xmlsoap.org/ws/2005/02/trust/RST/Issue</a:Action> \
-		<a:ReplyTo> \
-			<a:Address>http://www.w3.org/2005/08/addressing/anonymous</a:Address> \
-		</a:ReplyTo> \
-		<a:To s:mustUnderstand=\"1\">https://login.microsoftonline.com/extSTS.srf</a:To> \
-		<o:Security \
-			s:mustUnderstand=\"1\" \
-			xmlns:o=\"http://docs.oasis-open.org/wss/2004/01/oasis-200401-wss-wssecurity-secext-1.0.xsd\"> \
-			<o:UsernameToken> \
-				<o:Username>[username]</o:Username> \
-				<o:Password>[password]</o:Password> \
-			</o:UsernameToken> \
-		</o:Security> \
-	</s:Header> \
-	<s:Body> \
-		<t:RequestSecurityToken xmlns:t=\"http://schemas.xmlsoap.org/ws/2005/02/trust\"> \
-			<wsp:AppliesTo xmlns:wsp=\"http://schemas.xmlsoap.org/ws/2004/09/policy\"> \
-				<a:EndpointReference> \
-					<a:Address>[endpoint]</a:Address> \
-				</a:EndpointReference> \
-			</wsp:AppliesTo> \
-			<t:KeyType>http://schemas.xmlsoap.org/ws/2005/05/identity/NoProofKey</t:KeyType> \
-			<t:RequestType>http://schemas.xmlsoap.org/ws/2005/02/trust/Issue</t:RequestType> \
-			<t:TokenType>urn:oasis:names:tc:SAML:1.0:assertion</t:TokenType> \
-		</t:RequestSecurityToken> \
-	</s:Body> \
-</s:Envelope> \
-";
\ No newline at end of file
+namespace {
+constexpr std::string_view envelope =
+	"<s:Envelope"
+	" xmlns:s=\"http://www.w3.org/2003/05/soap-envelope\""
+	" xmlns:a=\"http://www.w3.org/2005/08/addressing\""
+	" xmlns:u=\"http://docs.oasis-open.org/wss/2004/01/oasis-200401-wss-wssecurity-utility-1.0.xsd\">"
+	"<s:Header>"
+		"<a:Action s:mustUnderstand=\"1\">http://schemas.xmlsoap.org/ws/2005/02/trust/RST/Issue</a:Action>"
+		"<a:ReplyTo>"
+			"<a:Address>http://www.w3.org/2005/08/addressing/anonymous</a:Address>"
+		"</a:ReplyTo>"
+		"<a:To s:mustUnderstand=\"1\">https://login.microsoftonline.com/extSTS.srf</a:To>"
+		"<o:Security"
+			" s:mustUnderstand=\"1\""
+			" xmlns:o=\"http://docs.oasis-open.org/wss/2004/01/oasis-200401-wss-wssecurity-secext-1.0.xsd\">"
+			"<o:UsernameToken>"
+				"<o:Username>[username]</o:Username>"
+				"<o:Password>[password]</o:Password>"
+			"</o:UsernameToken>"
+		"</o:Security>"
+	"</s:Header>"
+	"<s:Body>"
+		"<t:RequestSecurityToken xmlns:t=\"http://schemas.xmlsoap.org/ws/2005/02/trust\">"
+			"<wsp:AppliesTo xmlns:wsp=\"http://schemas.xmlsoap.org/ws/2004/09/policy\">"
+				"<a:EndpointReference>"
+					"<a:Address>[endpoint]</a:Address>"
+				"</a:EndpointReference>"
+			"</wsp:AppliesTo>"
+			"<t:KeyType>http://schemas.xmlsoap.org/ws/2005/05/identity/NoProofKey</t:KeyType>"
+			"<t:RequestType>http://schemas.xmlsoap.org/ws/2005/02/trust/Issue</t:RequestType>"
+			"<t:TokenType>urn:oasis:names:tc:SAML:1.0:assertion</t:TokenType>"
+		"</t:RequestSecurityToken>"
+	"</s:Body>"
+	"</s:Envelope>";
+
+constexpr std::string_view usernameSlot = "[username]";
+constexpr std::string_view passwordSlot = "[password]";
+constexpr std::string_view endpointSlot = "[endpoint]";
+
+// the envelope is split at the placeholders at compile time
+constexpr size_t usernamePosition = envelope.find(usernameSlot);
+constexpr size_t passwordPosition = envelope.find(passwordSlot);
+constexpr size_t endpointPosition = envelope.find(endpointSlot);
+static_assert(usernamePosition < passwordPosition && passwordPosition < endpointPosition
+	&& endpointPosition != std::string_view::npos, "the placeholders have to be in this order");
+
+constexpr std::string_view segments[] = {
+	envelope.substr(0, usernamePosition),
+	envelope.substr(usernamePosition + usernameSlot.length(),
+		passwordPosition - usernamePosition - usernameSlot.length()),
+	envelope.substr(passwordPosition + passwordSlot.length(),
+		endpointPosition - passwordPosition - passwordSlot.length()),
+	envelope.substr(endpointPosition + endpointSlot.length())
+};
+constexpr size_t segmentsLength =
+	segments[0].length() + segments[1].length() + segments[2].length() + segments[3].length();
+
+// the characters which can't appear unescaped in element text
+const char *escapeSequence(char c)
+{
+	switch (c) {
+	case '&':
+		return "&amp;";
+	case '<':
+		return "&lt;";
+	case '>':
+		return "&gt;";
+	default:
+		return nullptr;
+	}
+}
+}
+
+const char *STSRequest::Value = envelope.data();
+
+std::string STSRequest::build(std::string_view username, std::string_view password, std::string_view endpoint)
+{
+	std::string request;
+	request.reserve(segmentsLength + escapedLength(username) + escapedLength(password) + escapedLength(endpoint));
+	request.append(segments[0]);
+	appendEscaped(request, username);
+	request.append(segments[1]);
+	appendEscaped(request, password);
+	request.append(segments[2]);
+	appendEscaped(request, endpoint);
+	request.append(segments[3]);
+	return request;
+}
+
+size_t STSRequest::escapedLength(std::string_view value)
+{
+	size_t length = value.length();
+	for (char c : value) {
+		if (const char *sequence = escapeSequence(c)) {
+			length += std::char_traits<char>::length(sequence) - 1;
+		}
+	}
+	return length;
+}
+
+void STSRequest::appendEscaped(std::string &output, std::string_view value)
+{
+	size_t runStart = 0;
+	for (size_t i = 0; i < value.length(); ++i) {
+		if (const char *sequence = escapeSequence(value[i])) {
+			output.append(value.data() + runStart, i - runStart);
+			output.append(sequence);
+			runStart = i + 1;
+		}
+	}
+	output.append(value.data() + runStart, value.length() - runStart);
+}
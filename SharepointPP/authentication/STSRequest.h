@@ -1,6 +1,17 @@
 #pragma once
+#include <string>
+#include <string_view>
+
 class STSRequest
 {
 public:
+	// the envelope with the [username], [password] and [endpoint] placeholders
 	static const char *Value;
-};
\ No newline at end of file
+
+	// fills the placeholders of the envelope with the xml escaped values
+	static std::string build(std::string_view username, std::string_view password, std::string_view endpoint);
+
+private:
+	static size_t escapedLength(std::string_view value);
+	static void appendEscaped(std::string &output, std::string_view value);
+};
@@ -0,0 +1,269 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "AsyncEngine.h"
+
+#include <curl/curl.h>
+
+#include <utility>
+
+#include "CurlTransport.h"
+#include "ResponseCache.h"
+#include "WebTransfer.h"
+
+using Microsoft::Sharepoint::AsyncEngine;
+using Microsoft::Sharepoint::CurlTransport;
+using Microsoft::Sharepoint::FailedWebRequestResponse;
+using Microsoft::Sharepoint::ResponseCache;
+using Microsoft::Sharepoint::Transport;
+using Microsoft::Sharepoint::WebResponse;
+using Microsoft::Sharepoint::WebTransfer;
+
+namespace {
+// curl_multi_wait() can't be woken up by another thread with this curl
+// version, so requests submitted from outside the engine thread wait at
+// most this long while other transfers are running
+const int maxWaitMilliseconds = 10;
+}
+
+struct AsyncEngine::Job
+{
+	std::unique_ptr<WebTransfer> transfer;
+	CompletionType completion;
+};
+
+struct AsyncEngine::Answer
+{
+	CompletionType completion;
+	WebResponse response;
+};
+
+AsyncEngine::AsyncEngine(long maxConnections) :
+	m_multiHandle(curl_multi_init()),
+	m_pending(0),
+	m_stopping(false)
+{
+	curl_multi_setopt(m_multiHandle, CURLMOPT_MAX_TOTAL_CONNECTIONS, maxConnections);
+	m_thread = std::thread(&AsyncEngine::run, this);
+}
+
+AsyncEngine::~AsyncEngine()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_wakeup.notify_all();
+	m_thread.join();
+	curl_multi_cleanup(m_multiHandle);
+}
+
+void AsyncEngine::post(const WebRequest &request, const Url &url, std::string data, CompletionType completion)
+{
+	std::shared_ptr<Transport> transport = request.transport();
+	if (dynamic_cast<CurlTransport *>(transport.get()) == nullptr) {
+		sendThrough(*transport, request, Transport::Method::Post, url, std::move(data), std::move(completion));
+		return;
+	}
+	submit(std::make_unique<WebTransfer>(request, WebTransfer::Method::Post, url, std::move(data)),
+		std::move(completion));
+}
+
+void AsyncEngine::get(const WebRequest &request, const Url &url, CompletionType completion)
+{
+	if (std::shared_ptr<ResponseCache> cache = request.responseCache()) {
+		// revalidates like WebRequest::get, the cache completes the response
+		WebRequest conditionalRequest(request);
+		conditionalRequest.setResponseCache(nullptr);
+		auto lookup = std::make_shared<ResponseCache::Lookup>(cache->prepare(url, conditionalRequest));
+		get(conditionalRequest, url, [cache, lookup, url, completion = std::move(completion)](WebResponse &&response) {
+			WebResponse completed = cache->complete(std::move(*lookup), url, std::move(response));
+			if (completion) {
+				completion(std::move(completed));
+			}
+		});
+		return;
+	}
+	std::shared_ptr<Transport> transport = request.transport();
+	if (dynamic_cast<CurlTransport *>(transport.get()) == nullptr) {
+		sendThrough(*transport, request, Transport::Method::Get, url, std::string(), std::move(completion));
+		return;
+	}
+	submit(std::make_unique<WebTransfer>(request, WebTransfer::Method::Get, url, std::string()),
+		std::move(completion));
+}
+
+std::future<WebResponse> AsyncEngine::post(const WebRequest &request, const Url &url, std::string data)
+{
+	auto promise = std::make_shared<std::promise<WebResponse>>();
+	std::future<WebResponse> future = promise->get_future();
+	post(request, url, std::move(data), [promise](WebResponse &&response) {
+		promise->set_value(std::move(response));
+	});
+	return future;
+}
+
+std::future<WebResponse> AsyncEngine::get(const WebRequest &request, const Url &url)
+{
+	auto promise = std::make_shared<std::promise<WebResponse>>();
+	std::future<WebResponse> future = promise->get_future();
+	get(request, url, [promise](WebResponse &&response) {
+		promise->set_value(std::move(response));
+	});
+	return future;
+}
+
+void AsyncEngine::wait()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_idle.wait(lock, [this]() { return m_pending == 0; });
+}
+
+size_t AsyncEngine::pending() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_pending;
+}
+
+void AsyncEngine::submit(std::unique_ptr<WebTransfer> &&transfer, CompletionType &&completion)
+{
+	std::unique_ptr<Job> job(new Job{std::move(transfer), std::move(completion)});
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_queued.push_back(std::move(job));
+		++m_pending;
+	}
+	m_wakeup.notify_one();
+}
+
+void AsyncEngine::sendThrough(Transport &transport, const WebRequest &request, Transport::Method method, const Url &url, std::string &&data, CompletionType &&completion)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		++m_pending;
+	}
+	transport.sendAsync(request, method, url, std::move(data),
+		[this, completion = std::move(completion)](WebResponse &&response) mutable {
+		// the completion runs on the engine thread like the ones of curl transfers
+		std::unique_ptr<Answer> answer(new Answer{std::move(completion), std::move(response)});
+		// notified under the lock, the engine may be gone right after it
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_answered.push_back(std::move(answer));
+		m_wakeup.notify_one();
+	});
+}
+
+void AsyncEngine::run()
+{
+	CURLM *multiHandle = static_cast<CURLM *>(m_multiHandle);
+	std::unique_lock<std::mutex> lock(m_mutex);
+	for (;;) {
+		if (m_queued.empty() && m_running.empty() && m_answered.empty()) {
+			// requests of other transports may still be on their way
+			if (m_stopping && m_pending == 0) {
+				break;
+			}
+			m_wakeup.wait(lock, [this]() {
+				return (m_stopping && m_pending == 0) || !m_queued.empty() || !m_answered.empty();
+			});
+			continue;
+		}
+		std::vector<std::unique_ptr<Job>> jobs;
+		jobs.swap(m_queued);
+		std::vector<std::unique_ptr<Answer>> answered;
+		answered.swap(m_answered);
+		lock.unlock();
+
+		start(std::move(jobs));
+		int runningHandles = 0;
+		curl_multi_perform(multiHandle, &runningHandles);
+		completeFinished();
+		for (auto &answer : answered) {
+			complete(std::move(answer->completion), std::move(answer->response));
+		}
+
+		lock.lock();
+		if (m_queued.empty() && !m_running.empty()) {
+			lock.unlock();
+			curl_multi_wait(multiHandle, nullptr, 0, maxWaitMilliseconds, nullptr);
+			lock.lock();
+		}
+	}
+}
+
+void AsyncEngine::start(std::vector<std::unique_ptr<Job>> &&jobs)
+{
+	CURLM *multiHandle = static_cast<CURLM *>(m_multiHandle);
+	for (auto &job : jobs) {
+		if (!job->transfer->isValid()) {
+			complete(std::move(job), FailedWebRequestResponse(-1));
+			continue;
+		}
+		CURL *handle = job->transfer->handle();
+		if (curl_multi_add_handle(multiHandle, handle) != CURLM_OK) {
+			complete(std::move(job), FailedWebRequestResponse(-2));
+			continue;
+		}
+		m_running.emplace(handle, std::move(job));
+	}
+}
+
+void AsyncEngine::completeFinished()
+{
+	CURLM *multiHandle = static_cast<CURLM *>(m_multiHandle);
+	int messagesLeft = 0;
+	while (CURLMsg *message = curl_multi_info_read(multiHandle, &messagesLeft)) {
+		if (message->msg != CURLMSG_DONE) {
+			continue;
+		}
+		CURL *handle = message->easy_handle;
+		CURLcode result = message->data.result;
+		curl_multi_remove_handle(multiHandle, handle);
+		auto running = m_running.find(handle);
+		if (running == m_running.end()) {
+			continue;
+		}
+		std::unique_ptr<Job> job = std::move(running->second);
+		m_running.erase(running);
+		WebResponse response = job->transfer->finish(result);
+		complete(std::move(job), std::move(response));
+	}
+}
+
+void AsyncEngine::complete(std::unique_ptr<Job> &&job, WebResponse &&response)
+{
+	// the transfer is released before the completion may submit new ones
+	CompletionType completion = std::move(job->completion);
+	job.reset();
+	complete(std::move(completion), std::move(response));
+}
+
+void AsyncEngine::complete(CompletionType &&completion, WebResponse &&response)
+{
+	if (completion) {
+		completion(std::move(response));
+	}
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (--m_pending == 0) {
+		m_idle.notify_all();
+	}
+}
@@ -0,0 +1,119 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef COMMON_ASYNCENGINE_H_
+#define COMMON_ASYNCENGINE_H_
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Transport.h"
+#include "Url.h"
+#include "WebRequest.h"
+#include "WebResponse.h"
+
+namespace Microsoft {
+namespace Sharepoint {
+class WebTransfer;
+
+// Runs many requests at once on one thread over a curl multi handle.
+// The completion of a request is called on the engine thread, it must
+// not block and must not call wait(), but it may submit further
+// requests, which start right away. The destructor lets all submitted
+// requests complete.
+// Requests with another transport than the CurlTransport are handed to
+// its sendAsync(), their completions are called on the engine thread as
+// well.
+class AsyncEngine
+{
+	// runs the asynchronous requests of transports stacked on curl
+	friend class CurlTransport;
+
+public:
+	typedef std::function<void(WebResponse &&response)> CompletionType;
+
+public:
+	__declspec(dllexport)
+		explicit AsyncEngine(long maxConnections = 64);
+	__declspec(dllexport)
+		~AsyncEngine();
+	AsyncEngine(const AsyncEngine &other) = delete;
+	AsyncEngine &operator=(const AsyncEngine &other) = delete;
+
+public:
+	__declspec(dllexport)
+		void post(const WebRequest &request, const Url &url, std::string data, CompletionType completion);
+	__declspec(dllexport)
+		void get(const WebRequest &request, const Url &url, CompletionType completion);
+	__declspec(dllexport)
+		std::future<WebResponse> post(const WebRequest &request, const Url &url, std::string data);
+	__declspec(dllexport)
+		std::future<WebResponse> get(const WebRequest &request, const Url &url);
+
+public:
+	// blocks until every submitted request has completed
+	__declspec(dllexport)
+		void wait();
+	// the requests submitted and not completed yet
+	__declspec(dllexport)
+		size_t pending() const;
+
+private:
+	struct Job;
+	struct Answer;
+
+private:
+	void submit(std::unique_ptr<WebTransfer> &&transfer, CompletionType &&completion);
+	void sendThrough(Transport &transport, const WebRequest &request, Transport::Method method, const Url &url, std::string &&data, CompletionType &&completion);
+	void run();
+	void start(std::vector<std::unique_ptr<Job>> &&jobs);
+	void completeFinished();
+	void complete(std::unique_ptr<Job> &&job, WebResponse &&response);
+	void complete(CompletionType &&completion, WebResponse &&response);
+
+private:
+	void *m_multiHandle;
+	mutable std::mutex m_mutex;
+	std::condition_variable m_wakeup;
+	std::condition_variable m_idle;
+	// submitted, not yet added to the multi handle
+	std::vector<std::unique_ptr<Job>> m_queued;
+	// only touched by the engine thread
+	std::unordered_map<void *, std::unique_ptr<Job>> m_running;
+	// answered by other transports, the completion not called yet
+	std::vector<std::unique_ptr<Answer>> m_answered;
+	size_t m_pending;
+	bool m_stopping;
+	std::thread m_thread;
+};
+}  // namespace Sharepoint
+}  // namespace Microsoft
+
+#endif  // COMMON_ASYNCENGINE_H_
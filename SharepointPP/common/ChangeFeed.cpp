@@ -0,0 +1,274 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "ChangeFeed.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <system_error>
+#include <utility>
+
+#include "WebResponse.h"
+#include "XmlDocumentPool.h"
+#include "XmlPath.h"
+
+using Microsoft::Sharepoint::ChangeFeed;
+using Microsoft::Sharepoint::WebResponse;
+using Microsoft::Sharepoint::XmlDocumentPool;
+using Microsoft::Sharepoint::XmlPath;
+
+namespace fs = std::filesystem;
+
+namespace {
+const XmlPath::NamespaceContainerType &feedNamespaces()
+{
+	static const XmlPath::NamespaceContainerType namespaces {
+		{"d", "http://schemas.microsoft.com/ado/2007/08/dataservices"},
+		{"m", "http://schemas.microsoft.com/ado/2007/08/dataservices/metadata"}
+	};
+	return namespaces;
+}
+
+void appendJsonString(std::string &json, const std::string &value)
+{
+	json += '"';
+	for (char c : value) {
+		if (c == '"' || c == '\\') {
+			json += '\\';
+		}
+		json += c;
+	}
+	json += '"';
+}
+
+std::string textOf(const XmlPath &path, const tinyxml2::XMLNode &node)
+{
+	const char *text = path.text(node);
+	return text != nullptr ? std::string(text) : std::string();
+}
+}  // namespace
+
+ChangeFeed::ChangeFeed(const WebRequest &request, const Url &scope, const fs::path &checkpointPath) :
+	m_request(request),
+	m_scope(scope.str()),
+	m_checkpointPath(checkpointPath),
+	m_pageSize(DefaultPageSize),
+	m_token(),
+	m_httpStatusCode(0)
+{
+	while (!m_scope.empty() && m_scope.back() == '/') {
+		m_scope.pop_back();
+	}
+	m_request.setContentType("application/json;odata=verbose");
+}
+
+ChangeFeed::~ChangeFeed()
+{
+}
+
+void ChangeFeed::setPageSize(size_t pageSize)
+{
+	m_pageSize = pageSize > 0 ? pageSize : DefaultPageSize;
+}
+
+bool ChangeFeed::loadCheckpoint()
+{
+	std::ifstream file(m_checkpointPath, std::ios::binary);
+	std::string token;
+	if (!file || !std::getline(file, token)) {
+		return false;
+	}
+	if (!token.empty() && token.back() == '\r') {
+		token.pop_back();
+	}
+	if (token.empty()) {
+		return false;
+	}
+	m_token = std::move(token);
+	return true;
+}
+
+bool ChangeFeed::startAtCurrentToken()
+{
+	WebResponse response = m_request.get(Url(m_scope + "/CurrentChangeToken"));
+	m_httpStatusCode = response.httpStatusCode();
+	if (m_httpStatusCode != 200) {
+		return false;
+	}
+	std::string token = parseChangeToken(response.takeResponse());
+	if (token.empty()) {
+		return false;
+	}
+	m_token = std::move(token);
+	return true;
+}
+
+void ChangeFeed::setToken(const std::string &token)
+{
+	m_token = token;
+}
+
+std::string ChangeFeed::token() const
+{
+	return m_token;
+}
+
+bool ChangeFeed::nextPage(std::vector<Change> &changes, std::string &pageToken)
+{
+	changes.clear();
+	pageToken = m_token;
+	WebResponse response = m_request.post(Url(m_scope + "/GetChanges"), changeQuery());
+	m_httpStatusCode = response.httpStatusCode();
+	if (m_httpStatusCode != 200) {
+		return false;
+	}
+	if (!parseChanges(response.takeResponse(), changes)) {
+		changes.clear();
+		return false;
+	}
+	if (!changes.empty() && !changes.back().token.empty()) {
+		pageToken = changes.back().token;
+	}
+	return true;
+}
+
+bool ChangeFeed::saveCheckpoint()
+{
+	fs::path temporaryPath(m_checkpointPath);
+	temporaryPath += ".tmp";
+	{
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		file << m_token << '\n';
+		file.close();
+		if (!file) {
+			std::error_code error;
+			fs::remove(temporaryPath, error);
+			return false;
+		}
+	}
+	// replaces the old checkpoint in one step
+	std::error_code error;
+	fs::rename(temporaryPath, m_checkpointPath, error);
+	if (error) {
+		fs::remove(temporaryPath, error);
+		return false;
+	}
+	return true;
+}
+
+bool ChangeFeed::follow(const HandlerType &handler)
+{
+	std::vector<Change> changes;
+	std::string pageToken;
+	for (;;) {
+		if (!nextPage(changes, pageToken)) {
+			return false;
+		}
+		if (changes.empty()) {
+			return true;
+		}
+		if (!handler(changes)) {
+			return false;
+		}
+		// the page counts as read only once the checkpoint holds it
+		m_token.swap(pageToken);
+		if (!saveCheckpoint()) {
+			m_token.swap(pageToken);
+			return false;
+		}
+	}
+}
+
+long ChangeFeed::httpStatusCode() const
+{
+	return m_httpStatusCode;
+}
+
+std::string ChangeFeed::changeQuery() const
+{
+	std::string query(
+		"{\"query\":{\"__metadata\":{\"type\":\"SP.ChangeQuery\"},"
+		"\"Item\":true,\"Add\":true,\"Update\":true,\"DeleteObject\":true,"
+		"\"Rename\":true,\"Restore\":true,\"MoveAway\":true,\"MoveInto\":true,"
+		"\"SystemUpdate\":true,\"FetchLimit\":");
+	query += std::to_string(m_pageSize);
+	if (!m_token.empty()) {
+		query += ",\"ChangeTokenStart\":{\"__metadata\":{\"type\":\"SP.ChangeToken\"},\"StringValue\":";
+		appendJsonString(query, m_token);
+		query += '}';
+	}
+	query += "}}";
+	return query;
+}
+
+bool ChangeFeed::parseChanges(std::string &&responseXml, std::vector<Change> &changes)
+{
+	static const XmlPath propertiesPath("content/m:properties", feedNamespaces());
+	static const XmlPath tokenPath("d:ChangeToken/d:StringValue", feedNamespaces());
+	static const XmlPath typePath("d:ChangeType", feedNamespaces());
+	static const XmlPath itemIdPath("d:ItemId", feedNamespaces());
+	static const XmlPath uniqueIdPath("d:UniqueId", feedNamespaces());
+	static const XmlPath listIdPath("d:ListId", feedNamespaces());
+	static const XmlPath timePath("d:Time", feedNamespaces());
+	XmlDocumentPool::DocumentLease doc(XmlDocumentPool::document());
+	// the document takes over the response body and parses it in place
+	if (doc->ParseInSitu(std::move(responseXml)) != tinyxml2::XML_SUCCESS) {
+		return false;
+	}
+	const tinyxml2::XMLElement *feed = doc->FirstChildElement("feed");
+	if (feed == nullptr) {
+		return false;
+	}
+	for (const tinyxml2::XMLElement *entry = feed->FirstChildElement("entry");
+		entry != nullptr;
+		entry = entry->NextSiblingElement("entry")) {
+		const tinyxml2::XMLElement *properties = propertiesPath.first(*entry);
+		if (properties == nullptr) {
+			continue;
+		}
+		Change change;
+		change.token = textOf(tokenPath, *properties);
+		const char *type = typePath.text(*properties);
+		if (type != nullptr) {
+			change.type = static_cast<ChangeType>(atoi(type));
+		}
+		const char *itemId = itemIdPath.text(*properties);
+		if (itemId != nullptr) {
+			change.itemId = atol(itemId);
+		}
+		change.uniqueId = textOf(uniqueIdPath, *properties);
+		change.listId = textOf(listIdPath, *properties);
+		change.time = textOf(timePath, *properties);
+		changes.push_back(std::move(change));
+	}
+	return true;
+}
+
+std::string ChangeFeed::parseChangeToken(std::string &&responseXml)
+{
+	static const XmlPath tokenPath("d:CurrentChangeToken/d:StringValue", feedNamespaces());
+	XmlDocumentPool::DocumentLease doc(XmlDocumentPool::document());
+	if (doc->ParseInSitu(std::move(responseXml)) != tinyxml2::XML_SUCCESS) {
+		return std::string();
+	}
+	return textOf(tokenPath, *doc);
+}
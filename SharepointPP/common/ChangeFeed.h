@@ -0,0 +1,160 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef COMMON_CHANGEFEED_H_
+#define COMMON_CHANGEFEED_H_
+
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Url.h"
+#include "WebRequest.h"
+
+namespace Microsoft {
+namespace Sharepoint {
+// Reads the item changes of a list, web or site from the change log of
+// sharepoint (GetChanges), a page at a time, e.g.
+//   ChangeFeed feed(auth.getPreparedRequest(),
+//       Url(endpoint + "/_api/web/lists/getbytitle('Documents')"), "documents.token");
+//   feed.loadCheckpoint() || feed.startAtCurrentToken();
+//   feed.follow([](const std::vector<ChangeFeed::Change> &changes) { ...; return true; });
+// The feed is positioned by a change token: every page starts after the
+// token of the last page accepted. nextPage() leaves the token alone, a
+// page is accepted by passing its token to setToken(); follow() does that
+// only after the handler took the page and the checkpoint was saved, so a
+// rejected page, like a crashed sync, is read again. The file is written to a temporary name and renamed, it always
+// holds a complete token.
+// Without a token the feed starts at the oldest change sharepoint keeps.
+class ChangeFeed
+{
+ public:
+	// SP.ChangeType
+	enum class ChangeType
+	{
+		NoChange = 0,
+		Add = 1,
+		Update = 2,
+		DeleteObject = 3,
+		Rename = 4,
+		MoveAway = 5,
+		MoveInto = 6,
+		Restore = 7,
+		RoleAdd = 8,
+		RoleDelete = 9,
+		RoleUpdate = 10,
+		AssignmentAdd = 11,
+		AssignmentDelete = 12,
+		MemberAdd = 13,
+		MemberDelete = 14,
+		SystemUpdate = 15,
+		Navigation = 16,
+		ScopeAdd = 17,
+		ScopeDelete = 18,
+		ListContentTypeAdd = 19,
+		ListContentTypeDelete = 20,
+		Dirty = 21,
+		Activity = 22
+	};
+
+	// a change of a list item (SP.ChangeItem)
+	struct Change
+	{
+		// the position of the change in the log
+		std::string token;
+		ChangeType type {ChangeType::NoChange};
+		long itemId {0};
+		std::string uniqueId;
+		std::string listId;
+		// utc, as sent by the server (2018-06-01T12:00:00Z)
+		std::string time;
+	};
+
+	// gets a page of changes, false stops follow() without saving the checkpoint
+	typedef std::function<bool(const std::vector<ChangeFeed::Change> &changes)> HandlerType;
+
+ public:
+	static constexpr size_t DefaultPageSize = 1000;
+
+ public:
+	// scope is the rest url of the list, web or site whose changes are read,
+	// the request has to carry the cookies and the request digest
+	__declspec(dllexport)
+		ChangeFeed(const WebRequest &request, const Url &scope, const std::filesystem::path &checkpointPath);
+	__declspec(dllexport)
+		~ChangeFeed();
+
+ public:
+	// the most changes a page holds (FetchLimit)
+	__declspec(dllexport)
+		void setPageSize(size_t pageSize);
+	// continues after the token of the checkpoint file,
+	// false if there is none or it can't be read
+	__declspec(dllexport)
+		bool loadCheckpoint();
+	// skips every change made so far (CurrentChangeToken of the scope)
+	__declspec(dllexport)
+		bool startAtCurrentToken();
+	// continues after the token, an empty one starts at the oldest change
+	__declspec(dllexport)
+		void setToken(const std::string &token);
+	// the token the next page starts after, the one of the last page accepted
+	__declspec(dllexport)
+		std::string token() const;
+
+ public:
+	// the changes after the token and the token of the last of them,
+	// empty once the feed has caught up, false if the request failed;
+	// the feed moves on only once setToken(pageToken) accepts the page
+	__declspec(dllexport)
+		bool nextPage(std::vector<ChangeFeed::Change> &changes, std::string &pageToken);
+	// writes the token atomically to the checkpoint file
+	__declspec(dllexport)
+		bool saveCheckpoint();
+	// hands every page to the handler and saves the checkpoint after it,
+	// until the feed has caught up, false if a request, the handler or
+	// the checkpoint failed, the token then stays before the failed page
+	__declspec(dllexport)
+		bool follow(const ChangeFeed::HandlerType &handler);
+	// the status code of the last request, negative if it never got an answer
+	__declspec(dllexport)
+		long httpStatusCode() const;
+
+ private:
+	std::string changeQuery() const;
+	static bool parseChanges(std::string &&responseXml, std::vector<ChangeFeed::Change> &changes);
+	static std::string parseChangeToken(std::string &&responseXml);
+
+ private:
+	WebRequest m_request;
+	std::string m_scope;
+	std::filesystem::path m_checkpointPath;
+	size_t m_pageSize;
+	std::string m_token;
+	long m_httpStatusCode;
+};
+}  // namespace Sharepoint
+}  // namespace Microsoft
+
+#endif  // COMMON_CHANGEFEED_H_
@@ -0,0 +1,81 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "CompletionTimer.h"
+
+#include <utility>
+
+using Microsoft::Sharepoint::CompletionTimer;
+
+CompletionTimer::CompletionTimer() :
+	m_stopping(false)
+{
+	m_thread = std::thread(&CompletionTimer::run, this);
+}
+
+CompletionTimer::~CompletionTimer()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_wakeup.notify_all();
+	m_thread.join();
+}
+
+void CompletionTimer::schedule(std::chrono::microseconds delay, Transport::CompletionType &&completion, WebResponse &&response)
+{
+	std::unique_ptr<Scheduled> scheduled(new Scheduled{std::move(completion), std::move(response)});
+	std::chrono::steady_clock::time_point due = std::chrono::steady_clock::now() + delay;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_scheduled.emplace(due, std::move(scheduled));
+	}
+	m_wakeup.notify_all();
+}
+
+void CompletionTimer::run()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	for (;;) {
+		if (m_scheduled.empty()) {
+			if (m_stopping) {
+				break;
+			}
+			m_wakeup.wait(lock, [this]() { return m_stopping || !m_scheduled.empty(); });
+			continue;
+		}
+		ScheduleType::iterator first = m_scheduled.begin();
+		if (first->first > std::chrono::steady_clock::now()) {
+			m_wakeup.wait_until(lock, first->first);
+			continue;
+		}
+		std::unique_ptr<Scheduled> due = std::move(first->second);
+		m_scheduled.erase(first);
+		lock.unlock();
+		if (due->completion) {
+			due->completion(std::move(due->response));
+		}
+		due.reset();
+		lock.lock();
+	}
+}
@@ -0,0 +1,76 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef COMMON_COMPLETIONTIMER_H_
+#define COMMON_COMPLETIONTIMER_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "Transport.h"
+#include "WebResponse.h"
+
+namespace Microsoft {
+namespace Sharepoint {
+// Calls completions with their response once a delay has passed, all on
+// one thread of the timer. Transports which answer requests themselves
+// use it to simulate the latency of asynchronous requests without
+// blocking the caller. The destructor calls the completions still
+// waiting once they are due.
+class CompletionTimer
+{
+ public:
+	CompletionTimer();
+	~CompletionTimer();
+	CompletionTimer(const CompletionTimer &other) = delete;
+	CompletionTimer &operator=(const CompletionTimer &other) = delete;
+
+ public:
+	void schedule(std::chrono::microseconds delay, Transport::CompletionType &&completion, WebResponse &&response);
+
+ private:
+	struct Scheduled
+	{
+		Transport::CompletionType completion;
+		WebResponse response;
+	};
+	typedef std::multimap<std::chrono::steady_clock::time_point, std::unique_ptr<Scheduled>> ScheduleType;
+
+ private:
+	void run();
+
+ private:
+	std::mutex m_mutex;
+	std::condition_variable m_wakeup;
+	ScheduleType m_scheduled;
+	bool m_stopping;
+	std::thread m_thread;
+};
+}  // namespace Sharepoint
+}  // namespace Microsoft
+
+#endif  // COMMON_COMPLETIONTIMER_H_
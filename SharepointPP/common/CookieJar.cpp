@@ -0,0 +1,288 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "CookieJar.h"
+
+#include <curl/curl.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ConversionUtils.h"
+#include "TimeUtils.h"
+#include "Url.h"
+
+using Microsoft::Sharepoint::CookieJar;
+
+namespace {
+std::string lowerDomain(std::string_view domain)
+{
+	if (domain.length() > 0 && domain[0] == '.') {
+		domain.remove_prefix(1);
+	}
+	std::string output(domain);
+	std::transform(output.begin(), output.end(), output.begin(), [](char c) {
+		return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+	});
+	return output;
+}
+
+// splits the next tab separated field off the line
+std::string_view nextField(std::string_view &line)
+{
+	size_t pos = line.find('\t');
+	std::string_view field(line.substr(0, pos));
+	line.remove_prefix(pos == std::string_view::npos ? line.length() : pos + 1);
+	return field;
+}
+}  // namespace
+
+CookieJar::CookieJar() :
+	m_domains(),
+	m_shareHandle(curl_share_init())
+{
+	static_assert(CURL_LOCK_DATA_LAST <= 8, "not enough share locks");
+	curl_lock_function lockFunction = [](
+		CURL *, curl_lock_data data, curl_lock_access, void *userp) {
+		static_cast<CookieJar *>(userp)->m_shareLocks[data].lock();
+	};
+	curl_unlock_function unlockFunction = [](
+		CURL *, curl_lock_data data, void *userp) {
+		static_cast<CookieJar *>(userp)->m_shareLocks[data].unlock();
+	};
+	if (m_shareHandle != nullptr) {
+		curl_share_setopt(m_shareHandle, CURLSHOPT_LOCKFUNC, lockFunction);
+		curl_share_setopt(m_shareHandle, CURLSHOPT_UNLOCKFUNC, unlockFunction);
+		curl_share_setopt(m_shareHandle, CURLSHOPT_USERDATA, this);
+		curl_share_setopt(m_shareHandle, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+		curl_share_setopt(m_shareHandle, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+		curl_share_setopt(m_shareHandle, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+	}
+}
+
+CookieJar::~CookieJar()
+{
+	if (m_shareHandle != nullptr) {
+		curl_share_cleanup(m_shareHandle);
+	}
+}
+
+void CookieJar::add(Cookie &&cookie)
+{
+	std::string domain(lowerDomain(cookie.domain));
+	cookie.domain = domain;
+	if (cookie.path.length() == 0) {
+		cookie.path = "/";
+	}
+	long long now = TimeUtils::getCurrentTime();
+	std::unique_lock<std::shared_mutex> lock(m_mutex);
+	std::vector<Cookie> &bucket = m_domains[domain];
+	bucket.erase(
+		std::remove_if(bucket.begin(), bucket.end(), [&](const Cookie &existing) {
+			return isExpired(existing, now) ||
+				(existing.name == cookie.name && existing.path == cookie.path);
+		}),
+		bucket.end());
+	if (!isExpired(cookie, now)) {
+		// keep the bucket ordered by path length, longer paths are sent first
+		auto position = std::find_if(bucket.begin(), bucket.end(), [&](const Cookie &existing) {
+			return existing.path.length() < cookie.path.length();
+		});
+		bucket.insert(position, std::move(cookie));
+	}
+	if (bucket.empty()) {
+		m_domains.erase(domain);
+	}
+}
+
+size_t CookieJar::pruneExpired()
+{
+	long long now = TimeUtils::getCurrentTime();
+	size_t removed = 0;
+	std::unique_lock<std::shared_mutex> lock(m_mutex);
+	for (auto it = m_domains.begin(); it != m_domains.end();) {
+		std::vector<Cookie> &bucket = it->second;
+		size_t before = bucket.size();
+		bucket.erase(
+			std::remove_if(bucket.begin(), bucket.end(), [now](const Cookie &cookie) {
+				return isExpired(cookie, now);
+			}),
+			bucket.end());
+		removed += before - bucket.size();
+		it = bucket.empty() ? m_domains.erase(it) : std::next(it);
+	}
+	return removed;
+}
+
+void CookieJar::clear()
+{
+	std::unique_lock<std::shared_mutex> lock(m_mutex);
+	m_domains.clear();
+}
+
+std::string CookieJar::cookieHeader(const Url &url) const
+{
+	return cookieHeader(url.protocolPrefix(), url.host(), url.resource());
+}
+
+std::string CookieJar::cookieHeader(
+	std::string_view protocolPrefix,
+	std::string_view host,
+	std::string_view path) const
+{
+	std::string output;
+	// the authority may contain user info and a port
+	size_t userInfoEnd = host.find('@');
+	if (userInfoEnd != std::string_view::npos) {
+		host.remove_prefix(userInfoEnd + 1);
+	}
+	size_t portSeparator = host.rfind(':');
+	if (portSeparator != std::string_view::npos &&
+		host.find(']', portSeparator) == std::string_view::npos) {
+		host = host.substr(0, portSeparator);
+	}
+	std::string requestHost(lowerDomain(host));
+	bool secureRequest = protocolPrefix.substr(0, 6) == "https:";
+	if (path.length() == 0) {
+		path = "/";
+	}
+	long long now = TimeUtils::getCurrentTime();
+	std::shared_lock<std::shared_mutex> lock(m_mutex);
+	// walk from the full host name up to the top level domain,
+	// cookies of parent domains only match if they allow subdomains
+	std::string_view domain(requestHost);
+	bool exactHost = true;
+	while (domain.length() > 0) {
+		auto it = m_domains.find(domain);
+		if (it != m_domains.end()) {
+			for (const Cookie &cookie : it->second) {
+				if ((exactHost || cookie.includeSubdomains) &&
+					(secureRequest || !cookie.secure) &&
+					!isExpired(cookie, now) &&
+					pathMatches(path, cookie.path)) {
+					if (output.length() > 0) {
+						output += "; ";
+					}
+					output += cookie.name;
+					output += '=';
+					output += cookie.value;
+				}
+			}
+		}
+		size_t dot = domain.find('.');
+		if (dot == std::string_view::npos) {
+			break;
+		}
+		domain.remove_prefix(dot + 1);
+		exactHost = false;
+	}
+	return output;
+}
+
+std::vector<CookieJar::Cookie> CookieJar::cookies() const
+{
+	std::vector<Cookie> output;
+	std::shared_lock<std::shared_mutex> lock(m_mutex);
+	for (const auto &bucket : m_domains) {
+		output.insert(output.end(), bucket.second.begin(), bucket.second.end());
+	}
+	return output;
+}
+
+CookieJar::CookieContainerType CookieJar::nameValuePairs() const
+{
+	CookieContainerType output;
+	std::shared_lock<std::shared_mutex> lock(m_mutex);
+	for (const auto &bucket : m_domains) {
+		for (const Cookie &cookie : bucket.second) {
+			output.push_back(
+				std::pair<std::string, std::string>(cookie.name, cookie.value));
+		}
+	}
+	return output;
+}
+
+size_t CookieJar::size() const
+{
+	size_t count = 0;
+	std::shared_lock<std::shared_mutex> lock(m_mutex);
+	for (const auto &bucket : m_domains) {
+		count += bucket.second.size();
+	}
+	return count;
+}
+
+void *CookieJar::shareHandle() const
+{
+	return m_shareHandle;
+}
+
+bool CookieJar::parseNetscapeCookie(const char *line, Cookie &cookie)
+{
+	if (line == nullptr) {
+		return false;
+	}
+	std::string_view rest(line, strlen(line));
+	cookie = Cookie();
+	std::string_view domain(nextField(rest));
+	constexpr std::string_view httpOnlyPrefix("#HttpOnly_");
+	if (domain.substr(0, httpOnlyPrefix.length()) == httpOnlyPrefix) {
+		cookie.httpOnly = true;
+		domain.remove_prefix(httpOnlyPrefix.length());
+	}
+	std::string_view tailMatch(nextField(rest));
+	std::string_view path(nextField(rest));
+	std::string_view secure(nextField(rest));
+	std::string_view expires(nextField(rest));
+	std::string_view name(nextField(rest));
+	if (domain.length() == 0 || name.length() == 0) {
+		return false;
+	}
+	cookie.domain = std::string(domain);
+	cookie.includeSubdomains = tailMatch == "TRUE";
+	cookie.path = std::string(path);
+	cookie.secure = secure == "TRUE";
+	cookie.expires = static_cast<long long>(
+		ConversionUtils::stringToSize_T(std::string(expires)));
+	cookie.name = std::string(name);
+	cookie.value = std::string(nextField(rest));
+	return true;
+}
+
+bool CookieJar::pathMatches(std::string_view requestPath, std::string_view cookiePath)
+{
+	// RFC 6265 5.1.4
+	if (requestPath.substr(0, cookiePath.length()) != cookiePath) {
+		return false;
+	}
+	return requestPath.length() == cookiePath.length() ||
+		cookiePath[cookiePath.length() - 1] == '/' ||
+		requestPath[cookiePath.length()] == '/';
+}
+
+bool CookieJar::isExpired(const Cookie &cookie, long long now)
+{
+	return cookie.expires > 0 && cookie.expires <= now;
+}
@@ -0,0 +1,120 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef COMMON_COOKIEJAR_H_
+#define COMMON_COOKIEJAR_H_
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+
+class Url;
+
+namespace Microsoft {
+namespace Sharepoint {
+// Cookie store shared by all requests of one session.
+// Cookies are indexed by their domain, so a request only looks at the
+// buckets of its own host and its parent domains. Expired cookies are
+// skipped when matching and dropped on the next write.
+// The jar also owns a curl share handle, so all handles using the same
+// jar share their dns cache, tls sessions and connections.
+class CookieJar
+{
+ public:
+	struct Cookie
+	{
+		std::string name;
+		std::string value;
+		std::string domain;
+		std::string path {"/"};
+		// unix timestamp, 0 for session cookies
+		long long expires {0};
+		bool includeSubdomains {false};
+		bool secure {false};
+		bool httpOnly {false};
+	};
+	typedef std::vector<std::pair<std::string, std::string>> CookieContainerType;
+
+ public:
+	__declspec(dllexport)
+		CookieJar();
+	__declspec(dllexport)
+		~CookieJar();
+	CookieJar(const CookieJar &other) = delete;
+	CookieJar &operator=(const CookieJar &other) = delete;
+
+ public:
+	// adds the cookie or replaces the one with the same name, domain and path
+	__declspec(dllexport)
+		void add(Cookie &&cookie);
+	__declspec(dllexport)
+		size_t pruneExpired();
+	__declspec(dllexport)
+		void clear();
+
+ public:
+	// returns the value for the Cookie header of a request to the url,
+	// in the form "name1=value1; name2=value2"
+	__declspec(dllexport)
+		std::string cookieHeader(const Url &url) const;
+	__declspec(dllexport)
+		std::string cookieHeader(
+			std::string_view protocolPrefix,
+			std::string_view host,
+			std::string_view path) const;
+	__declspec(dllexport)
+		std::vector<CookieJar::Cookie> cookies() const;
+	__declspec(dllexport)
+		CookieJar::CookieContainerType nameValuePairs() const;
+	__declspec(dllexport)
+		size_t size() const;
+	// the CURLSH handle to set as CURLOPT_SHARE
+	__declspec(dllexport)
+		void *shareHandle() const;
+
+ public:
+	// parses one line of curl's cookie list (netscape cookie file format),
+	// returns false if the line is malformed
+	__declspec(dllexport)
+		static bool parseNetscapeCookie(const char *line, CookieJar::Cookie &cookie);
+
+ private:
+	static bool pathMatches(std::string_view requestPath, std::string_view cookiePath);
+	static bool isExpired(const Cookie &cookie, long long now);
+
+ private:
+	typedef std::map<std::string, std::vector<Cookie>, std::less<>> DomainIndexType;
+	DomainIndexType m_domains;
+	mutable std::shared_mutex m_mutex;
+	void *m_shareHandle;
+	// one lock per curl_lock_data value
+	std::mutex m_shareLocks[8];
+};
+}  // namespace Sharepoint
+}  // namespace Microsoft
+
+#endif  // COMMON_COOKIEJAR_H_
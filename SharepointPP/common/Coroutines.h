@@ -0,0 +1,526 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef COMMON_COROUTINES_H_
+#define COMMON_COROUTINES_H_
+
+// The library itself builds as C++17, the coroutine types are only there
+// for code compiled as C++20 (/std:c++20) which includes this header.
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+#include <coroutine>
+#include <exception>
+#include <future>
+#include <memory>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "AsyncEngine.h"
+#include "Url.h"
+#include "WebRequest.h"
+#include "WebResponse.h"
+#include "XmlDocumentPool.h"
+#include "tinyxml2.h"
+
+// Coroutines over the AsyncEngine, e.g.
+//   Task<size_t> countItems(const AsyncClient &client, const std::string &list)
+//   {
+//       size_t count = 0;
+//       auto items = client.entries(Url(list + "/items"));
+//       while (co_await items.next() != nullptr) {
+//           ++count;
+//       }
+//       co_return count;
+//   }
+//   AsyncEngine engine;
+//   AsyncClient client(engine, auth.getPreparedRequest());
+//   size_t count = syncWait(countItems(client, list));
+// A coroutine waiting for a response holds no thread, only its frame,
+// a few hundred bytes with the response it waits for. The engine resumes
+// it on its thread once the response is there, so like a completion it
+// must not block there; it may await the next request right away.
+// A Task starts when it is awaited; syncWait() waits for one from a
+// thread outside the engine and detach() starts one nobody waits for.
+namespace Microsoft {
+namespace Sharepoint {
+// what the promises of all tasks share: the coroutine awaiting the task
+// goes on where the task is done
+class TaskPromiseBase
+{
+ public:
+	struct FinalAwaiter
+	{
+		bool await_ready() const noexcept
+		{
+			return false;
+		}
+		template<class PromiseType>
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<PromiseType> handle) noexcept
+		{
+			// a transfer instead of a nested resume, long chains of tasks
+			// finishing at once don't grow the stack
+			std::coroutine_handle<> continuation = handle.promise().continuation();
+			return continuation ? continuation : std::noop_coroutine();
+		}
+		void await_resume() noexcept
+		{
+		}
+	};
+
+ public:
+	std::suspend_always initial_suspend() noexcept
+	{
+		return {};
+	}
+	FinalAwaiter final_suspend() noexcept
+	{
+		return {};
+	}
+	// the library doesn't throw, an exception leaving a task is a bug
+	void unhandled_exception() noexcept
+	{
+		std::terminate();
+	}
+	void setContinuation(std::coroutine_handle<> continuation) noexcept
+	{
+		m_continuation = continuation;
+	}
+	std::coroutine_handle<> continuation() const noexcept
+	{
+		return m_continuation;
+	}
+
+ private:
+	std::coroutine_handle<> m_continuation;
+};
+
+template<class T>
+class TaskPromise : public TaskPromiseBase
+{
+ public:
+	void return_value(T value)
+	{
+		m_value.emplace(std::move(value));
+	}
+	T takeValue()
+	{
+		return std::move(*m_value);
+	}
+
+ private:
+	std::optional<T> m_value;
+};
+
+template<>
+class TaskPromise<void> : public TaskPromiseBase
+{
+ public:
+	void return_void() noexcept
+	{
+	}
+	void takeValue() noexcept
+	{
+	}
+};
+
+// a coroutine returning T to the coroutine awaiting it, it owns its frame
+template<class T = void>
+class Task
+{
+ public:
+	struct promise_type : public TaskPromise<T>
+	{
+		Task get_return_object() noexcept
+		{
+			return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+		}
+	};
+
+	struct Awaiter
+	{
+		std::coroutine_handle<promise_type> handle;
+
+		bool await_ready() const noexcept
+		{
+			return !handle || handle.done();
+		}
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+		{
+			handle.promise().setContinuation(awaiting);
+			return handle;
+		}
+		T await_resume()
+		{
+			return handle.promise().takeValue();
+		}
+	};
+
+ public:
+	Task(Task &&other) noexcept :
+		m_handle(std::exchange(other.m_handle, nullptr))
+	{
+	}
+	Task &operator=(Task &&other) noexcept
+	{
+		if (this != &other) {
+			if (m_handle) {
+				m_handle.destroy();
+			}
+			m_handle = std::exchange(other.m_handle, nullptr);
+		}
+		return *this;
+	}
+	~Task()
+	{
+		if (m_handle) {
+			m_handle.destroy();
+		}
+	}
+	Task(const Task &other) = delete;
+	Task &operator=(const Task &other) = delete;
+
+ public:
+	// starts the task, a task can be awaited once
+	Awaiter operator co_await() const noexcept
+	{
+		return Awaiter {m_handle};
+	}
+
+ private:
+	explicit Task(std::coroutine_handle<promise_type> handle) noexcept :
+		m_handle(handle)
+	{
+	}
+
+ private:
+	std::coroutine_handle<promise_type> m_handle;
+};
+
+// a coroutine nobody awaits, its frame is freed when it is done
+struct DetachedTask
+{
+	struct promise_type
+	{
+		DetachedTask get_return_object() noexcept
+		{
+			return {};
+		}
+		std::suspend_never initial_suspend() noexcept
+		{
+			return {};
+		}
+		std::suspend_never final_suspend() noexcept
+		{
+			return {};
+		}
+		void return_void() noexcept
+		{
+		}
+		void unhandled_exception() noexcept
+		{
+			std::terminate();
+		}
+	};
+};
+
+// runs the task until its first wait and lets it go on by itself
+inline DetachedTask detach(Task<void> task)
+{
+	co_await task;
+}
+
+// the frame owns the promise, it is still there while set_value() runs
+template<class T>
+DetachedTask fulfil(Task<T> task, std::promise<T> result)
+{
+	if constexpr (std::is_void_v<T>) {
+		co_await task;
+		result.set_value();
+	} else {
+		result.set_value(co_await task);
+	}
+}
+
+// runs the task and blocks the calling thread until it is done, not to
+// be called on the engine thread
+template<class T>
+T syncWait(Task<T> task)
+{
+	std::promise<T> result;
+	std::future<T> future = result.get_future();
+	fulfil(std::move(task), std::move(result));
+	return future.get();
+}
+
+// A coroutine handing out values one at a time while it goes on waiting
+// for responses, e.g. the entries of a paged listing:
+//   while (const T *value = co_await generator.next()) { ... }
+// A value stays valid until next() is awaited again.
+template<class T>
+class AsyncGenerator
+{
+ public:
+	struct promise_type
+	{
+		struct YieldAwaiter
+		{
+			bool await_ready() const noexcept
+			{
+				return false;
+			}
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+			{
+				return handle.promise().consumer;
+			}
+			void await_resume() noexcept
+			{
+			}
+		};
+
+		T *current {nullptr};
+		// the coroutine waiting in next()
+		std::coroutine_handle<> consumer;
+
+		AsyncGenerator get_return_object() noexcept
+		{
+			return AsyncGenerator(std::coroutine_handle<promise_type>::from_promise(*this));
+		}
+		std::suspend_always initial_suspend() noexcept
+		{
+			return {};
+		}
+		YieldAwaiter final_suspend() noexcept
+		{
+			return {};
+		}
+		YieldAwaiter yield_value(T &value) noexcept
+		{
+			current = std::addressof(value);
+			return {};
+		}
+		YieldAwaiter yield_value(T &&value) noexcept
+		{
+			current = std::addressof(value);
+			return {};
+		}
+		void return_void() noexcept
+		{
+			current = nullptr;
+		}
+		void unhandled_exception() noexcept
+		{
+			std::terminate();
+		}
+	};
+
+	struct NextAwaiter
+	{
+		std::coroutine_handle<promise_type> handle;
+
+		bool await_ready() const noexcept
+		{
+			return !handle || handle.done();
+		}
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<> consumer) noexcept
+		{
+			handle.promise().consumer = consumer;
+			return handle;
+		}
+		// nullptr once the generator is done
+		T *await_resume() const noexcept
+		{
+			return handle && !handle.done() ? handle.promise().current : nullptr;
+		}
+	};
+
+ public:
+	AsyncGenerator(AsyncGenerator &&other) noexcept :
+		m_handle(std::exchange(other.m_handle, nullptr))
+	{
+	}
+	AsyncGenerator &operator=(AsyncGenerator &&other) noexcept
+	{
+		if (this != &other) {
+			if (m_handle) {
+				m_handle.destroy();
+			}
+			m_handle = std::exchange(other.m_handle, nullptr);
+		}
+		return *this;
+	}
+	~AsyncGenerator()
+	{
+		if (m_handle) {
+			m_handle.destroy();
+		}
+	}
+	AsyncGenerator(const AsyncGenerator &other) = delete;
+	AsyncGenerator &operator=(const AsyncGenerator &other) = delete;
+
+ public:
+	NextAwaiter next() const noexcept
+	{
+		return NextAwaiter {m_handle};
+	}
+
+ private:
+	explicit AsyncGenerator(std::coroutine_handle<promise_type> handle) noexcept :
+		m_handle(handle)
+	{
+	}
+
+ private:
+	std::coroutine_handle<promise_type> m_handle;
+};
+
+// Sends the requests of coroutines through an AsyncEngine with the
+// headers and cookies of one request. The client and its engine have
+// to outlive the coroutines using it.
+class AsyncClient
+{
+ public:
+	// awaits the response of one request
+	class Request
+	{
+	 public:
+		Request(AsyncEngine &engine, const WebRequest &request, bool post, const Url &url, std::string &&data) :
+			m_engine(&engine),
+			m_request(&request),
+			m_post(post),
+			m_url(url),
+			m_data(std::move(data))
+		{
+		}
+
+	 public:
+		bool await_ready() const noexcept
+		{
+			return false;
+		}
+		void await_suspend(std::coroutine_handle<> awaiting)
+		{
+			// the response may resume the coroutine on the engine thread
+			// before the request is submitted completely, nothing of the
+			// frame is touched from the moment it is handed over
+			AsyncEngine &engine = *m_engine;
+			const WebRequest &request = *m_request;
+			Url url(std::move(m_url));
+			WebResponse *response = &m_response;
+			AsyncEngine::CompletionType completion = [response, awaiting](WebResponse &&answer) {
+				*response = std::move(answer);
+				awaiting.resume();
+			};
+			if (m_post) {
+				engine.post(request, url, std::move(m_data), std::move(completion));
+			} else {
+				engine.get(request, url, std::move(completion));
+			}
+		}
+		WebResponse await_resume() noexcept
+		{
+			return std::move(m_response);
+		}
+
+	 private:
+		AsyncEngine *m_engine;
+		const WebRequest *m_request;
+		bool m_post;
+		Url m_url;
+		std::string m_data;
+		WebResponse m_response;
+	};
+
+ public:
+	AsyncClient(AsyncEngine &engine, const WebRequest &request) :
+		m_engine(engine),
+		m_request(request)
+	{
+	}
+	AsyncClient(const AsyncClient &other) = delete;
+	AsyncClient &operator=(const AsyncClient &other) = delete;
+
+ public:
+	Request get(const Url &url) const
+	{
+		return Request(m_engine, m_request, false, url, std::string());
+	}
+	Request post(const Url &url, std::string data) const
+	{
+		return Request(m_engine, m_request, true, url, std::move(data));
+	}
+	// the entries of an atom feed and of the pages its next links lead to,
+	// a page is requested when the entries of the one before are used up;
+	// the status code of the page which ended the listing goes to
+	// httpStatusCode, 200 if every page was read and -1 if a page isn't a
+	// feed
+	AsyncGenerator<const tinyxml2::XMLElement> entries(Url url, long *httpStatusCode = nullptr) const
+	{
+		std::string next = url.str();
+		long statusCode = 200;
+		while (!next.empty()) {
+			WebResponse response = co_await get(Url(next));
+			statusCode = response.httpStatusCode();
+			if (statusCode != 200) {
+				break;
+			}
+			next.clear();
+			XmlDocumentPool::DocumentLease doc(XmlDocumentPool::document());
+			// the document takes over the response body and parses it in place
+			const tinyxml2::XMLElement *feed = nullptr;
+			if (doc->ParseInSitu(response.takeResponse()) == tinyxml2::XML_SUCCESS) {
+				feed = doc->FirstChildElement("feed");
+			}
+			if (feed == nullptr) {
+				statusCode = -1;
+				break;
+			}
+			for (const tinyxml2::XMLElement *link = feed->FirstChildElement("link");
+				link != nullptr;
+				link = link->NextSiblingElement("link")) {
+				if (link->Attribute("rel", "next") && link->Attribute("href") != nullptr) {
+					next = link->Attribute("href");
+				}
+			}
+			for (const tinyxml2::XMLElement *entry = feed->FirstChildElement("entry");
+				entry != nullptr;
+				entry = entry->NextSiblingElement("entry")) {
+				co_yield *entry;
+			}
+		}
+		if (httpStatusCode != nullptr) {
+			*httpStatusCode = statusCode;
+		}
+	}
+
+ private:
+	AsyncEngine &m_engine;
+	WebRequest m_request;
+};
+}  // namespace Sharepoint
+}  // namespace Microsoft
+
+#endif  // defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+#endif  // COMMON_COROUTINES_H_
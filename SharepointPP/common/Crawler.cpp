@@ -0,0 +1,538 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "Crawler.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#include "ODataQuery.h"
+#include "PercentEncoding.h"
+#include "RequestMetrics.h"
+#include "WebResponse.h"
+#include "XmlDocumentPool.h"
+#include "XmlPath.h"
+
+using Microsoft::Sharepoint::AsyncEngine;
+using Microsoft::Sharepoint::Crawler;
+using Microsoft::Sharepoint::PercentEncoding;
+using Microsoft::Sharepoint::RequestMetrics;
+using Microsoft::Sharepoint::WebResponse;
+using Microsoft::Sharepoint::XmlDocumentPool;
+using Microsoft::Sharepoint::XmlPath;
+
+namespace {
+const XmlPath::NamespaceContainerType &feedNamespaces()
+{
+	static const XmlPath::NamespaceContainerType namespaces {
+		{"d", "http://schemas.microsoft.com/ado/2007/08/dataservices"},
+		{"m", "http://schemas.microsoft.com/ado/2007/08/dataservices/metadata"}
+	};
+	return namespaces;
+}
+
+std::string textOf(const XmlPath &path, const tinyxml2::XMLNode &node)
+{
+	const char *text = path.text(node);
+	return text != nullptr ? std::string(text) : std::string();
+}
+
+bool isThrottled(long httpStatusCode)
+{
+	return httpStatusCode == 429 || httpStatusCode == 503;
+}
+
+// -1 without a Retry-After in seconds (sharepoint doesn't send the date form)
+std::chrono::seconds retryAfterOf(const WebResponse &response)
+{
+	static const char name[] = "retry-after";
+	for (auto &header : response.header()) {
+		if (header.first.length() != sizeof(name) - 1) {
+			continue;
+		}
+		bool matches = true;
+		for (size_t i = 0; matches && i < header.first.length(); ++i) {
+			matches = tolower(static_cast<unsigned char>(header.first[i])) == name[i];
+		}
+		if (matches && !header.second.empty() && isdigit(static_cast<unsigned char>(header.second[0]))) {
+			return std::chrono::seconds(strtol(header.second.c_str(), nullptr, 10));
+		}
+	}
+	return std::chrono::seconds(-1);
+}
+}  // namespace
+
+struct Crawler::Task
+{
+	Listing listing {Listing::Webs};
+	// the web whose api lists the folder
+	std::string webUrl;
+	// the server relative url of the folder
+	std::string path;
+	// index into the sites
+	size_t site {0};
+	// the worker which parses the answer
+	size_t worker {0};
+	bool answered {false};
+	long httpStatusCode {0};
+	std::string body;
+	// of a throttled answer
+	std::chrono::seconds retryAfter {-1};
+	unsigned retries {0};
+};
+
+struct Crawler::Worker
+{
+	std::mutex mutex;
+	// the owner works at the back, thieves take from the front
+	std::deque<std::shared_ptr<Task>> tasks;
+	std::thread thread;
+};
+
+Crawler::Crawler(const WebRequest &request, size_t workers, size_t maxRequests) :
+	m_request(request),
+	m_workerCount(workers > 0 ? workers : std::thread::hardware_concurrency()),
+	m_maxRequests(maxRequests > 0 ? maxRequests : DefaultMaxRequests),
+	m_maxRequestsPerSite(0),
+	m_includeHiddenLists(false),
+	m_queued(0),
+	m_done(false),
+	m_outstanding(0),
+	m_inFlight(0),
+	m_nextSite(0)
+{
+	if (m_workerCount == 0) {
+		m_workerCount = 1;
+	}
+}
+
+Crawler::~Crawler()
+{
+}
+
+void Crawler::setMaxRequestsPerSite(size_t maxRequestsPerSite)
+{
+	m_maxRequestsPerSite = maxRequestsPerSite;
+}
+
+void Crawler::setIncludeHiddenLists(bool includeHiddenLists)
+{
+	m_includeHiddenLists = includeHiddenLists;
+}
+
+void Crawler::addSite(const std::string &siteUrl)
+{
+	std::string site(siteUrl);
+	while (!site.empty() && site.back() == '/') {
+		site.pop_back();
+	}
+	m_sites.push_back(std::move(site));
+}
+
+bool Crawler::run(const SinkType &sink)
+{
+	m_sink = sink;
+	m_statistics = Statistics();
+	m_queued = 0;
+	m_done = m_sites.empty();
+	m_inFlight = 0;
+	m_siteInFlight.assign(m_sites.size(), 0);
+	m_waiting.assign(m_sites.size(), std::deque<std::shared_ptr<Task>>());
+	m_siteResume.assign(m_sites.size(), std::chrono::steady_clock::time_point());
+	m_nextSite = 0;
+	m_engine = std::make_unique<AsyncEngine>(static_cast<long>(m_maxRequests));
+	m_workers.clear();
+	for (size_t worker = 0; worker < m_workerCount; ++worker) {
+		m_workers.push_back(std::make_unique<Worker>());
+	}
+
+	// the sites start on different workers
+	m_outstanding = 2 * m_sites.size();
+	for (size_t site = 0; site < m_sites.size(); ++site) {
+		Item web;
+		web.kind = Item::Kind::Web;
+		web.url = m_sites[site];
+		web.site = m_sites[site];
+		emit(std::move(web));
+		for (Listing listing : {Listing::Webs, Listing::Lists}) {
+			auto task = std::make_shared<Task>();
+			task->listing = listing;
+			task->webUrl = m_sites[site];
+			task->site = site;
+			push(site % m_workerCount, std::move(task));
+		}
+	}
+	for (size_t worker = 0; worker < m_workerCount; ++worker) {
+		m_workers[worker]->thread = std::thread(&Crawler::work, this, worker);
+	}
+	for (auto &worker : m_workers) {
+		worker->thread.join();
+	}
+	m_engine.reset();
+	m_workers.clear();
+	m_sink = SinkType();
+	return statistics().failedRequests == 0;
+}
+
+Crawler::Statistics Crawler::statistics() const
+{
+	std::lock_guard<std::mutex> lock(m_statisticsMutex);
+	return m_statistics;
+}
+
+void Crawler::work(size_t worker)
+{
+	for (;;) {
+		std::shared_ptr<Task> task = take(worker);
+		if (!task) {
+			std::chrono::steady_clock::time_point resume = resumeTime();
+			std::unique_lock<std::mutex> lock(m_mutex);
+			auto ready = [this]() { return m_queued > 0 || m_done; };
+			if (resume == std::chrono::steady_clock::time_point::max()) {
+				m_wakeup.wait(lock, ready);
+			} else if (!m_wakeup.wait_until(lock, resume, ready)) {
+				// a throttled site takes requests again
+				continue;
+			}
+			if (m_done) {
+				return;
+			}
+			continue;
+		}
+		if (task->answered && isThrottled(task->httpStatusCode) && task->retries < MaxRetries) {
+			retry(std::move(task));
+		} else if (task->answered) {
+			parse(worker, *task);
+			finish();
+		} else {
+			dispatch(worker, std::move(task));
+		}
+	}
+}
+
+std::shared_ptr<Crawler::Task> Crawler::take(size_t worker)
+{
+	std::shared_ptr<Task> task;
+	{
+		Worker &own = *m_workers[worker];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.tasks.empty()) {
+			task = std::move(own.tasks.back());
+			own.tasks.pop_back();
+		}
+	}
+	for (size_t i = 1; !task && i < m_workerCount; ++i) {
+		Worker &victim = *m_workers[(worker + i) % m_workerCount];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.tasks.empty()) {
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			std::lock_guard<std::mutex> statisticsLock(m_statisticsMutex);
+			++m_statistics.steals;
+		}
+	}
+	if (task) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		--m_queued;
+	}
+	return task;
+}
+
+void Crawler::push(size_t worker, std::shared_ptr<Task> &&task)
+{
+	{
+		Worker &owner = *m_workers[worker];
+		std::lock_guard<std::mutex> lock(owner.mutex);
+		owner.tasks.push_back(std::move(task));
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		++m_queued;
+	}
+	m_wakeup.notify_one();
+}
+
+void Crawler::spawn(size_t worker, const Task &parent, Listing listing, const std::string &webUrl, const std::string &path)
+{
+	auto task = std::make_shared<Task>();
+	task->listing = listing;
+	task->webUrl = webUrl;
+	task->path = path;
+	task->site = parent.site;
+	// counted before the parent is finished, the count can't reach 0 in between
+	++m_outstanding;
+	push(worker, std::move(task));
+}
+
+void Crawler::dispatch(size_t worker, std::shared_ptr<Task> &&task)
+{
+	task->worker = worker;
+	std::lock_guard<std::mutex> lock(m_dispatchMutex);
+	size_t site = task->site;
+	if (m_inFlight < m_maxRequests &&
+		(m_maxRequestsPerSite == 0 || m_siteInFlight[site] < m_maxRequestsPerSite) &&
+		m_siteResume[site] <= std::chrono::steady_clock::now()) {
+		launch(std::move(task));
+	} else {
+		m_waiting[site].push_back(std::move(task));
+	}
+}
+
+void Crawler::launchWaiting()
+{
+	size_t sites = m_waiting.size();
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	while (m_inFlight < m_maxRequests) {
+		bool launched = false;
+		for (size_t i = 0; i < sites; ++i) {
+			size_t site = (m_nextSite + i) % sites;
+			if (!m_waiting[site].empty() &&
+				(m_maxRequestsPerSite == 0 || m_siteInFlight[site] < m_maxRequestsPerSite) &&
+				m_siteResume[site] <= now) {
+				std::shared_ptr<Task> task = std::move(m_waiting[site].front());
+				m_waiting[site].pop_front();
+				// the next turn starts at the following site
+				m_nextSite = (site + 1) % sites;
+				launch(std::move(task));
+				launched = true;
+				break;
+			}
+		}
+		if (!launched) {
+			break;
+		}
+	}
+}
+
+void Crawler::launch(std::shared_ptr<Task> &&task)
+{
+	// the dispatch lock is held
+	++m_inFlight;
+	++m_siteInFlight[task->site];
+	{
+		std::lock_guard<std::mutex> lock(m_statisticsMutex);
+		++m_statistics.requests;
+		if (m_inFlight > m_statistics.peakRequests) {
+			m_statistics.peakRequests = m_inFlight;
+		}
+	}
+	Url url = listingUrl(*task);
+	m_engine->get(m_request, url, [this, task](WebResponse &&response) {
+		task->httpStatusCode = response.httpStatusCode();
+		task->body = response.takeResponse();
+		if (isThrottled(task->httpStatusCode)) {
+			task->retryAfter = retryAfterOf(response);
+		}
+		task->answered = true;
+		{
+			std::lock_guard<std::mutex> lock(m_dispatchMutex);
+			--m_inFlight;
+			--m_siteInFlight[task->site];
+			launchWaiting();
+		}
+		// parsed by the worker which sent it, unless another one steals it
+		push(task->worker, std::shared_ptr<Task>(task));
+	});
+}
+
+void Crawler::retry(std::shared_ptr<Task> &&task)
+{
+	std::chrono::seconds delay = task->retryAfter.count() >= 0 ?
+		task->retryAfter : std::chrono::seconds(1LL << task->retries);
+	++task->retries;
+	task->answered = false;
+	task->httpStatusCode = 0;
+	task->body.clear();
+	task->retryAfter = std::chrono::seconds(-1);
+	RequestMetrics::recordRetry(RequestMetrics::classify(listingUrl(*task).resource(), false));
+	{
+		std::lock_guard<std::mutex> lock(m_statisticsMutex);
+		++m_statistics.retries;
+	}
+	std::lock_guard<std::mutex> lock(m_dispatchMutex);
+	size_t site = task->site;
+	std::chrono::steady_clock::time_point resume = std::chrono::steady_clock::now() + delay;
+	if (resume > m_siteResume[site]) {
+		m_siteResume[site] = resume;
+	}
+	// the other listings of the site wait behind it
+	m_waiting[site].push_front(std::move(task));
+	launchWaiting();
+}
+
+std::chrono::steady_clock::time_point Crawler::resumeTime()
+{
+	std::lock_guard<std::mutex> lock(m_dispatchMutex);
+	launchWaiting();
+	// a site still waiting and not throttled waits for a request on its
+	// way to come back
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	std::chrono::steady_clock::time_point resume = std::chrono::steady_clock::time_point::max();
+	for (size_t site = 0; site < m_waiting.size(); ++site) {
+		if (!m_waiting[site].empty() && m_siteResume[site] > now && m_siteResume[site] < resume) {
+			resume = m_siteResume[site];
+		}
+	}
+	return resume;
+}
+
+void Crawler::parse(size_t worker, Task &task)
+{
+	static const XmlPath propertiesPath("content/m:properties", feedNamespaces());
+	static const XmlPath urlPath("d:Url", feedNamespaces());
+	static const XmlPath titlePath("d:Title", feedNamespaces());
+	static const XmlPath hiddenPath("d:Hidden", feedNamespaces());
+	static const XmlPath rootFolderPath(
+		"link/m:inline/entry/content/m:properties/d:ServerRelativeUrl", feedNamespaces());
+	static const XmlPath namePath("d:Name", feedNamespaces());
+	static const XmlPath serverRelativeUrlPath("d:ServerRelativeUrl", feedNamespaces());
+	static const XmlPath lengthPath("d:Length", feedNamespaces());
+
+	if (task.httpStatusCode != 200) {
+		std::lock_guard<std::mutex> lock(m_statisticsMutex);
+		++m_statistics.failedRequests;
+		return;
+	}
+	XmlDocumentPool::DocumentLease doc(XmlDocumentPool::document());
+	// the document takes over the response body and parses it in place
+	const tinyxml2::XMLElement *feed = nullptr;
+	if (doc->ParseInSitu(std::move(task.body)) == tinyxml2::XML_SUCCESS) {
+		feed = doc->FirstChildElement("feed");
+	}
+	if (feed == nullptr) {
+		std::lock_guard<std::mutex> lock(m_statisticsMutex);
+		++m_statistics.failedRequests;
+		return;
+	}
+	for (const tinyxml2::XMLElement *entry = feed->FirstChildElement("entry");
+		entry != nullptr;
+		entry = entry->NextSiblingElement("entry")) {
+		const tinyxml2::XMLElement *properties = propertiesPath.first(*entry);
+		if (properties == nullptr) {
+			continue;
+		}
+		Item item;
+		item.site = m_sites[task.site];
+		switch (task.listing) {
+		case Listing::Webs:
+			item.kind = Item::Kind::Web;
+			item.url = textOf(urlPath, *properties);
+			item.name = textOf(titlePath, *properties);
+			if (item.url.empty()) {
+				continue;
+			}
+			spawn(worker, task, Listing::Webs, item.url, std::string());
+			spawn(worker, task, Listing::Lists, item.url, std::string());
+			break;
+		case Listing::Lists:
+			if (!m_includeHiddenLists && textOf(hiddenPath, *properties) == "true") {
+				continue;
+			}
+			item.kind = Item::Kind::List;
+			item.url = textOf(rootFolderPath, *entry);
+			item.name = textOf(titlePath, *properties);
+			if (item.url.empty()) {
+				continue;
+			}
+			spawn(worker, task, Listing::Folders, task.webUrl, item.url);
+			spawn(worker, task, Listing::Files, task.webUrl, item.url);
+			break;
+		case Listing::Folders:
+			item.kind = Item::Kind::Folder;
+			item.url = textOf(serverRelativeUrlPath, *properties);
+			item.name = textOf(namePath, *properties);
+			if (item.url.empty()) {
+				continue;
+			}
+			spawn(worker, task, Listing::Folders, task.webUrl, item.url);
+			spawn(worker, task, Listing::Files, task.webUrl, item.url);
+			break;
+		case Listing::Files:
+			item.kind = Item::Kind::File;
+			item.url = textOf(serverRelativeUrlPath, *properties);
+			item.name = textOf(namePath, *properties);
+			if (const char *length = lengthPath.text(*properties)) {
+				item.size = strtoull(length, nullptr, 10);
+			}
+			break;
+		}
+		emit(std::move(item));
+	}
+}
+
+void Crawler::emit(Item &&item)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_statisticsMutex);
+		++m_statistics.items;
+	}
+	std::lock_guard<std::mutex> lock(m_sinkMutex);
+	if (m_sink) {
+		m_sink(item);
+	}
+}
+
+void Crawler::finish()
+{
+	if (--m_outstanding == 0) {
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_done = true;
+		}
+		m_wakeup.notify_all();
+	}
+}
+
+Url Crawler::listingUrl(const Task &task)
+{
+	switch (task.listing) {
+	case Listing::Webs:
+		return OData::query(
+			OData::select("Title", "Url", "ServerRelativeUrl")).url(task.webUrl, "/_api/web/webs");
+	case Listing::Lists:
+		return OData::query(
+			OData::select("Title", "Hidden", "BaseTemplate", "RootFolder/ServerRelativeUrl"),
+			OData::expand("RootFolder")).url(task.webUrl, "/_api/web/lists");
+	default:
+		break;
+	}
+	// the path goes into a parameter alias, the url can't hold it in the
+	// function call with all its characters
+	std::string resource(task.listing == Listing::Folders ?
+		"/_api/web/GetFolderByServerRelativeUrl(@a1)/Folders?@a1='" :
+		"/_api/web/GetFolderByServerRelativeUrl(@a1)/Files?@a1='");
+	std::string quotedPath;
+	for (char c : task.path) {
+		quotedPath += c;
+		if (c == '\'') {
+			quotedPath += c;
+		}
+	}
+	PercentEncoding::appendEncoded(quotedPath, resource);
+	resource += '\'';
+	if (task.listing == Listing::Folders) {
+		return OData::query(OData::select("Name", "ServerRelativeUrl")).url(task.webUrl, resource);
+	}
+	return OData::query(OData::select("Name", "ServerRelativeUrl", "Length")).url(task.webUrl, resource);
+}
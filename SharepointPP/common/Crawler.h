@@ -0,0 +1,203 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef COMMON_CRAWLER_H_
+#define COMMON_CRAWLER_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "AsyncEngine.h"
+#include "Url.h"
+#include "WebRequest.h"
+
+namespace Microsoft {
+namespace Sharepoint {
+// Lists everything below the added sites: their webs, lists, folders and
+// files, e.g.
+//   Crawler crawler(auth.getPreparedRequest(), 8, 32);
+//   crawler.addSite("https://contoso.sharepoint.com/sites/team");
+//   crawler.run([](const Crawler::Item &item) { ... });
+// Every listing (the webs or lists of a web, the folders or files of a
+// folder) is a task. Each worker thread keeps its tasks on a deque of its
+// own: it takes the newest one itself, an idle worker steals the oldest
+// one of another worker, which usually is the root of a larger subtree.
+// A worker sends the request of a task through the AsyncEngine and goes
+// on with the next task, the answer comes back as a task on the deque of
+// the worker to be parsed there. At most maxRequests requests are on
+// their way at a time, maxRequestsPerSite of them to one site; a task
+// which has to wait for its turn is queued by site and the sites take
+// turns, so one large site doesn't hold back the others.
+// A listing the server throttles (429 or 503) goes back to the front of
+// the queue of its site and the site gets no requests until the
+// Retry-After has passed, without one the wait doubles with every retry.
+// After MaxRetries the listing counts as failed.
+// The sink gets every item as soon as its listing is parsed, one item at
+// a time, from the worker threads.
+class Crawler
+{
+ public:
+	struct Item
+	{
+		enum class Kind
+		{
+			Web,
+			List,
+			Folder,
+			File
+		};
+
+		Kind kind {Kind::Web};
+		// the absolute url of a web, the server relative url of the others
+		std::string url;
+		std::string name;
+		// of a file, in bytes
+		uint64_t size {0};
+		// the site (as added) the item belongs to
+		std::string site;
+	};
+
+	struct Statistics
+	{
+		uint64_t requests {0};
+		// listings which couldn't be read, their subtree is missing
+		uint64_t failedRequests {0};
+		// listings sent again because the server throttled them
+		uint64_t retries {0};
+		uint64_t items {0};
+		// tasks taken from the deque of another worker
+		uint64_t steals {0};
+		// the most requests on their way at the same time
+		size_t peakRequests {0};
+	};
+
+	typedef std::function<void(const Crawler::Item &item)> SinkType;
+
+ public:
+	static constexpr size_t DefaultMaxRequests = 16;
+	static constexpr unsigned MaxRetries = 5;
+
+ public:
+	// the request has to carry the cookies of the user, workers 0 uses
+	// one per hardware thread
+	__declspec(dllexport)
+		explicit Crawler(const WebRequest &request, size_t workers = 0, size_t maxRequests = DefaultMaxRequests);
+	__declspec(dllexport)
+		~Crawler();
+	Crawler(const Crawler &other) = delete;
+	Crawler &operator=(const Crawler &other) = delete;
+
+ public:
+	// 0, the default, leaves only the limit of all requests
+	__declspec(dllexport)
+		void setMaxRequestsPerSite(size_t maxRequestsPerSite);
+	// hidden lists (the ones of the system, like the master page gallery) are skipped by default
+	__declspec(dllexport)
+		void setIncludeHiddenLists(bool includeHiddenLists);
+	// the url of a site collection or a web, it is listed with all below it
+	__declspec(dllexport)
+		void addSite(const std::string &siteUrl);
+
+ public:
+	// lists every added site and returns once all is found, false if a
+	// listing failed
+	__declspec(dllexport)
+		bool run(const Crawler::SinkType &sink);
+	__declspec(dllexport)
+		Crawler::Statistics statistics() const;
+
+ private:
+	enum class Listing
+	{
+		Webs,
+		Lists,
+		Folders,
+		Files
+	};
+
+	struct Task;
+	struct Worker;
+
+ private:
+	void work(size_t worker);
+	std::shared_ptr<Task> take(size_t worker);
+	void push(size_t worker, std::shared_ptr<Task> &&task);
+	void spawn(size_t worker, const Task &parent, Listing listing, const std::string &webUrl, const std::string &path);
+	void dispatch(size_t worker, std::shared_ptr<Task> &&task);
+	// the dispatch lock is held
+	void launchWaiting();
+	void launch(std::shared_ptr<Task> &&task);
+	void retry(std::shared_ptr<Task> &&task);
+	// launches what may go and returns when the next throttled site
+	// takes requests again, max if none is waiting for that
+	std::chrono::steady_clock::time_point resumeTime();
+	void parse(size_t worker, Task &task);
+	void emit(Crawler::Item &&item);
+	void finish();
+	static Url listingUrl(const Task &task);
+
+ private:
+	WebRequest m_request;
+	size_t m_workerCount;
+	size_t m_maxRequests;
+	size_t m_maxRequestsPerSite;
+	bool m_includeHiddenLists;
+	std::vector<std::string> m_sites;
+
+	std::vector<std::unique_ptr<Worker>> m_workers;
+	std::unique_ptr<AsyncEngine> m_engine;
+	// tasks on the deques and idle workers waiting for them
+	std::mutex m_mutex;
+	std::condition_variable m_wakeup;
+	size_t m_queued;
+	bool m_done;
+	// tasks not finished yet, the crawl is done at 0
+	std::atomic<size_t> m_outstanding;
+
+	// the requests on their way and the tasks waiting for their turn
+	std::mutex m_dispatchMutex;
+	size_t m_inFlight;
+	std::vector<size_t> m_siteInFlight;
+	std::vector<std::deque<std::shared_ptr<Task>>> m_waiting;
+	// a throttled site gets no requests before then
+	std::vector<std::chrono::steady_clock::time_point> m_siteResume;
+	size_t m_nextSite;
+
+	std::mutex m_sinkMutex;
+	SinkType m_sink;
+	mutable std::mutex m_statisticsMutex;
+	Statistics m_statistics;
+};
+}  // namespace Sharepoint
+}  // namespace Microsoft
+
+#endif  // COMMON_CRAWLER_H_
@@ -0,0 +1,101 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "CurlHandlePool.h"
+
+#include <mutex>
+#include <vector>
+
+using Microsoft::Sharepoint::CurlHandlePool;
+
+namespace {
+// enough for the transfers an AsyncEngine runs at once
+const size_t MaxPooledHandles = 64;
+
+struct HandlePool
+{
+	std::mutex mutex;
+	std::vector<CURL *> handles;
+	std::vector<CURL *> sharedHandles;
+
+	~HandlePool()
+	{
+		for (CURL *handle : handles) {
+			curl_easy_cleanup(handle);
+		}
+		for (CURL *handle : sharedHandles) {
+			curl_easy_cleanup(handle);
+		}
+	}
+
+	std::vector<CURL *> &select(bool shared)
+	{
+		return shared ? sharedHandles : handles;
+	}
+};
+
+HandlePool &handlePool()
+{
+	static HandlePool pool;
+	return pool;
+}
+}  // namespace
+
+CURL *CurlHandlePool::acquire(bool shared)
+{
+	HandlePool &pool = handlePool();
+	{
+		std::lock_guard<std::mutex> lock(pool.mutex);
+		std::vector<CURL *> &handles = pool.select(shared);
+		if (!handles.empty()) {
+			CURL *handle = handles.back();
+			handles.pop_back();
+			return handle;
+		}
+	}
+	return curl_easy_init();
+}
+
+void CurlHandlePool::release(CURL *handle, bool shared)
+{
+	if (handle == nullptr) {
+		return;
+	}
+	// curl_easy_reset() keeps the cookies and the share, they must not
+	// leak into the transfer of another cookie jar, and a share can't be
+	// cleaned up while a handle still uses it
+	curl_easy_setopt(handle, CURLOPT_COOKIELIST, "ALL");
+	curl_easy_setopt(handle, CURLOPT_SHARE, nullptr);
+	// the reset drops the list of cookie files without freeing it
+	curl_easy_setopt(handle, CURLOPT_COOKIEFILE, nullptr);
+	curl_easy_reset(handle);
+	HandlePool &pool = handlePool();
+	{
+		std::lock_guard<std::mutex> lock(pool.mutex);
+		std::vector<CURL *> &handles = pool.select(shared);
+		if (handles.size() < MaxPooledHandles) {
+			handles.push_back(handle);
+			return;
+		}
+	}
+	curl_easy_cleanup(handle);
+}
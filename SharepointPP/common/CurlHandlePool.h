@@ -0,0 +1,51 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef COMMON_CURLHANDLEPOOL_H_
+#define COMMON_CURLHANDLEPOOL_H_
+
+#include <curl/curl.h>
+
+namespace Microsoft {
+namespace Sharepoint {
+// A process wide pool of curl easy handles, shared by all threads.
+// A transfer takes a handle when it is prepared and gives it back as
+// soon as it completed. A returned handle is reset, it keeps its
+// connection and dns caches for the next transfer but no options and no
+// cookies. The pool keeps a limited number of handles, further ones are
+// cleaned up on release.
+// Handles which run with a share handle are kept apart from the others,
+// libcurl drops the ssl session cache of a handle without freeing it
+// when a share is attached to it later on.
+class CurlHandlePool
+{
+ public:
+	// nullptr if no new handle could be created
+	static CURL *acquire(bool shared);
+	// shared has to be the same as on acquire
+	static void release(CURL *handle, bool shared);
+};
+}  // namespace Sharepoint
+}  // namespace Microsoft
+
+#endif  // COMMON_CURLHANDLEPOOL_H_
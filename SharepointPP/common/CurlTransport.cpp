@@ -0,0 +1,55 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "CurlTransport.h"
+
+#include <utility>
+
+#include "AsyncEngine.h"
+#include "WebTransfer.h"
+
+using Microsoft::Sharepoint::AsyncEngine;
+using Microsoft::Sharepoint::CurlTransport;
+using Microsoft::Sharepoint::WebResponse;
+using Microsoft::Sharepoint::WebTransfer;
+
+CurlTransport::CurlTransport()
+{
+}
+
+CurlTransport::~CurlTransport()
+{
+}
+
+WebResponse CurlTransport::send(const WebRequest &request, Method method, const Url &url, std::string &&data)
+{
+	WebTransfer transfer(request, method, url, std::move(data));
+	return transfer.perform();
+}
+
+void CurlTransport::sendAsync(const WebRequest &request, Method method, const Url &url, std::string &&data, CompletionType &&completion)
+{
+	std::call_once(m_engineStarted, [this]() {
+		m_engine = std::make_unique<AsyncEngine>();
+	});
+	m_engine->submit(std::make_unique<WebTransfer>(request, method, url, std::move(data)), std::move(completion));
+}
@@ -0,0 +1,63 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef COMMON_CURLTRANSPORT_H_
+#define COMMON_CURLTRANSPORT_H_
+
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "Transport.h"
+
+namespace Microsoft {
+namespace Sharepoint {
+class AsyncEngine;
+
+// Sends the requests over the network with libcurl.
+// The AsyncEngine runs requests of this transport on its own multi
+// handle instead of calling sendAsync(). sendAsync() is for transports
+// stacked on this one, it runs the requests on an AsyncEngine of the
+// transport, which is started by the first call.
+class CurlTransport : public Transport
+{
+ public:
+	__declspec(dllexport)
+		CurlTransport();
+	__declspec(dllexport)
+		~CurlTransport();
+
+ public:
+	__declspec(dllexport)
+		WebResponse send(const WebRequest &request, Transport::Method method, const Url &url, std::string &&data) override;
+	__declspec(dllexport)
+		void sendAsync(const WebRequest &request, Transport::Method method, const Url &url, std::string &&data, Transport::CompletionType &&completion) override;
+
+ private:
+	std::once_flag m_engineStarted;
+	std::unique_ptr<AsyncEngine> m_engine;
+};
+}  // namespace Sharepoint
+}  // namespace Microsoft
+
+#endif  // COMMON_CURLTRANSPORT_H_
@@ -0,0 +1,463 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "FileCache.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <sstream>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "Sha256.h"
+#include "Transport.h"
+#include "WebResponse.h"
+
+using Microsoft::Sharepoint::FileCache;
+using Microsoft::Sharepoint::MappedFile;
+using Microsoft::Sharepoint::Sha256;
+using Microsoft::Sharepoint::Transport;
+using Microsoft::Sharepoint::WebRequest;
+using Microsoft::Sharepoint::WebResponse;
+
+namespace fs = std::filesystem;
+
+namespace {
+const char *const temporarySuffix = ".tmp";
+
+bool isTemporary(const fs::path &path)
+{
+	return path.extension() == temporarySuffix;
+}
+
+std::string etagOf(const WebResponse &response)
+{
+	std::string etag;
+	for (auto &header : response.header()) {
+		if (header.first.length() == 4 &&
+			tolower(static_cast<unsigned char>(header.first[0])) == 'e' &&
+			tolower(static_cast<unsigned char>(header.first[1])) == 't' &&
+			tolower(static_cast<unsigned char>(header.first[2])) == 'a' &&
+			tolower(static_cast<unsigned char>(header.first[3])) == 'g') {
+			etag = header.second;
+		}
+	}
+	// curl keeps the line break
+	while (!etag.empty() && (etag.back() == '\r' || etag.back() == '\n' || etag.back() == ' ')) {
+		etag.pop_back();
+	}
+	return etag;
+}
+
+std::string readFile(const fs::path &path)
+{
+	std::ifstream file(path, std::ios::binary);
+	std::ostringstream content;
+	content << file.rdbuf();
+	return content.str();
+}
+}
+
+FileCache::FileCache(const std::string &directory, uint64_t maxBytes) :
+	m_directory(directory),
+	m_maxBytes(maxBytes),
+	m_open(false),
+	m_random(std::random_device()())
+{
+	load();
+}
+
+FileCache::~FileCache()
+{
+}
+
+bool FileCache::isOpen() const
+{
+	return m_open;
+}
+
+FileCache::Content FileCache::download(const WebRequest &request, const Url &url)
+{
+	std::string etag;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto reference = m_references.find(url.str());
+		if (reference != m_references.end()) {
+			etag = reference->second.etag;
+		}
+	}
+	// the transfer goes straight to the transport, so it takes the slot
+	// WebRequest::get() would take and holds it until the body is stored
+	RequestScheduler::Slot slot;
+	std::shared_ptr<RequestScheduler> scheduler = request.scheduler();
+	if (scheduler) {
+		slot = scheduler->acquire(url, request.priority(), scheduler->deadline(request.priority()));
+		if (!slot.isValid()) {
+			Content content;
+			content.m_httpStatusCode = RequestScheduler::DeadlinePassed;
+			return content;
+		}
+	}
+	WebRequest conditionalRequest(request);
+	if (!etag.empty()) {
+		conditionalRequest.addHeader("If-None-Match", etag);
+	}
+	// the body is written to a temporary object file as it arrives
+	// and hashed on the way, so a large file is never held in memory
+	Sha256 hash;
+	uint64_t size = 0;
+	fs::path temporaryPath;
+	std::ofstream file;
+	if (m_open) {
+		conditionalRequest.setBodySink([&](const char *data, size_t length) {
+			if (!file.is_open()) {
+				temporaryPath = temporaryPathOf(m_directory / "objects" / "incoming");
+				file.open(temporaryPath, std::ios::binary | std::ios::trunc);
+			}
+			hash.update(std::string_view(data, length));
+			size += length;
+			file.write(data, static_cast<std::streamsize>(length));
+			return static_cast<bool>(file);
+		});
+	}
+	WebResponse response = conditionalRequest.transport()->send(
+		conditionalRequest, Transport::Method::Get, url, std::string());
+	bool streamed = file.is_open();
+	if (streamed) {
+		file.close();
+	}
+
+	Content content;
+	content.m_httpStatusCode = response.httpStatusCode();
+	if (streamed && content.m_httpStatusCode != 200) {
+		// another 2xx answer is returned like an error, a failed transfer has no body
+		if (content.m_httpStatusCode >= 200 && content.m_httpStatusCode < 300) {
+			content.m_buffer = readFile(temporaryPath);
+		}
+		std::error_code error;
+		fs::remove(temporaryPath, error);
+		return content;
+	}
+	if (content.m_httpStatusCode == 304 && !etag.empty()) {
+		content.m_mapped = open(url.str(), &etag);
+		if (content.m_mapped) {
+			content.m_httpStatusCode = 200;
+			content.m_fromCache = true;
+			std::lock_guard<std::mutex> lock(m_mutex);
+			++m_statistics.hits;
+			return content;
+		}
+		// removed meanwhile, the reference is gone now and the retry transfers the file
+		slot.release();
+		return download(request, url);
+	}
+	if (content.m_httpStatusCode != 200) {
+		content.m_buffer = response.takeResponse();
+		return content;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		++m_statistics.misses;
+	}
+	std::string newEtag = etagOf(response);
+	if (streamed) {
+		std::string contentHash = Sha256::hex(hash.digest());
+		fs::path path = contentPath(contentHash);
+		std::error_code error;
+		if (touchContent(contentHash)) {
+			fs::remove(temporaryPath, error);
+		} else {
+			fs::create_directories(path.parent_path(), error);
+			fs::rename(temporaryPath, path, error);
+			if (error) {
+				content.m_buffer = readFile(temporaryPath);
+				fs::remove(temporaryPath, error);
+				return content;
+			}
+			addContent(contentHash, size);
+		}
+		// without an etag the content can't be revalidated, it is only
+		// mapped from the cache and removed by the eviction later
+		content.m_mapped = newEtag.empty() ? MappedFile::open(path.string()) : addReference(url, newEtag, contentHash);
+		if (!content.m_mapped) {
+			content.m_buffer = readFile(path);
+		}
+		return content;
+	}
+	std::string body = response.takeResponse();
+	if (!newEtag.empty()) {
+		content.m_mapped = store(url, newEtag, body);
+	}
+	if (!content.m_mapped) {
+		content.m_buffer = std::move(body);
+	}
+	return content;
+}
+
+std::shared_ptr<MappedFile> FileCache::lookup(const Url &url, const std::string &etag)
+{
+	return open(url.str(), &etag);
+}
+
+std::shared_ptr<MappedFile> FileCache::store(const Url &url, const std::string &etag, std::string_view content)
+{
+	if (!m_open) {
+		return nullptr;
+	}
+	std::string contentHash = Sha256::hexDigest(content);
+	// written without the lock, a concurrent store of the same content renames the same bytes
+	if (!touchContent(contentHash)) {
+		fs::path path = contentPath(contentHash);
+		std::error_code error;
+		fs::create_directories(path.parent_path(), error);
+		if (!writeFile(path, content)) {
+			return nullptr;
+		}
+		addContent(contentHash, content.length());
+	}
+	return addReference(url, etag, contentHash);
+}
+
+FileCache::Statistics FileCache::statistics() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	Statistics statistics = m_statistics;
+	statistics.contents = m_contents.size();
+	statistics.urls = m_references.size();
+	return statistics;
+}
+
+void FileCache::load()
+{
+	std::error_code error;
+	fs::create_directories(m_directory / "objects", error);
+	if (error) {
+		return;
+	}
+	fs::create_directories(m_directory / "refs", error);
+	if (error) {
+		return;
+	}
+	m_open = true;
+
+	for (fs::recursive_directory_iterator entry(m_directory / "objects", error), end;
+		!error && entry != end;
+		entry.increment(error)) {
+		if (!entry->is_regular_file(error)) {
+			continue;
+		}
+		// left behind by a process which died while writing
+		if (isTemporary(entry->path())) {
+			fs::remove(entry->path(), error);
+			continue;
+		}
+		StoredContent content;
+		content.size = entry->file_size(error);
+		content.lastUse = entry->last_write_time(error);
+		m_statistics.bytes += content.size;
+		m_contents.emplace(entry->path().filename().string(), content);
+	}
+
+	for (fs::directory_iterator entry(m_directory / "refs", error), end;
+		!error && entry != end;
+		entry.increment(error)) {
+		std::error_code removeError;
+		if (isTemporary(entry->path())) {
+			fs::remove(entry->path(), removeError);
+			continue;
+		}
+		std::ifstream file(entry->path(), std::ios::binary);
+		std::string etag;
+		std::string contentHash;
+		std::string url;
+		if (std::getline(file, etag) && std::getline(file, contentHash) && std::getline(file, url) &&
+			m_contents.find(contentHash) != m_contents.end()) {
+			m_references[url] = Reference {etag, contentHash};
+		} else {
+			file.close();
+			fs::remove(entry->path(), removeError);
+		}
+	}
+	evict(std::string());
+}
+
+std::shared_ptr<MappedFile> FileCache::open(const std::string &url, const std::string *etag)
+{
+	fs::path path;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto reference = m_references.find(url);
+		if (reference == m_references.end() || (etag != nullptr && reference->second.etag != *etag)) {
+			return nullptr;
+		}
+		auto content = m_contents.find(reference->second.contentHash);
+		if (content == m_contents.end()) {
+			// the content was evicted
+			forget(url);
+			return nullptr;
+		}
+		content->second.lastUse = fs::file_time_type::clock::now();
+		path = contentPath(reference->second.contentHash);
+	}
+	// the time of use survives a restart
+	std::error_code error;
+	fs::last_write_time(path, fs::file_time_type::clock::now(), error);
+	std::shared_ptr<MappedFile> mapped = MappedFile::open(path.string());
+	if (!mapped) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		forget(url);
+	}
+	return mapped;
+}
+
+bool FileCache::touchContent(const std::string &contentHash)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto existing = m_contents.find(contentHash);
+	if (existing == m_contents.end()) {
+		return false;
+	}
+	existing->second.lastUse = fs::file_time_type::clock::now();
+	++m_statistics.deduplicated;
+	return true;
+}
+
+void FileCache::addContent(const std::string &contentHash, uint64_t size)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto inserted = m_contents.emplace(contentHash, StoredContent());
+	if (inserted.second) {
+		inserted.first->second.size = size;
+		m_statistics.bytes += size;
+		++m_statistics.stores;
+	}
+	inserted.first->second.lastUse = fs::file_time_type::clock::now();
+}
+
+std::shared_ptr<MappedFile> FileCache::addReference(const Url &url, const std::string &etag, const std::string &contentHash)
+{
+	std::string reference = etag + '\n' + contentHash + '\n' + url.str() + '\n';
+	if (!writeFile(referencePath(url.str()), reference)) {
+		return nullptr;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_references[url.str()] = Reference {etag, contentHash};
+		evict(contentHash);
+	}
+	return MappedFile::open(contentPath(contentHash).string());
+}
+
+fs::path FileCache::temporaryPathOf(const fs::path &path)
+{
+	uint64_t unique = 0;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		unique = m_random();
+	}
+	fs::path temporaryPath(path);
+	temporaryPath += "." + std::to_string(unique) + temporarySuffix;
+	return temporaryPath;
+}
+
+bool FileCache::writeFile(const fs::path &path, std::string_view content)
+{
+	fs::path temporaryPath = temporaryPathOf(path);
+	{
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		file.write(content.data(), static_cast<std::streamsize>(content.length()));
+		file.close();
+		if (!file) {
+			std::error_code error;
+			fs::remove(temporaryPath, error);
+			return false;
+		}
+	}
+	std::error_code error;
+	fs::rename(temporaryPath, path, error);
+	if (error) {
+		fs::remove(temporaryPath, error);
+		return false;
+	}
+	return true;
+}
+
+void FileCache::forget(const std::string &url)
+{
+	// the lock is held
+	m_references.erase(url);
+	std::error_code error;
+	fs::remove(referencePath(url), error);
+}
+
+void FileCache::evict(const std::string &keptHash)
+{
+	// the lock is held
+	if (m_statistics.bytes <= m_maxBytes) {
+		return;
+	}
+	std::vector<std::pair<fs::file_time_type, std::string>> byLastUse;
+	byLastUse.reserve(m_contents.size());
+	for (auto &content : m_contents) {
+		byLastUse.emplace_back(content.second.lastUse, content.first);
+	}
+	std::sort(byLastUse.begin(), byLastUse.end());
+	// frees a tenth more than needed, so the next stores don't evict one by one
+	uint64_t target = m_maxBytes - m_maxBytes / 10;
+	for (auto &candidate : byLastUse) {
+		if (m_statistics.bytes <= target) {
+			break;
+		}
+		if (candidate.second == keptHash) {
+			continue;
+		}
+		// a mapped content stays readable until it is unmapped, except on
+		// windows where the file stays until then and is only forgotten here
+		std::error_code error;
+		fs::remove(contentPath(candidate.second), error);
+		auto content = m_contents.find(candidate.second);
+		m_statistics.bytes -= content->second.size;
+		m_contents.erase(content);
+		++m_statistics.evictions;
+	}
+	for (auto reference = m_references.begin(); reference != m_references.end();) {
+		if (m_contents.find(reference->second.contentHash) == m_contents.end()) {
+			std::error_code error;
+			fs::remove(referencePath(reference->first), error);
+			reference = m_references.erase(reference);
+		} else {
+			++reference;
+		}
+	}
+}
+
+fs::path FileCache::contentPath(const std::string &contentHash) const
+{
+	return m_directory / "objects" / contentHash.substr(0, 2) / contentHash;
+}
+
+fs::path FileCache::referencePath(const std::string &url) const
+{
+	return m_directory / "refs" / Sha256::hexDigest(url);
+}
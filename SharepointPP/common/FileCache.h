@@ -0,0 +1,180 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef COMMON_FILECACHE_H_
+#define COMMON_FILECACHE_H_
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "MappedFile.h"
+#include "Url.h"
+#include "WebRequest.h"
+
+namespace Microsoft {
+namespace Sharepoint {
+// A persistent cache for downloaded file contents.
+// The contents are stored once per SHA-256 of their bytes, so the same
+// document in many libraries takes the space of one. Every url refers to
+// a content together with the ETag the server sent for it (sharepoint's
+// ETag carries the version of the file):
+//   <directory>/objects/<first two hex digits>/<sha256 of the content>
+//   <directory>/refs/<sha256 of the url>   etag, content hash and url
+// Files are written to a temporary name and renamed, so a crashed
+// process leaves no half written entry behind. A download of a known
+// url revalidates with If-None-Match and, on 304, is served from the
+// cache with the content mapped into memory.
+// The body of a download is written to a temporary object file while it
+// arrives and hashed on the way, so even a large file is never held in
+// memory (transports other than curl still hand over the whole body).
+// A content the server sent without an ETag is stored unreferenced, it
+// is only mapped and left to the eviction.
+// When the contents exceed the size limit, the ones used least recently
+// are removed. The cache can be shared by many threads.
+class FileCache
+{
+ public:
+	// the content of a download, mapped from the cache or in memory
+	class Content
+	{
+	 public:
+		// 200 for a content served from the cache
+		long httpStatusCode() const
+		{
+			return m_httpStatusCode;
+		}
+		// true if the server answered 304
+		bool fromCache() const
+		{
+			return m_fromCache;
+		}
+		// the file or, for an error, the body of the answer
+		std::string_view view() const
+		{
+			return m_mapped ? m_mapped->view() : std::string_view(m_buffer);
+		}
+
+	 private:
+		friend class FileCache;
+		long m_httpStatusCode {0};
+		bool m_fromCache {false};
+		std::shared_ptr<MappedFile> m_mapped;
+		std::string m_buffer;
+	};
+
+	struct Statistics
+	{
+		// downloads answered with 304 and served from the cache
+		uint64_t hits {0};
+		// downloads which transferred the content
+		uint64_t misses {0};
+		// contents written to the cache
+		uint64_t stores {0};
+		// stored contents which were in the cache already
+		uint64_t deduplicated {0};
+		uint64_t evictions {0};
+		size_t contents {0};
+		size_t urls {0};
+		uint64_t bytes {0};
+	};
+
+ public:
+	static constexpr uint64_t DefaultMaxBytes = 4ULL * 1024 * 1024 * 1024;
+
+ public:
+	// creates the directory if needed and picks up what earlier runs stored
+	__declspec(dllexport)
+		explicit FileCache(const std::string &directory, uint64_t maxBytes = DefaultMaxBytes);
+	__declspec(dllexport)
+		~FileCache();
+	FileCache(const FileCache &other) = delete;
+	FileCache &operator=(const FileCache &other) = delete;
+
+ public:
+	// false if the directory can't be used, everything misses then
+	__declspec(dllexport)
+		bool isOpen() const;
+	// gets the file through the transport of the request, in a slot of its
+	// scheduler if it has one (RequestScheduler::DeadlinePassed if none came)
+	__declspec(dllexport)
+		FileCache::Content download(const WebRequest &request, const Url &url);
+	// the content stored for the url, if it still is the version with the
+	// etag (e.g. taken from the list item), without asking the server
+	__declspec(dllexport)
+		std::shared_ptr<MappedFile> lookup(const Url &url, const std::string &etag);
+	// nullptr if the content couldn't be written
+	__declspec(dllexport)
+		std::shared_ptr<MappedFile> store(const Url &url, const std::string &etag, std::string_view content);
+
+ public:
+	__declspec(dllexport)
+		FileCache::Statistics statistics() const;
+
+ private:
+	struct Reference
+	{
+		std::string etag;
+		std::string contentHash;
+	};
+	struct StoredContent
+	{
+		uint64_t size {0};
+		std::filesystem::file_time_type lastUse;
+	};
+
+ private:
+	void load();
+	// the mapped content of the url, if the stored one has the etag
+	std::shared_ptr<MappedFile> open(const std::string &url, const std::string *etag);
+	// true if the content is stored already, it counts as used then
+	bool touchContent(const std::string &contentHash);
+	// the file of the content has been put in place
+	void addContent(const std::string &contentHash, uint64_t size);
+	std::shared_ptr<MappedFile> addReference(const Url &url, const std::string &etag, const std::string &contentHash);
+	std::filesystem::path temporaryPathOf(const std::filesystem::path &path);
+	bool writeFile(const std::filesystem::path &path, std::string_view content);
+	void forget(const std::string &url);
+	void evict(const std::string &keptHash);
+	std::filesystem::path contentPath(const std::string &contentHash) const;
+	std::filesystem::path referencePath(const std::string &url) const;
+
+ private:
+	std::filesystem::path m_directory;
+	uint64_t m_maxBytes;
+	bool m_open;
+	mutable std::mutex m_mutex;
+	std::unordered_map<std::string, Reference> m_references;
+	std::unordered_map<std::string, StoredContent> m_contents;
+	std::mt19937_64 m_random;
+	Statistics m_statistics;
+};
+}  // namespace Sharepoint
+}  // namespace Microsoft
+
+#endif  // COMMON_FILECACHE_H_
@@ -0,0 +1,259 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "HttpFixture.h"
+
+#include <cstdint>
+#include <iterator>
+#include <utility>
+
+using Microsoft::Sharepoint::HttpFixture;
+using Microsoft::Sharepoint::HttpFixtureWriter;
+using Microsoft::Sharepoint::RequestTimings;
+using Microsoft::Sharepoint::Transport;
+
+namespace {
+typedef std::vector<std::pair<std::string, std::string>> PairContainerType;
+
+void appendNumber(std::string &output, uint64_t value)
+{
+	while (value >= 0x80) {
+		output += static_cast<char>((value & 0x7F) | 0x80);
+		value >>= 7;
+	}
+	output += static_cast<char>(value);
+}
+
+void appendSigned(std::string &output, long long value)
+{
+	appendNumber(output, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+void appendString(std::string &output, std::string_view value)
+{
+	appendNumber(output, value.length());
+	output += value;
+}
+
+void appendPairs(std::string &output, const PairContainerType &pairs)
+{
+	appendNumber(output, pairs.size());
+	for (auto &pair : pairs) {
+		appendString(output, pair.first);
+		appendString(output, pair.second);
+	}
+}
+
+void appendDuration(std::string &output, std::chrono::microseconds duration)
+{
+	appendNumber(output, static_cast<uint64_t>(duration.count() > 0 ? duration.count() : 0));
+}
+
+bool readNumber(std::string_view &input, uint64_t &value)
+{
+	value = 0;
+	for (unsigned int shift = 0; shift < 64; shift += 7) {
+		if (input.empty()) {
+			return false;
+		}
+		unsigned char byte = static_cast<unsigned char>(input.front());
+		input.remove_prefix(1);
+		value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool readSigned(std::string_view &input, long long &value)
+{
+	uint64_t encoded = 0;
+	if (!readNumber(input, encoded)) {
+		return false;
+	}
+	value = static_cast<long long>((encoded >> 1) ^ (~(encoded & 1) + 1));
+	return true;
+}
+
+bool readString(std::string_view &input, std::string &value)
+{
+	uint64_t length = 0;
+	if (!readNumber(input, length) || length > input.length()) {
+		return false;
+	}
+	value.assign(input.data(), static_cast<size_t>(length));
+	input.remove_prefix(static_cast<size_t>(length));
+	return true;
+}
+
+bool readPairs(std::string_view &input, PairContainerType &pairs)
+{
+	uint64_t count = 0;
+	// every pair takes at least two bytes
+	if (!readNumber(input, count) || count > input.length() / 2) {
+		return false;
+	}
+	pairs.resize(static_cast<size_t>(count));
+	for (auto &pair : pairs) {
+		if (!readString(input, pair.first) || !readString(input, pair.second)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool readDuration(std::string_view &input, std::chrono::microseconds &duration)
+{
+	uint64_t value = 0;
+	if (!readNumber(input, value)) {
+		return false;
+	}
+	duration = std::chrono::microseconds(static_cast<long long>(value));
+	return true;
+}
+}  // namespace
+
+bool HttpFixture::load(const std::string &path, std::vector<Exchange> &exchanges)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		return false;
+	}
+	std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	std::string_view input(content);
+	if (input.substr(0, Magic.length()) != Magic ||
+		input.length() < Magic.length() + 1 || input[Magic.length()] != Version) {
+		return false;
+	}
+	input.remove_prefix(Magic.length() + 1);
+	while (!input.empty()) {
+		Exchange exchange;
+		if (!decode(input, exchange)) {
+			break;
+		}
+		exchanges.push_back(std::move(exchange));
+	}
+	return true;
+}
+
+void HttpFixture::encode(const Exchange &exchange, std::string &output)
+{
+	std::string record;
+	record.reserve(exchange.url.length() + exchange.requestBody.length() + exchange.responseBody.length() + 256);
+	appendNumber(record, exchange.method == Transport::Method::Post ? 1 : 0);
+	appendString(record, exchange.url);
+	appendPairs(record, exchange.requestHeaders);
+	appendString(record, exchange.requestCookies);
+	appendString(record, exchange.requestBody);
+	appendSigned(record, exchange.httpStatusCode);
+	appendString(record, exchange.effectiveUrl);
+	appendPairs(record, exchange.responseHeaders);
+	appendPairs(record, exchange.responseCookies);
+	appendString(record, exchange.responseBody);
+	const RequestTimings &timings = exchange.timings;
+	appendDuration(record, timings.nameLookup);
+	appendDuration(record, timings.connect);
+	appendDuration(record, timings.appConnect);
+	appendDuration(record, timings.preTransfer);
+	appendDuration(record, timings.startTransfer);
+	appendDuration(record, timings.total);
+	appendNumber(record, static_cast<uint64_t>(timings.bytesUp > 0 ? timings.bytesUp : 0));
+	appendNumber(record, static_cast<uint64_t>(timings.bytesDown > 0 ? timings.bytesDown : 0));
+	appendNumber(record, timings.connectionReused ? 1 : 0);
+	appendString(output, record);
+}
+
+bool HttpFixture::decode(std::string_view &input, Exchange &exchange)
+{
+	std::string_view remaining(input);
+	uint64_t recordLength = 0;
+	if (!readNumber(remaining, recordLength) || recordLength > remaining.length()) {
+		return false;
+	}
+	std::string_view record = remaining.substr(0, static_cast<size_t>(recordLength));
+	uint64_t method = 0;
+	long long httpStatusCode = 0;
+	uint64_t bytesUp = 0;
+	uint64_t bytesDown = 0;
+	uint64_t connectionReused = 0;
+	RequestTimings &timings = exchange.timings;
+	bool complete =
+		readNumber(record, method) &&
+		readString(record, exchange.url) &&
+		readPairs(record, exchange.requestHeaders) &&
+		readString(record, exchange.requestCookies) &&
+		readString(record, exchange.requestBody) &&
+		readSigned(record, httpStatusCode) &&
+		readString(record, exchange.effectiveUrl) &&
+		readPairs(record, exchange.responseHeaders) &&
+		readPairs(record, exchange.responseCookies) &&
+		readString(record, exchange.responseBody) &&
+		readDuration(record, timings.nameLookup) &&
+		readDuration(record, timings.connect) &&
+		readDuration(record, timings.appConnect) &&
+		readDuration(record, timings.preTransfer) &&
+		readDuration(record, timings.startTransfer) &&
+		readDuration(record, timings.total) &&
+		readNumber(record, bytesUp) &&
+		readNumber(record, bytesDown) &&
+		readNumber(record, connectionReused);
+	if (!complete) {
+		return false;
+	}
+	exchange.method = method == 1 ? Transport::Method::Post : Transport::Method::Get;
+	exchange.httpStatusCode = static_cast<long>(httpStatusCode);
+	timings.bytesUp = static_cast<long long>(bytesUp);
+	timings.bytesDown = static_cast<long long>(bytesDown);
+	timings.connectionReused = connectionReused != 0;
+	// fields appended to the record by later versions are skipped
+	input = remaining.substr(static_cast<size_t>(recordLength));
+	return true;
+}
+
+HttpFixtureWriter::HttpFixtureWriter(const std::string &path) :
+	m_file(path, std::ios::binary | std::ios::trunc)
+{
+	if (m_file) {
+		m_file.write(HttpFixture::Magic.data(), static_cast<std::streamsize>(HttpFixture::Magic.length()));
+		m_file.put(HttpFixture::Version);
+		m_file.flush();
+	}
+}
+
+bool HttpFixtureWriter::isOpen() const
+{
+	return m_file.is_open();
+}
+
+bool HttpFixtureWriter::write(const HttpFixture::Exchange &exchange)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (!m_file) {
+		return false;
+	}
+	m_buffer.clear();
+	HttpFixture::encode(exchange, m_buffer);
+	m_file.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.length()));
+	m_file.flush();
+	return static_cast<bool>(m_file);
+}
@@ -0,0 +1,107 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef COMMON_HTTPFIXTURE_H_
+#define COMMON_HTTPFIXTURE_H_
+
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "RequestTimings.h"
+#include "Transport.h"
+#include "WebRequest.h"
+#include "WebResponse.h"
+
+namespace Microsoft {
+namespace Sharepoint {
+// Recorded request/response exchanges, written by the RecordingTransport
+// and played back by the ReplayTransport.
+// A fixture file starts with the magic "SPPFIX" and a version byte,
+// followed by one record per exchange: the length of the record and its
+// fields in the order of Exchange. Numbers are written as LEB128
+// varints (the status code zigzag encoded), strings as their length and
+// their bytes, lists as their length and their elements.
+class HttpFixture
+{
+ public:
+	struct Exchange
+	{
+		Transport::Method method {Transport::Method::Get};
+		std::string url;
+		WebRequest::HeaderContainerType requestHeaders;
+		// the Cookie header which was sent
+		std::string requestCookies;
+		std::string requestBody;
+		long httpStatusCode {0};
+		std::string effectiveUrl;
+		WebResponse::HeaderContainerType responseHeaders;
+		WebResponse::CookieContainerType responseCookies;
+		std::string responseBody;
+		RequestTimings timings;
+	};
+
+ public:
+	// false if the file can't be read or isn't a fixture,
+	// the exchanges of a truncated file are loaded up to the damage
+	__declspec(dllexport)
+		static bool load(const std::string &path, std::vector<HttpFixture::Exchange> &exchanges);
+	__declspec(dllexport)
+		static void encode(const HttpFixture::Exchange &exchange, std::string &output);
+	// reads one record from the front of the input and removes it
+	__declspec(dllexport)
+		static bool decode(std::string_view &input, HttpFixture::Exchange &exchange);
+
+ public:
+	static constexpr std::string_view Magic {"SPPFIX"};
+	static constexpr char Version = 1;
+};
+
+// Appends exchanges to a new fixture file, from any thread
+class HttpFixtureWriter
+{
+ public:
+	// truncates the file
+	__declspec(dllexport)
+		explicit HttpFixtureWriter(const std::string &path);
+	HttpFixtureWriter(const HttpFixtureWriter &other) = delete;
+	HttpFixtureWriter &operator=(const HttpFixtureWriter &other) = delete;
+
+ public:
+	__declspec(dllexport)
+		bool isOpen() const;
+	// every exchange is flushed, so a crash loses at most the one being written
+	__declspec(dllexport)
+		bool write(const HttpFixture::Exchange &exchange);
+
+ private:
+	std::mutex m_mutex;
+	std::ofstream m_file;
+	std::string m_buffer;
+};
+}  // namespace Sharepoint
+}  // namespace Microsoft
+
+#endif  // COMMON_HTTPFIXTURE_H_
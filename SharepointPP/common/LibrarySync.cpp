@@ -0,0 +1,715 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "LibrarySync.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#include "ODataQuery.h"
+#include "PercentEncoding.h"
+#include "WebResponse.h"
+#include "XmlDocumentPool.h"
+#include "XmlPath.h"
+
+using Microsoft::Sharepoint::AsyncEngine;
+using Microsoft::Sharepoint::ChangeFeed;
+using Microsoft::Sharepoint::LibrarySync;
+using Microsoft::Sharepoint::PercentEncoding;
+using Microsoft::Sharepoint::SyncIndex;
+using Microsoft::Sharepoint::WebResponse;
+using Microsoft::Sharepoint::XmlDocumentPool;
+using Microsoft::Sharepoint::XmlPath;
+
+namespace fs = std::filesystem;
+
+namespace {
+const char *const stateDirectoryName = ".sync";
+
+const XmlPath::NamespaceContainerType &feedNamespaces()
+{
+	static const XmlPath::NamespaceContainerType namespaces {
+		{"d", "http://schemas.microsoft.com/ado/2007/08/dataservices"},
+		{"m", "http://schemas.microsoft.com/ado/2007/08/dataservices/metadata"}
+	};
+	return namespaces;
+}
+
+int64_t modificationTime(const fs::path &path)
+{
+	std::error_code error;
+	fs::file_time_type time = fs::last_write_time(path, error);
+	return error ? 0 : static_cast<int64_t>(time.time_since_epoch().count());
+}
+
+bool startsWithFolder(const std::string &path, const std::string &folder)
+{
+	return path.length() > folder.length() &&
+		path.compare(0, folder.length(), folder) == 0 &&
+		path[folder.length()] == '/';
+}
+}  // namespace
+
+struct LibrarySync::Download
+{
+	Item item;
+	fs::path temporaryPath;
+	std::ofstream file;
+	uint64_t written {0};
+	// the server ignored the range and sent the whole file
+	bool whole {false};
+	bool failed {false};
+};
+
+LibrarySync::LibrarySync(const WebRequest &request, const std::string &webUrl, const std::string &listTitle, const fs::path &directory) :
+	m_request(request),
+	m_webUrl(webUrl),
+	m_listUrl(),
+	m_directory(directory),
+	m_stateDirectory(directory / stateDirectoryName),
+	m_rootFolder(),
+	m_chunkSize(DefaultChunkSize),
+	m_parallelDownloads(DefaultParallelDownloads),
+	m_pageSize(DefaultPageSize),
+	m_index(directory / stateDirectoryName / "index"),
+	m_engine(),
+	m_planned(),
+	m_retries(),
+	m_failed(false),
+	m_statistics()
+{
+	while (!m_webUrl.empty() && m_webUrl.back() == '/') {
+		m_webUrl.pop_back();
+	}
+	// quotes are doubled inside the odata string literal
+	std::string quotedTitle;
+	for (char c : listTitle) {
+		quotedTitle += c;
+		if (c == '\'') {
+			quotedTitle += c;
+		}
+	}
+	m_listUrl = m_webUrl + "/_api/web/lists/getbytitle('";
+	PercentEncoding::appendEncoded(quotedTitle, m_listUrl);
+	m_listUrl += "')";
+}
+
+LibrarySync::~LibrarySync()
+{
+}
+
+void LibrarySync::setChunkSize(uint64_t chunkSize)
+{
+	m_chunkSize = chunkSize > 0 ? chunkSize : DefaultChunkSize;
+}
+
+void LibrarySync::setParallelDownloads(size_t parallelDownloads)
+{
+	m_parallelDownloads = parallelDownloads > 0 ? parallelDownloads : 1;
+}
+
+void LibrarySync::setPageSize(size_t pageSize)
+{
+	m_pageSize = pageSize > 0 ? pageSize : DefaultPageSize;
+}
+
+bool LibrarySync::sync()
+{
+	m_statistics = Statistics();
+	m_failed = false;
+	m_planned.clear();
+
+	std::error_code error;
+	fs::path temporaryDirectory = m_stateDirectory / "tmp";
+	fs::create_directories(temporaryDirectory, error);
+	if (error) {
+		return false;
+	}
+	// the downloads of an interrupted sync start over
+	for (fs::directory_iterator entry(temporaryDirectory, error), end;
+		!error && entry != end;
+		entry.increment(error)) {
+		std::error_code removeError;
+		fs::remove(entry->path(), removeError);
+	}
+	fs::path checkpointPath = m_stateDirectory / "changes.token";
+	if (!m_index.load()) {
+		// a damaged index can't tell what is mirrored, the library is listed again
+		m_index.clear();
+		fs::remove(checkpointPath, error);
+	}
+	if (!loadRetries()) {
+		// nor can a damaged retry list tell what is missing
+		fs::remove(checkpointPath, error);
+	}
+	if (!readRootFolder()) {
+		return false;
+	}
+
+	m_engine = std::make_unique<AsyncEngine>(static_cast<long>(m_parallelDownloads));
+	ChangeFeed feed(m_request, Url(m_listUrl), checkpointPath);
+	feed.setPageSize(m_pageSize);
+	bool synchronized = false;
+	if (feed.loadCheckpoint()) {
+		synchronized = retryFailed();
+		synchronized = feed.follow([this](const std::vector<ChangeFeed::Change> &changes) {
+			return applyChanges(changes);
+		}) && synchronized;
+	} else {
+		// the changes made while listing are read again by the next sync,
+		// the listing looks at every item the retry list holds
+		m_retries.clear();
+		synchronized = feed.startAtCurrentToken() && listAll() && feed.saveCheckpoint();
+	}
+	m_engine.reset();
+	return synchronized && !m_failed;
+}
+
+LibrarySync::Statistics LibrarySync::statistics() const
+{
+	return m_statistics;
+}
+
+bool LibrarySync::readRootFolder()
+{
+	static const XmlPath serverRelativeUrlPath("content/m:properties/d:ServerRelativeUrl", feedNamespaces());
+	WebResponse response = m_request.get(Url(m_listUrl + "/RootFolder"));
+	if (response.httpStatusCode() != 200) {
+		return false;
+	}
+	XmlDocumentPool::DocumentLease doc(XmlDocumentPool::document());
+	if (doc->ParseInSitu(response.takeResponse()) != tinyxml2::XML_SUCCESS) {
+		return false;
+	}
+	const tinyxml2::XMLElement *entry = doc->FirstChildElement("entry");
+	const char *serverRelativeUrl = entry != nullptr ? serverRelativeUrlPath.text(*entry) : nullptr;
+	if (serverRelativeUrl == nullptr) {
+		return false;
+	}
+	m_rootFolder = serverRelativeUrl;
+	while (!m_rootFolder.empty() && m_rootFolder.back() == '/') {
+		m_rootFolder.pop_back();
+	}
+	return true;
+}
+
+bool LibrarySync::listAll()
+{
+	std::unordered_set<long> listed;
+	std::string next = OData::query(
+		OData::select("Id", "FileRef", "File_x0020_Size", "FileSystemObjectType", "File/Length", "File/TimeLastModified"),
+		OData::expand("File"),
+		OData::top(m_pageSize)).url(m_listUrl, "/items").str();
+	while (!next.empty()) {
+		WebResponse response = m_request.get(Url(next));
+		if (response.httpStatusCode() != 200) {
+			return false;
+		}
+		next.clear();
+		XmlDocumentPool::DocumentLease doc(XmlDocumentPool::document());
+		if (doc->ParseInSitu(response.takeResponse()) != tinyxml2::XML_SUCCESS) {
+			return false;
+		}
+		const tinyxml2::XMLElement *feed = doc->FirstChildElement("feed");
+		if (feed == nullptr) {
+			return false;
+		}
+		for (const tinyxml2::XMLElement *entry = feed->FirstChildElement("entry");
+			entry != nullptr;
+			entry = entry->NextSiblingElement("entry")) {
+			Item item;
+			if (parseItem(*entry, item)) {
+				++m_statistics.listedItems;
+				listed.insert(item.id);
+				plan(item);
+			}
+		}
+		for (const tinyxml2::XMLElement *link = feed->FirstChildElement("link");
+			link != nullptr;
+			link = link->NextSiblingElement("link")) {
+			if (link->Attribute("rel", "next") && link->Attribute("href") != nullptr) {
+				next = link->Attribute("href");
+			}
+		}
+		downloadPlanned();
+		if (!m_index.save()) {
+			return false;
+		}
+	}
+
+	// what the listing didn't show is gone from the library
+	std::vector<long> removed;
+	for (auto &entry : m_index.entries()) {
+		if (listed.count(entry.first) == 0) {
+			removed.push_back(entry.first);
+		}
+	}
+	for (long itemId : removed) {
+		remove(itemId);
+	}
+	// the items which failed are on the retry list, the change token is
+	// saved anyway
+	return m_index.save() && saveRetries();
+}
+
+bool LibrarySync::applyChanges(const std::vector<ChangeFeed::Change> &changes)
+{
+	// only the last change of an item matters, its current state is looked up
+	std::vector<long> changedItems;
+	std::unordered_map<long, bool> gone;
+	for (auto &change : changes) {
+		++m_statistics.changes;
+		if (change.itemId <= 0) {
+			continue;
+		}
+		bool removed = change.type == ChangeFeed::ChangeType::DeleteObject ||
+			change.type == ChangeFeed::ChangeType::MoveAway;
+		if (gone.find(change.itemId) == gone.end()) {
+			changedItems.push_back(change.itemId);
+		}
+		gone[change.itemId] = removed;
+	}
+	std::vector<long> lookups;
+	for (long itemId : changedItems) {
+		if (gone[itemId]) {
+			remove(itemId);
+		} else {
+			lookups.push_back(itemId);
+		}
+	}
+	// the items which fail go to the retry list, the token advances anyway
+	lookupItems(lookups);
+	downloadPlanned();
+	return m_index.save() && saveRetries();
+}
+
+bool LibrarySync::retryFailed()
+{
+	if (m_retries.empty()) {
+		return true;
+	}
+	// the ones failing again are put back
+	std::vector<long> itemIds(m_retries.begin(), m_retries.end());
+	m_retries.clear();
+	m_statistics.retried += itemIds.size();
+	bool retried = lookupItems(itemIds);
+	retried = downloadPlanned() && retried;
+	return m_index.save() && saveRetries() && retried;
+}
+
+bool LibrarySync::loadRetries()
+{
+	m_retries.clear();
+	std::ifstream file(m_stateDirectory / "retries", std::ios::binary);
+	if (!file) {
+		return true;
+	}
+	std::string line;
+	while (std::getline(file, line)) {
+		char *end = nullptr;
+		long itemId = strtol(line.c_str(), &end, 10);
+		if (itemId <= 0 || *end != '\0') {
+			m_retries.clear();
+			return false;
+		}
+		m_retries.insert(itemId);
+	}
+	return true;
+}
+
+bool LibrarySync::saveRetries() const
+{
+	fs::path path = m_stateDirectory / "retries";
+	fs::path temporaryPath(path);
+	temporaryPath += ".tmp";
+	{
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		for (long itemId : m_retries) {
+			file << itemId << '\n';
+		}
+		file.close();
+		if (!file) {
+			std::error_code error;
+			fs::remove(temporaryPath, error);
+			return false;
+		}
+	}
+	std::error_code error;
+	fs::rename(temporaryPath, path, error);
+	if (error) {
+		fs::remove(temporaryPath, error);
+		return false;
+	}
+	return true;
+}
+
+bool LibrarySync::lookupItems(const std::vector<long> &itemIds)
+{
+	struct Lookup
+	{
+		long httpStatusCode {0};
+		Item item;
+		bool parsed {false};
+	};
+	// filled on the engine thread, read after wait()
+	std::vector<Lookup> lookups(itemIds.size());
+	for (size_t i = 0; i < itemIds.size(); ++i) {
+		std::string resource = "/items(" + std::to_string(itemIds[i]) + ")";
+		Url url = OData::query(
+			OData::select("Id", "FileRef", "File_x0020_Size", "FileSystemObjectType", "File/Length", "File/TimeLastModified"),
+			OData::expand("File")).url(m_listUrl, resource);
+		Lookup *lookup = &lookups[i];
+		m_engine->get(m_request, url, [lookup](WebResponse &&response) {
+			lookup->httpStatusCode = response.httpStatusCode();
+			if (lookup->httpStatusCode != 200) {
+				return;
+			}
+			XmlDocumentPool::DocumentLease doc(XmlDocumentPool::document());
+			if (doc->ParseInSitu(response.takeResponse()) == tinyxml2::XML_SUCCESS) {
+				const tinyxml2::XMLElement *entry = doc->FirstChildElement("entry");
+				lookup->parsed = entry != nullptr && parseItem(*entry, lookup->item);
+			}
+		});
+	}
+	m_engine->wait();
+
+	bool complete = true;
+	for (size_t i = 0; i < lookups.size(); ++i) {
+		if (lookups[i].httpStatusCode == 404) {
+			// deleted after the change was logged
+			remove(itemIds[i]);
+		} else if (lookups[i].parsed) {
+			plan(lookups[i].item);
+		} else {
+			++m_statistics.failed;
+			m_retries.insert(itemIds[i]);
+			complete = false;
+		}
+	}
+	if (!complete) {
+		m_failed = true;
+	}
+	return complete;
+}
+
+void LibrarySync::plan(const Item &item)
+{
+	Item planned(item);
+	if (!relativePath(item.fileRef, planned.path)) {
+		// outside of the library or not a valid local name, left alone
+		return;
+	}
+	std::error_code error;
+	const SyncIndex::Entry *known = m_index.find(item.id);
+	if (item.folder) {
+		if (known != nullptr && known->folder && known->path != planned.path) {
+			moveFolder(known->path, planned.path);
+		}
+		fs::create_directories(localPath(planned.path), error);
+		SyncIndex::Entry entry;
+		entry.path = planned.path;
+		entry.etag = item.etag;
+		entry.folder = true;
+		m_index.set(item.id, std::move(entry));
+		return;
+	}
+	if (known != nullptr && !known->folder && hasSameContent(*known, item) && isIntact(*known)) {
+		SyncIndex::Entry entry(*known);
+		entry.etag = item.etag;
+		if (!item.contentVersion.empty()) {
+			entry.contentVersion = item.contentVersion;
+		}
+		if (known->path == planned.path) {
+			// at most the metadata changed
+			m_index.set(item.id, std::move(entry));
+			++m_statistics.unchanged;
+			return;
+		}
+		// renamed or moved, the content is the same
+		fs::path target = localPath(planned.path);
+		fs::create_directories(target.parent_path(), error);
+		fs::rename(localPath(known->path), target, error);
+		if (!error) {
+			entry.path = planned.path;
+			m_index.set(item.id, std::move(entry));
+			++m_statistics.moved;
+			return;
+		}
+	}
+	m_planned.push_back(std::move(planned));
+}
+
+bool LibrarySync::downloadPlanned()
+{
+	bool complete = true;
+	size_t next = 0;
+	while (next < m_planned.size()) {
+		// keeps the engine busy without holding every planned file open
+		std::vector<std::unique_ptr<Download>> batch;
+		uint64_t chunks = 0;
+		while (next < m_planned.size() && chunks < m_parallelDownloads * 2) {
+			auto download = std::make_unique<Download>();
+			download->item = m_planned[next++];
+			download->temporaryPath = m_stateDirectory / "tmp" / std::to_string(download->item.id);
+			download->file.open(download->temporaryPath, std::ios::binary | std::ios::trunc);
+			if (!download->file) {
+				++m_statistics.failed;
+				m_retries.insert(download->item.id);
+				complete = false;
+				continue;
+			}
+			chunks += chunkCount(download->item.size);
+			batch.push_back(std::move(download));
+		}
+		for (auto &download : batch) {
+			startDownload(*download);
+		}
+		m_engine->wait();
+		for (auto &download : batch) {
+			if (!finishDownload(*download)) {
+				m_retries.insert(download->item.id);
+				complete = false;
+			}
+		}
+	}
+	m_planned.clear();
+	if (!complete) {
+		m_failed = true;
+	}
+	return complete;
+}
+
+void LibrarySync::startDownload(Download &download)
+{
+	Url url(m_listUrl + "/items(" + std::to_string(download.item.id) + ")/File/$value");
+	uint64_t count = chunkCount(download.item.size);
+	for (uint64_t chunk = 0; chunk < count; ++chunk) {
+		uint64_t offset = chunk * m_chunkSize;
+		uint64_t length = count == 1 ? download.item.size : std::min(m_chunkSize, download.item.size - offset);
+		WebRequest chunkRequest(m_request);
+		if (count > 1) {
+			chunkRequest.addHeader("Range",
+				"bytes=" + std::to_string(offset) + "-" + std::to_string(offset + length - 1));
+		}
+		++m_statistics.chunks;
+		// the completions run one after the other on the engine thread
+		m_engine->get(chunkRequest, url, [&download, offset, length](WebResponse &&response) {
+			long httpStatusCode = response.httpStatusCode();
+			std::shared_ptr<const std::string> body = response.sharedResponse();
+			if (httpStatusCode == 206 && body->length() == length) {
+				download.file.seekp(static_cast<std::streamoff>(offset));
+				download.file.write(body->data(), static_cast<std::streamsize>(body->length()));
+				download.written += body->length();
+			} else if (httpStatusCode == 200) {
+				if (!download.whole) {
+					download.whole = true;
+					download.file.seekp(0);
+					download.file.write(body->data(), static_cast<std::streamsize>(body->length()));
+					download.written = body->length();
+				}
+			} else {
+				download.failed = true;
+			}
+		});
+	}
+}
+
+bool LibrarySync::finishDownload(Download &download)
+{
+	download.file.close();
+	std::error_code error;
+	bool complete = !download.failed && !download.file.fail() &&
+		(download.whole || download.written == download.item.size);
+	if (!complete) {
+		fs::remove(download.temporaryPath, error);
+		++m_statistics.failed;
+		return false;
+	}
+	fs::path target = localPath(download.item.path);
+	fs::create_directories(target.parent_path(), error);
+	const SyncIndex::Entry *known = m_index.find(download.item.id);
+	if (known != nullptr && !known->folder && known->path != download.item.path) {
+		// renamed and changed
+		fs::remove(localPath(known->path), error);
+	}
+	fs::rename(download.temporaryPath, target, error);
+	if (error) {
+		fs::remove(download.temporaryPath, error);
+		++m_statistics.failed;
+		return false;
+	}
+	SyncIndex::Entry entry;
+	entry.path = download.item.path;
+	entry.etag = download.item.etag;
+	entry.contentVersion = download.item.contentVersion;
+	entry.size = download.written;
+	entry.modified = modificationTime(target);
+	m_index.set(download.item.id, std::move(entry));
+	++m_statistics.downloads;
+	m_statistics.downloadedBytes += download.written;
+	return true;
+}
+
+void LibrarySync::moveFolder(const std::string &from, const std::string &to)
+{
+	// moves the mirrored files one by one, the folder may already hold
+	// some of them if they were looked at first
+	std::vector<std::pair<long, SyncIndex::Entry>> moved;
+	for (auto &entry : m_index.entries()) {
+		if (!startsWithFolder(entry.second.path, from)) {
+			continue;
+		}
+		SyncIndex::Entry movedEntry(entry.second);
+		movedEntry.path = to + entry.second.path.substr(from.length());
+		std::error_code error;
+		fs::path target = localPath(movedEntry.path);
+		if (movedEntry.folder) {
+			fs::create_directories(target, error);
+		} else {
+			fs::create_directories(target.parent_path(), error);
+			fs::rename(localPath(entry.second.path), target, error);
+		}
+		moved.push_back(std::pair<long, SyncIndex::Entry>(entry.first, std::move(movedEntry)));
+	}
+	for (auto &entry : moved) {
+		m_index.set(entry.first, std::move(entry.second));
+	}
+	std::error_code error;
+	fs::remove_all(localPath(from), error);
+}
+
+void LibrarySync::remove(long itemId)
+{
+	const SyncIndex::Entry *known = m_index.find(itemId);
+	if (known == nullptr) {
+		return;
+	}
+	std::error_code error;
+	if (known->folder) {
+		std::vector<long> contained;
+		for (auto &entry : m_index.entries()) {
+			if (startsWithFolder(entry.second.path, known->path)) {
+				contained.push_back(entry.first);
+			}
+		}
+		fs::remove_all(localPath(known->path), error);
+		for (long containedId : contained) {
+			m_index.erase(containedId);
+		}
+	} else {
+		fs::remove(localPath(known->path), error);
+	}
+	m_index.erase(itemId);
+	++m_statistics.deleted;
+}
+
+bool LibrarySync::isIntact(const SyncIndex::Entry &entry) const
+{
+	fs::path path = localPath(entry.path);
+	std::error_code error;
+	uint64_t size = fs::file_size(path, error);
+	return !error && size == entry.size && modificationTime(path) == entry.modified;
+}
+
+bool LibrarySync::hasSameContent(const SyncIndex::Entry &entry, const Item &item)
+{
+	if (!entry.contentVersion.empty() && !item.contentVersion.empty()) {
+		return entry.contentVersion == item.contentVersion;
+	}
+	// an index of an older version or a server which didn't expand the file
+	return entry.etag == item.etag;
+}
+
+bool LibrarySync::relativePath(const std::string &fileRef, std::string &path) const
+{
+	if (!startsWithFolder(fileRef, m_rootFolder)) {
+		return false;
+	}
+	path = fileRef.substr(m_rootFolder.length() + 1);
+	// every part has to stay inside the directory and outside of the state
+	size_t partStart = 0;
+	while (partStart <= path.length()) {
+		size_t partEnd = path.find('/', partStart);
+		if (partEnd == std::string::npos) {
+			partEnd = path.length();
+		}
+		std::string part = path.substr(partStart, partEnd - partStart);
+		if (part.empty() || part == "." || part == ".." ||
+			part.find_first_of("\\:") != std::string::npos ||
+			(partStart == 0 && part == stateDirectoryName)) {
+			return false;
+		}
+		partStart = partEnd + 1;
+	}
+	return true;
+}
+
+fs::path LibrarySync::localPath(const std::string &path) const
+{
+	return m_directory / fs::u8path(path);
+}
+
+uint64_t LibrarySync::chunkCount(uint64_t size) const
+{
+	return size > m_chunkSize ? (size + m_chunkSize - 1) / m_chunkSize : 1;
+}
+
+bool LibrarySync::parseItem(const tinyxml2::XMLElement &entry, Item &item)
+{
+	static const XmlPath propertiesPath("content/m:properties", feedNamespaces());
+	static const XmlPath idPath("d:Id", feedNamespaces());
+	static const XmlPath fileRefPath("d:FileRef", feedNamespaces());
+	static const XmlPath sizePath("d:File_x0020_Size", feedNamespaces());
+	static const XmlPath typePath("d:FileSystemObjectType", feedNamespaces());
+	static const XmlPath fileLengthPath(
+		"link/m:inline/entry/content/m:properties/d:Length", feedNamespaces());
+	static const XmlPath fileModifiedPath(
+		"link/m:inline/entry/content/m:properties/d:TimeLastModified", feedNamespaces());
+	const tinyxml2::XMLElement *properties = propertiesPath.first(entry);
+	if (properties == nullptr) {
+		return false;
+	}
+	const char *id = idPath.text(*properties);
+	const char *fileRef = fileRefPath.text(*properties);
+	if (id == nullptr || fileRef == nullptr) {
+		return false;
+	}
+	item.id = strtol(id, nullptr, 10);
+	item.fileRef = fileRef;
+	const char *etag = entry.Attribute("m:etag");
+	item.etag = etag != nullptr ? etag : std::string();
+	const char *size = sizePath.text(*properties);
+	item.size = size != nullptr ? strtoull(size, nullptr, 10) : 0;
+	const char *type = typePath.text(*properties);
+	item.folder = type != nullptr && strtol(type, nullptr, 10) == 1;
+	const char *fileLength = fileLengthPath.text(entry);
+	const char *fileModified = fileModifiedPath.text(entry);
+	if (!item.folder && fileLength != nullptr && fileModified != nullptr) {
+		item.contentVersion = std::string(fileLength) + '@' + fileModified;
+	}
+	return item.id > 0;
+}
@@ -0,0 +1,182 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef COMMON_LIBRARYSYNC_H_
+#define COMMON_LIBRARYSYNC_H_
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "AsyncEngine.h"
+#include "ChangeFeed.h"
+#include "SyncIndex.h"
+#include "WebRequest.h"
+#include "tinyxml2.h"
+
+namespace Microsoft {
+namespace Sharepoint {
+// Mirrors a document library into a local directory, e.g.
+//   LibrarySync sync(auth.getPreparedRequest(), "https://contoso.sharepoint.com/sites/team",
+//       "Documents", "C:\\Mirror\\Documents");
+//   sync.sync();
+// The first sync lists every item of the library, later ones only read
+// the change log (ChangeFeed) and look at the items changed since. A file
+// is downloaded only if its content version (length and time of the last
+// change of the file) differs from the one in the SyncIndex or its local
+// copy was changed or removed (noticed when the item is looked at). The
+// item etag changes with edits of the metadata as well, it only decides
+// if the server doesn't tell the content version. Renamed and moved files
+// whose content didn't change are moved locally.
+// Files are downloaded by the AsyncEngine, several at a time, a large one
+// in byte ranges (Range) which are written at their offsets into a
+// temporary file. The file is renamed to its place once it is complete.
+// The state (the index, the change token and the temporary files) is
+// kept in the .sync directory of the mirror. The index is saved after
+// each page of items or changes, the change token only after all changes
+// of its page are applied, so an interrupted sync continues where it
+// stopped: files already mirrored aren't downloaded again.
+// An item whose lookup or download fails doesn't hold the change token
+// back, its id goes to the retry list in the .sync directory and the
+// next sync looks at it again before it reads the changes.
+class LibrarySync
+{
+ public:
+	struct Statistics
+	{
+		// items read from the library listing
+		uint64_t listedItems {0};
+		// entries read from the change log
+		uint64_t changes {0};
+		uint64_t downloads {0};
+		uint64_t downloadedBytes {0};
+		// range requests, a file of one chunk counts once
+		uint64_t chunks {0};
+		// files whose local copy was up to date
+		uint64_t unchanged {0};
+		uint64_t moved {0};
+		uint64_t deleted {0};
+		uint64_t failed {0};
+		// items of the retry list looked at again
+		uint64_t retried {0};
+	};
+
+ public:
+	static constexpr uint64_t DefaultChunkSize = 8 * 1024 * 1024;
+	static constexpr size_t DefaultParallelDownloads = 8;
+	static constexpr size_t DefaultPageSize = 500;
+
+ public:
+	// webUrl is the url of the site holding the library, the request has
+	// to carry the cookies and the request digest
+	__declspec(dllexport)
+		LibrarySync(const WebRequest &request, const std::string &webUrl, const std::string &listTitle, const std::filesystem::path &directory);
+	__declspec(dllexport)
+		~LibrarySync();
+	LibrarySync(const LibrarySync &other) = delete;
+	LibrarySync &operator=(const LibrarySync &other) = delete;
+
+ public:
+	// files larger than this are downloaded in ranges of this size
+	__declspec(dllexport)
+		void setChunkSize(uint64_t chunkSize);
+	// the connections used for downloads and item lookups
+	__declspec(dllexport)
+		void setParallelDownloads(size_t parallelDownloads);
+	// the items of a listing page and the changes of a change log page
+	__declspec(dllexport)
+		void setPageSize(size_t pageSize);
+
+ public:
+	// brings the directory up to date, false if a request or a local file
+	// operation failed, the next sync retries the failed items
+	__declspec(dllexport)
+		bool sync();
+	// of the last sync
+	__declspec(dllexport)
+		LibrarySync::Statistics statistics() const;
+
+ private:
+	// the state of an item on the server
+	struct Item
+	{
+		long id {0};
+		std::string etag;
+		// <length>@<time last modified> of the file, empty for a folder
+		std::string contentVersion;
+		std::string fileRef;
+		// local, relative to the directory, set by plan()
+		std::string path;
+		uint64_t size {0};
+		bool folder {false};
+	};
+
+	struct Download;
+
+ private:
+	bool readRootFolder();
+	bool listAll();
+	bool applyChanges(const std::vector<ChangeFeed::Change> &changes);
+	bool retryFailed();
+	// a missing file gives none, false if the file is damaged
+	bool loadRetries();
+	bool saveRetries() const;
+	bool lookupItems(const std::vector<long> &itemIds);
+	void plan(const Item &item);
+	bool downloadPlanned();
+	void startDownload(Download &download);
+	bool finishDownload(Download &download);
+	void moveFolder(const std::string &from, const std::string &to);
+	void remove(long itemId);
+	bool isIntact(const SyncIndex::Entry &entry) const;
+	static bool hasSameContent(const SyncIndex::Entry &entry, const Item &item);
+	bool relativePath(const std::string &fileRef, std::string &path) const;
+	std::filesystem::path localPath(const std::string &path) const;
+	uint64_t chunkCount(uint64_t size) const;
+	static bool parseItem(const tinyxml2::XMLElement &entry, Item &item);
+
+ private:
+	WebRequest m_request;
+	std::string m_webUrl;
+	std::string m_listUrl;
+	std::filesystem::path m_directory;
+	std::filesystem::path m_stateDirectory;
+	std::string m_rootFolder;
+	uint64_t m_chunkSize;
+	size_t m_parallelDownloads;
+	size_t m_pageSize;
+	SyncIndex m_index;
+	std::unique_ptr<AsyncEngine> m_engine;
+	std::vector<Item> m_planned;
+	// items whose lookup or download failed
+	std::set<long> m_retries;
+	bool m_failed;
+	Statistics m_statistics;
+};
+}  // namespace Sharepoint
+}  // namespace Microsoft
+
+#endif  // COMMON_LIBRARYSYNC_H_
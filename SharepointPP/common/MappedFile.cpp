@@ -0,0 +1,119 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using Microsoft::Sharepoint::MappedFile;
+
+MappedFile::MappedFile() :
+	m_data(nullptr),
+	m_size(0)
+#ifdef _WIN32
+	, m_mapping(nullptr)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef _WIN32
+	if (m_data != nullptr) {
+		UnmapViewOfFile(m_data);
+	}
+	if (m_mapping != nullptr) {
+		CloseHandle(m_mapping);
+	}
+#else
+	if (m_data != nullptr) {
+		munmap(const_cast<char *>(m_data), m_size);
+	}
+#endif
+}
+
+std::shared_ptr<MappedFile> MappedFile::open(const std::string &path)
+{
+	std::shared_ptr<MappedFile> file(new MappedFile());
+#ifdef _WIN32
+	HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+		nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle == INVALID_HANDLE_VALUE) {
+		return nullptr;
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(handle, &size)) {
+		CloseHandle(handle);
+		return nullptr;
+	}
+	file->m_size = static_cast<size_t>(size.QuadPart);
+	// an empty file can't be mapped, its view stays empty
+	if (file->m_size > 0) {
+		file->m_mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (file->m_mapping != nullptr) {
+			file->m_data = static_cast<const char *>(MapViewOfFile(file->m_mapping, FILE_MAP_READ, 0, 0, 0));
+		}
+	}
+	// the mapping keeps the file open
+	CloseHandle(handle);
+#else
+	int descriptor = ::open(path.c_str(), O_RDONLY);
+	if (descriptor < 0) {
+		return nullptr;
+	}
+	struct stat status;
+	if (fstat(descriptor, &status) != 0) {
+		close(descriptor);
+		return nullptr;
+	}
+	file->m_size = static_cast<size_t>(status.st_size);
+	if (file->m_size > 0) {
+		void *data = mmap(nullptr, file->m_size, PROT_READ, MAP_SHARED, descriptor, 0);
+		if (data != MAP_FAILED) {
+			file->m_data = static_cast<const char *>(data);
+		}
+	}
+	// the mapping keeps the file open
+	close(descriptor);
+#endif
+	if (file->m_size > 0 && file->m_data == nullptr) {
+		return nullptr;
+	}
+	return file;
+}
+
+std::string_view MappedFile::view() const
+{
+	return std::string_view(m_data, m_size);
+}
+
+size_t MappedFile::size() const
+{
+	return m_size;
+}
@@ -0,0 +1,66 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef COMMON_MAPPEDFILE_H_
+#define COMMON_MAPPEDFILE_H_
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace Microsoft {
+namespace Sharepoint {
+// A whole file mapped read only into memory, the pages are read on first
+// access and shared with the page cache of the system
+class MappedFile
+{
+ public:
+	// nullptr if the file can't be opened or mapped
+	__declspec(dllexport)
+		static std::shared_ptr<MappedFile> open(const std::string &path);
+	__declspec(dllexport)
+		~MappedFile();
+	MappedFile(const MappedFile &other) = delete;
+	MappedFile &operator=(const MappedFile &other) = delete;
+
+ public:
+	// valid as long as the object lives
+	__declspec(dllexport)
+		std::string_view view() const;
+	__declspec(dllexport)
+		size_t size() const;
+
+ private:
+	MappedFile();
+
+ private:
+	const char *m_data;
+	size_t m_size;
+#ifdef _WIN32
+	void *m_mapping;
+#endif
+};
+}  // namespace Sharepoint
+}  // namespace Microsoft
+
+#endif  // COMMON_MAPPEDFILE_H_
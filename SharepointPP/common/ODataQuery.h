@@ -0,0 +1,294 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef COMMON_ODATAQUERY_H_
+#define COMMON_ODATAQUERY_H_
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+
+#include "PercentEncoding.h"
+#include "Url.h"
+
+// Builder for the OData query options of the sharepoint rest api, e.g.
+//   Url url = OData::query(
+//       OData::select("Id", "Title"),
+//       OData::filter("Title eq 'Budget'"),
+//       OData::top(100)).url(host, "/_api/web/lists/getbytitle('Documents')/items");
+// The structure is checked at compile time: unknown options and options
+// used twice don't compile. The option keys are constants, the values are
+// percent-encoded exactly once while the url is written into a buffer of
+// the precomputed length.
+// The query only refers to the passed values, so build the url before
+// the strings they point to go away.
+namespace Microsoft {
+namespace Sharepoint {
+namespace OData {
+template<class Tag, size_t N>
+struct FieldList
+{
+	std::array<std::string_view, N> fields;
+};
+
+struct SelectTag
+{
+	static constexpr std::string_view Key {"$select="};
+};
+
+struct ExpandTag
+{
+	static constexpr std::string_view Key {"$expand="};
+};
+
+struct OrderByTag
+{
+	static constexpr std::string_view Key {"$orderby="};
+};
+
+template<size_t N>
+using Select = FieldList<SelectTag, N>;
+template<size_t N>
+using Expand = FieldList<ExpandTag, N>;
+// every field is "Name" or "Name asc" / "Name desc"
+template<size_t N>
+using OrderBy = FieldList<OrderByTag, N>;
+
+struct Filter
+{
+	std::string_view expression;
+};
+
+struct Top
+{
+	unsigned long long count;
+};
+
+template<class ...Fields>
+constexpr Select<sizeof...(Fields)> select(const Fields &...fields)
+{
+	static_assert(sizeof...(Fields) > 0, "$select needs at least one field");
+	return Select<sizeof...(Fields)> {{{std::string_view(fields)...}}};
+}
+
+template<class ...Fields>
+constexpr Expand<sizeof...(Fields)> expand(const Fields &...fields)
+{
+	static_assert(sizeof...(Fields) > 0, "$expand needs at least one field");
+	return Expand<sizeof...(Fields)> {{{std::string_view(fields)...}}};
+}
+
+template<class ...Fields>
+constexpr OrderBy<sizeof...(Fields)> orderBy(const Fields &...fields)
+{
+	static_assert(sizeof...(Fields) > 0, "$orderby needs at least one field");
+	return OrderBy<sizeof...(Fields)> {{{std::string_view(fields)...}}};
+}
+
+constexpr Filter filter(std::string_view expression)
+{
+	return Filter {expression};
+}
+
+constexpr Top top(unsigned long long count)
+{
+	return Top {count};
+}
+
+namespace detail {
+template<class Option>
+struct OptionTraits
+{
+	static constexpr bool IsOption = false;
+	static constexpr std::string_view Key {};
+};
+
+template<class Tag, size_t N>
+struct OptionTraits<FieldList<Tag, N>>
+{
+	static constexpr bool IsOption = true;
+	static constexpr std::string_view Key {Tag::Key};
+
+	static size_t valueLength(const FieldList<Tag, N> &option)
+	{
+		size_t length = N - 1;
+		for (std::string_view field : option.fields) {
+			length += PercentEncoding::encodedLength(field);
+		}
+		return length;
+	}
+
+	static char *writeValue(const FieldList<Tag, N> &option, char *output)
+	{
+		for (size_t i = 0; i < N; ++i) {
+			if (i > 0) {
+				*output++ = ',';
+			}
+			output = PercentEncoding::encode(option.fields[i], output);
+		}
+		return output;
+	}
+};
+
+template<>
+struct OptionTraits<Filter>
+{
+	static constexpr bool IsOption = true;
+	static constexpr std::string_view Key {"$filter="};
+
+	static size_t valueLength(const Filter &option)
+	{
+		return PercentEncoding::encodedLength(option.expression);
+	}
+
+	static char *writeValue(const Filter &option, char *output)
+	{
+		return PercentEncoding::encode(option.expression, output);
+	}
+};
+
+template<>
+struct OptionTraits<Top>
+{
+	static constexpr bool IsOption = true;
+	static constexpr std::string_view Key {"$top="};
+
+	static size_t valueLength(const Top &option)
+	{
+		size_t length = 1;
+		for (unsigned long long count = option.count; count >= 10; count /= 10) {
+			++length;
+		}
+		return length;
+	}
+
+	static char *writeValue(const Top &option, char *output)
+	{
+		// valueLength() has reserved exactly the needed digits
+		return std::to_chars(output, output + 20, option.count).ptr;
+	}
+};
+
+template<class ...Options>
+constexpr bool hasUniqueKeys()
+{
+	std::array<std::string_view, sizeof...(Options)> keys {{OptionTraits<Options>::Key...}};
+	for (size_t i = 0; i < keys.size(); ++i) {
+		for (size_t j = i + 1; j < keys.size(); ++j) {
+			if (keys[i] == keys[j]) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+}  // namespace detail
+
+template<class ...Options>
+class Query
+{
+	static_assert(
+		(detail::OptionTraits<Options>::IsOption && ...),
+		"only $select, $filter, $top, $expand and $orderby are supported");
+	static_assert(
+		detail::hasUniqueKeys<Options...>(),
+		"every query option may only be used once");
+
+ public:
+	constexpr explicit Query(const Options &...options) :
+		m_options(options...)
+	{
+	}
+
+ public:
+	// the length of the query including the separator in front of every option
+	size_t length() const
+	{
+		return std::apply([](const Options &...option) {
+			return (size_t(0) + ... + (1 + detail::OptionTraits<Options>::Key.length() +
+				detail::OptionTraits<Options>::valueLength(option)));
+		}, m_options);
+	}
+
+	// writes the options, the first one is preceded by the given separator
+	char *write(char *output, char separator) const
+	{
+		std::apply([&output, &separator](const Options &...option) {
+			((output = writeOption(option, output, separator), separator = '&'), ...);
+		}, m_options);
+		return output;
+	}
+
+	// the query without a leading separator
+	std::string str() const
+	{
+		std::string buffer;
+		buffer.resize(length());
+		if (buffer.length() > 0) {
+			write(&buffer[0], '&');
+			buffer.erase(0, 1);
+		}
+		return buffer;
+	}
+
+	// assembles host, resource and query in one buffer of the final size
+	Url url(std::string_view host, std::string_view resource) const
+	{
+		char separator = resource.find('?') == std::string_view::npos ? '?' : '&';
+		std::string buffer;
+		buffer.resize(host.length() + resource.length() + length());
+		char *output = &buffer[0];
+		output = std::copy(host.begin(), host.end(), output);
+		output = std::copy(resource.begin(), resource.end(), output);
+		write(output, separator);
+		return Url(std::move(buffer));
+	}
+
+ private:
+	template<class Option>
+	static char *writeOption(const Option &option, char *output, char separator)
+	{
+		*output++ = separator;
+		constexpr std::string_view key(detail::OptionTraits<Option>::Key);
+		output = std::copy(key.begin(), key.end(), output);
+		return detail::OptionTraits<Option>::writeValue(option, output);
+	}
+
+ private:
+	std::tuple<Options...> m_options;
+};
+
+template<class ...Options>
+constexpr Query<Options...> query(const Options &...options)
+{
+	return Query<Options...>(options...);
+}
+}  // namespace OData
+}  // namespace Sharepoint
+}  // namespace Microsoft
+
+#endif  // COMMON_ODATAQUERY_H_
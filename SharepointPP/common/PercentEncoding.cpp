@@ -0,0 +1,321 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "PercentEncoding.h"
+
+#include <bitset>
+#include <cstring>
+#include <string>
+
+#if defined(__AVX2__)
+#define PERCENTENCODING_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PERCENTENCODING_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using Microsoft::Sharepoint::PercentEncoding;
+
+namespace {
+// characters which can stay unencoded inside a query value:
+// the unreserved set plus the sub-delims which have no meaning in
+// the query itself, so "&", "=", "+", ";", "#" and "?" are encoded
+struct SafeCharacterTable
+{
+	bool values[256];
+
+	constexpr SafeCharacterTable() :
+		values()
+	{
+		for (int c = 'a'; c <= 'z'; ++c) {
+			values[c] = true;
+		}
+		for (int c = 'A'; c <= 'Z'; ++c) {
+			values[c] = true;
+		}
+		for (int c = '0'; c <= '9'; ++c) {
+			values[c] = true;
+		}
+		for (char c : std::string_view("-._~!$'()*,:@/")) {
+			values[static_cast<unsigned char>(c)] = true;
+		}
+	}
+};
+
+constexpr SafeCharacterTable safeCharacters;
+const char hexDigits[] = "0123456789ABCDEF";
+
+inline int hexValue(char c)
+{
+	if (c >= '0' && c <= '9') {
+		return c - '0';
+	}
+	if (c >= 'A' && c <= 'F') {
+		return c - 'A' + 10;
+	}
+	if (c >= 'a' && c <= 'f') {
+		return c - 'a' + 10;
+	}
+	return -1;
+}
+
+inline unsigned int lowestBit(unsigned int mask)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return index;
+#else
+	return static_cast<unsigned int>(__builtin_ctz(mask));
+#endif
+}
+
+inline size_t bitCount(unsigned int mask)
+{
+	return std::bitset<32>(mask).count();
+}
+
+#if defined(PERCENTENCODING_AVX2)
+// 32 bytes per block
+struct VectorBlock
+{
+	static constexpr size_t Size = 32;
+	typedef __m256i Register;
+
+	static Register load(const char *data)
+	{
+		return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data));
+	}
+
+	static void store(Register value, char *output)
+	{
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(output), value);
+	}
+
+	static Register inRange(Register value, char low, char high)
+	{
+		Register offset = _mm256_sub_epi8(value, _mm256_set1_epi8(low));
+		Register limited = _mm256_min_epu8(offset, _mm256_set1_epi8(static_cast<char>(high - low)));
+		return _mm256_cmpeq_epi8(limited, offset);
+	}
+
+	static Register equals(Register value, char c)
+	{
+		return _mm256_cmpeq_epi8(value, _mm256_set1_epi8(c));
+	}
+
+	static Register bitOr(Register first, Register second)
+	{
+		return _mm256_or_si256(first, second);
+	}
+
+	static unsigned int mask(Register value)
+	{
+		return static_cast<unsigned int>(_mm256_movemask_epi8(value));
+	}
+};
+#elif defined(PERCENTENCODING_SSE2)
+// 16 bytes per block
+struct VectorBlock
+{
+	static constexpr size_t Size = 16;
+	typedef __m128i Register;
+
+	static Register load(const char *data)
+	{
+		return _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+	}
+
+	static void store(Register value, char *output)
+	{
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(output), value);
+	}
+
+	// value - low <= high - low as unsigned bytes
+	static Register inRange(Register value, char low, char high)
+	{
+		Register offset = _mm_sub_epi8(value, _mm_set1_epi8(low));
+		Register limited = _mm_min_epu8(offset, _mm_set1_epi8(static_cast<char>(high - low)));
+		return _mm_cmpeq_epi8(limited, offset);
+	}
+
+	static Register equals(Register value, char c)
+	{
+		return _mm_cmpeq_epi8(value, _mm_set1_epi8(c));
+	}
+
+	static Register bitOr(Register first, Register second)
+	{
+		return _mm_or_si128(first, second);
+	}
+
+	static unsigned int mask(Register value)
+	{
+		return static_cast<unsigned int>(_mm_movemask_epi8(value));
+	}
+};
+#endif
+
+#if defined(PERCENTENCODING_AVX2) || defined(PERCENTENCODING_SSE2)
+#define PERCENTENCODING_VECTOR
+// one bit per byte of the block which has to be encoded,
+// the same set as SafeCharacterTable expressed as ranges:
+// "'()*" ",-./0-9:" "@A-Z" "a-z" and "!" "$" "_" "~"
+inline unsigned int unsafeMask(VectorBlock::Register value)
+{
+	VectorBlock::Register safe = VectorBlock::bitOr(
+		VectorBlock::bitOr(
+			VectorBlock::inRange(value, '\'', '*'),
+			VectorBlock::inRange(value, ',', ':')),
+		VectorBlock::bitOr(
+			VectorBlock::inRange(value, '@', 'Z'),
+			VectorBlock::inRange(value, 'a', 'z')));
+	safe = VectorBlock::bitOr(
+		safe,
+		VectorBlock::bitOr(
+			VectorBlock::bitOr(VectorBlock::equals(value, '!'), VectorBlock::equals(value, '$')),
+			VectorBlock::bitOr(VectorBlock::equals(value, '_'), VectorBlock::equals(value, '~'))));
+	return ~VectorBlock::mask(safe) & static_cast<unsigned int>((1ULL << VectorBlock::Size) - 1);
+}
+#endif
+
+inline char *encodeCharacter(char c, char *output)
+{
+	unsigned char byte = static_cast<unsigned char>(c);
+	if (safeCharacters.values[byte]) {
+		*output++ = c;
+	} else {
+		*output++ = '%';
+		*output++ = hexDigits[byte >> 4];
+		*output++ = hexDigits[byte & 0x0F];
+	}
+	return output;
+}
+}  // namespace
+
+size_t PercentEncoding::encodedLength(std::string_view input)
+{
+	const char *data = input.data();
+	const char *end = data + input.length();
+	size_t length = input.length();
+#ifdef PERCENTENCODING_VECTOR
+	for (; data + VectorBlock::Size <= end; data += VectorBlock::Size) {
+		length += 2 * bitCount(unsafeMask(VectorBlock::load(data)));
+	}
+#endif
+	for (; data < end; ++data) {
+		if (!safeCharacters.values[static_cast<unsigned char>(*data)]) {
+			length += 2;
+		}
+	}
+	return length;
+}
+
+char *PercentEncoding::encode(std::string_view input, char *output)
+{
+	const char *data = input.data();
+	const char *end = data + input.length();
+#ifdef PERCENTENCODING_VECTOR
+	while (data + VectorBlock::Size <= end) {
+		VectorBlock::Register block = VectorBlock::load(data);
+		unsigned int mask = unsafeMask(block);
+		if (mask == 0) {
+			VectorBlock::store(block, output);
+			data += VectorBlock::Size;
+			output += VectorBlock::Size;
+			continue;
+		}
+		// copy the safe run in front of the first special character
+		unsigned int safeLength = lowestBit(mask);
+		memcpy(output, data, safeLength);
+		output += safeLength;
+		data += safeLength;
+		output = encodeCharacter(*data++, output);
+	}
+#endif
+	for (; data < end; ++data) {
+		output = encodeCharacter(*data, output);
+	}
+	return output;
+}
+
+void PercentEncoding::appendEncoded(std::string_view input, std::string &output)
+{
+	size_t offset = output.length();
+	output.resize(offset + encodedLength(input));
+	encode(input, &output[offset]);
+}
+
+char *PercentEncoding::decode(std::string_view input, char *output)
+{
+	const char *data = input.data();
+	const char *end = data + input.length();
+	while (data < end) {
+#ifdef PERCENTENCODING_VECTOR
+		if (data + VectorBlock::Size <= end) {
+			VectorBlock::Register block = VectorBlock::load(data);
+			unsigned int mask = VectorBlock::mask(VectorBlock::equals(block, '%'));
+			if (mask == 0) {
+				VectorBlock::store(block, output);
+				data += VectorBlock::Size;
+				output += VectorBlock::Size;
+				continue;
+			}
+			unsigned int plainLength = lowestBit(mask);
+			memcpy(output, data, plainLength);
+			output += plainLength;
+			data += plainLength;
+		}
+#endif
+		if (*data == '%' && end - data >= 3) {
+			int high = hexValue(data[1]);
+			int low = hexValue(data[2]);
+			if (high >= 0 && low >= 0) {
+				*output++ = static_cast<char>((high << 4) | low);
+				data += 3;
+				continue;
+			}
+		}
+		*output++ = *data++;
+	}
+	return output;
+}
+
+void PercentEncoding::appendDecoded(std::string_view input, std::string &output)
+{
+	size_t offset = output.length();
+	output.resize(offset + input.length());
+	char *end = decode(input, &output[offset]);
+	output.resize(static_cast<size_t>(end - output.data()));
+}
+
+std::string PercentEncoding::decode(std::string_view input)
+{
+	std::string output;
+	appendDecoded(input, output);
+	return output;
+}
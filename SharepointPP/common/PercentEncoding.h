@@ -0,0 +1,63 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef COMMON_PERCENTENCODING_H_
+#define COMMON_PERCENTENCODING_H_
+
+#include <string>
+#include <string_view>
+
+namespace Microsoft {
+namespace Sharepoint {
+// percent-encoding (RFC 3986 2.1) of url components
+// The kernels check 16 bytes (SSE2) or 32 bytes (AVX2, if the build
+// enables it) at once and copy runs without special characters as a
+// whole, other targets use the scalar loop.
+class PercentEncoding
+{
+ public:
+	// the number of bytes encode() writes for the input
+	__declspec(dllexport)
+		static size_t encodedLength(std::string_view input);
+	// writes the encoded input to output, which must have room for
+	// encodedLength(input) bytes, and returns the end of the written data
+	__declspec(dllexport)
+		static char *encode(std::string_view input, char *output);
+	__declspec(dllexport)
+		static void appendEncoded(std::string_view input, std::string &output);
+
+ public:
+	// writes the decoded input to output, which must have room for
+	// input.length() bytes, and returns the end of the written data
+	// invalid escape sequences are copied unchanged
+	__declspec(dllexport)
+		static char *decode(std::string_view input, char *output);
+	__declspec(dllexport)
+		static void appendDecoded(std::string_view input, std::string &output);
+	__declspec(dllexport)
+		static std::string decode(std::string_view input);
+};
+}  // namespace Sharepoint
+}  // namespace Microsoft
+
+#endif  // COMMON_PERCENTENCODING_H_
@@ -0,0 +1,208 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "RecordingTransport.h"
+
+#include <cctype>
+#include <string_view>
+#include <utility>
+
+#include "CurlTransport.h"
+#include "WebRequest.h"
+
+using Microsoft::Sharepoint::CurlTransport;
+using Microsoft::Sharepoint::HttpFixture;
+using Microsoft::Sharepoint::RecordingTransport;
+using Microsoft::Sharepoint::Transport;
+using Microsoft::Sharepoint::WebResponse;
+
+namespace {
+const char mask[] = "********";
+
+bool equalsIgnoreCase(std::string_view left, std::string_view right)
+{
+	if (left.length() != right.length()) {
+		return false;
+	}
+	for (size_t i = 0; i < left.length(); ++i) {
+		if (tolower(static_cast<unsigned char>(left[i])) != tolower(static_cast<unsigned char>(right[i]))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// masks the text of every element of the local name, whatever its prefix
+void maskElement(std::string &body, std::string_view localName)
+{
+	size_t position = 0;
+	while ((position = body.find(localName, position)) != std::string::npos) {
+		size_t nameEnd = position + localName.length();
+		// only the name of a start tag: <name or <prefix:name
+		size_t tagStart = body.rfind('<', position);
+		bool startTag = tagStart != std::string::npos && nameEnd < body.length() &&
+			(body[nameEnd] == '>' || isspace(static_cast<unsigned char>(body[nameEnd])));
+		if (startTag && tagStart + 1 < position) {
+			std::string_view prefix(body.data() + tagStart + 1, position - tagStart - 1);
+			startTag = prefix.back() == ':' &&
+				prefix.find_first_of("<>/=\"' \t\r\n") == std::string_view::npos;
+		}
+		size_t contentStart = startTag ? body.find('>', nameEnd) : std::string::npos;
+		if (contentStart == std::string::npos || body[contentStart - 1] == '/') {
+			position = nameEnd;
+			continue;
+		}
+		++contentStart;
+		size_t contentEnd = body.find('<', contentStart);
+		if (contentEnd == std::string::npos) {
+			return;
+		}
+		body.replace(contentStart, contentEnd - contentStart, mask);
+		position = contentStart + sizeof(mask) - 1;
+	}
+}
+
+// masks the values of a Cookie header: a=1; b=2
+void maskCookieHeader(std::string &cookies)
+{
+	std::string masked;
+	size_t position = 0;
+	while (position < cookies.length()) {
+		size_t end = cookies.find(';', position);
+		if (end == std::string::npos) {
+			end = cookies.length();
+		}
+		size_t equals = cookies.find('=', position);
+		if (!masked.empty()) {
+			masked += "; ";
+		}
+		size_t nameStart = cookies.find_first_not_of(' ', position);
+		if (equals < end && nameStart < equals) {
+			masked.append(cookies, nameStart, equals + 1 - nameStart);
+			masked += mask;
+		} else if (nameStart < end) {
+			masked.append(cookies, nameStart, end - nameStart);
+		}
+		position = end + 1;
+	}
+	cookies.swap(masked);
+}
+
+// masks the value of a Set-Cookie header, its attributes stay
+void maskSetCookie(std::string &value)
+{
+	size_t equals = value.find('=');
+	if (equals == std::string::npos) {
+		return;
+	}
+	size_t end = value.find(';', equals);
+	value.replace(equals + 1, (end == std::string::npos ? value.length() : end) - equals - 1, mask);
+}
+
+// Takes the credentials of the tenant out of an exchange: the user name
+// and password of the sts request, the security token, the session
+// cookies and the request digests. Fixtures are shared, e.g. checked in
+// for the CI, and replaying doesn't need any of them.
+void redact(HttpFixture::Exchange &exchange)
+{
+	for (auto &header : exchange.requestHeaders) {
+		if (equalsIgnoreCase(header.first, "X-RequestDigest") ||
+			equalsIgnoreCase(header.first, "Authorization") ||
+			equalsIgnoreCase(header.first, "Cookie")) {
+			header.second = mask;
+		}
+	}
+	maskCookieHeader(exchange.requestCookies);
+	for (std::string_view element : {"Username", "Password", "BinarySecurityToken", "FormDigestValue"}) {
+		maskElement(exchange.requestBody, element);
+		maskElement(exchange.responseBody, element);
+	}
+	// the login page gets the security token as the whole body
+	if (exchange.url.find("wa=wsignin1.0") != std::string::npos && !exchange.requestBody.empty()) {
+		exchange.requestBody = mask;
+	}
+	for (auto &header : exchange.responseHeaders) {
+		if (equalsIgnoreCase(header.first, "Set-Cookie")) {
+			maskSetCookie(header.second);
+		} else if (equalsIgnoreCase(header.first, "X-RequestDigest")) {
+			header.second = mask;
+		}
+	}
+	for (auto &cookie : exchange.responseCookies) {
+		cookie.second = mask;
+	}
+}
+}  // namespace
+
+RecordingTransport::RecordingTransport(const std::string &path, const std::shared_ptr<Transport> &transport) :
+	m_transport(transport ? transport : std::make_shared<CurlTransport>()),
+	m_writer(path)
+{
+}
+
+bool RecordingTransport::isRecording() const
+{
+	return m_writer.isOpen();
+}
+
+WebResponse RecordingTransport::send(const WebRequest &request, Method method, const Url &url, std::string &&data)
+{
+	HttpFixture::Exchange exchange = prepareExchange(request, method, url, data);
+	WebResponse response = m_transport->send(request, method, url, std::move(data));
+	record(std::move(exchange), response);
+	return response;
+}
+
+void RecordingTransport::sendAsync(const WebRequest &request, Method method, const Url &url, std::string &&data, CompletionType &&completion)
+{
+	auto exchange = std::make_shared<HttpFixture::Exchange>(prepareExchange(request, method, url, data));
+	m_transport->sendAsync(request, method, url, std::move(data),
+		[this, exchange, completion = std::move(completion)](WebResponse &&response) mutable {
+		record(std::move(*exchange), response);
+		if (completion) {
+			completion(std::move(response));
+		}
+	});
+}
+
+HttpFixture::Exchange RecordingTransport::prepareExchange(const WebRequest &request, Method method, const Url &url, const std::string &data)
+{
+	HttpFixture::Exchange exchange;
+	exchange.method = method;
+	exchange.url = url.str();
+	exchange.requestHeaders = request.headers();
+	exchange.requestCookies = request.cookieHeader(url);
+	exchange.requestBody = data;
+	return exchange;
+}
+
+void RecordingTransport::record(HttpFixture::Exchange &&exchange, const WebResponse &response)
+{
+	exchange.httpStatusCode = response.httpStatusCode();
+	exchange.effectiveUrl = response.effectiveUrl();
+	exchange.responseHeaders = response.header();
+	exchange.responseCookies = response.cookies();
+	exchange.responseBody = response.response();
+	exchange.timings = response.timings();
+	redact(exchange);
+	m_writer.write(exchange);
+}
@@ -0,0 +1,74 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef COMMON_RECORDINGTRANSPORT_H_
+#define COMMON_RECORDINGTRANSPORT_H_
+
+#include <memory>
+#include <string>
+
+#include "HttpFixture.h"
+#include "Transport.h"
+
+namespace Microsoft {
+namespace Sharepoint {
+// Sends the requests through another transport and records every
+// exchange into a fixture file for the ReplayTransport. Set it on a
+// WebRequest, or as the default transport to record everything,
+// including the logins:
+//   Transport::setDefaultTransport(std::make_shared<RecordingTransport>("tenant.fixture"));
+// The credentials are masked before an exchange is written: the user
+// name and password of the sts request, the security token, cookie
+// values, request digests and Authorization headers. The fixture can be
+// replayed without them, the ReplayTransport matches by method and url.
+class RecordingTransport : public Transport
+{
+ public:
+	// nullptr sends through a new CurlTransport
+	__declspec(dllexport)
+		explicit RecordingTransport(const std::string &path, const std::shared_ptr<Transport> &transport = nullptr);
+
+ public:
+	// false if the file couldn't be created
+	__declspec(dllexport)
+		bool isRecording() const;
+
+ public:
+	__declspec(dllexport)
+		WebResponse send(const WebRequest &request, Transport::Method method, const Url &url, std::string &&data) override;
+	__declspec(dllexport)
+		void sendAsync(const WebRequest &request, Transport::Method method, const Url &url, std::string &&data, Transport::CompletionType &&completion) override;
+
+ private:
+	// the request half of the exchange
+	static HttpFixture::Exchange prepareExchange(const WebRequest &request, Transport::Method method, const Url &url, const std::string &data);
+	void record(HttpFixture::Exchange &&exchange, const WebResponse &response);
+
+ private:
+	std::shared_ptr<Transport> m_transport;
+	HttpFixtureWriter m_writer;
+};
+}  // namespace Sharepoint
+}  // namespace Microsoft
+
+#endif  // COMMON_RECORDINGTRANSPORT_H_
@@ -0,0 +1,127 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "ReplayTransport.h"
+
+#include <cstdio>
+#include <thread>
+#include <utility>
+
+#include "RequestMetrics.h"
+#include "TransportResponse.h"
+#include "WebRequest.h"
+
+using Microsoft::Sharepoint::HttpFixture;
+using Microsoft::Sharepoint::ReplayTransport;
+using Microsoft::Sharepoint::RequestMetrics;
+using Microsoft::Sharepoint::Transport;
+using Microsoft::Sharepoint::TransportResponse;
+using Microsoft::Sharepoint::WebResponse;
+
+ReplayTransport::ReplayTransport(const std::string &path, Timing timing) :
+	m_timing(timing),
+	m_loaded(false),
+	m_missCount(0)
+{
+	m_loaded = HttpFixture::load(path, m_exchanges);
+	for (size_t i = 0; i < m_exchanges.size(); ++i) {
+		m_cursors[key(m_exchanges[i].method, m_exchanges[i].url)].exchanges.push_back(i);
+	}
+}
+
+bool ReplayTransport::isLoaded() const
+{
+	return m_loaded;
+}
+
+size_t ReplayTransport::exchangeCount() const
+{
+	return m_exchanges.size();
+}
+
+size_t ReplayTransport::missCount() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_missCount;
+}
+
+WebResponse ReplayTransport::send(const WebRequest &request, Method method, const Url &url, std::string &&)
+{
+	std::chrono::microseconds delay(0);
+	WebResponse response = replay(request, method, url, delay);
+	if (m_timing == Timing::Original && delay.count() > 0) {
+		std::this_thread::sleep_for(delay);
+	}
+	return response;
+}
+
+void ReplayTransport::sendAsync(const WebRequest &request, Method method, const Url &url, std::string &&, CompletionType &&completion)
+{
+	std::chrono::microseconds delay(0);
+	WebResponse response = replay(request, method, url, delay);
+	if (m_timing == Timing::Original) {
+		m_timer.schedule(delay, std::move(completion), std::move(response));
+	} else if (completion) {
+		completion(std::move(response));
+	}
+}
+
+std::string ReplayTransport::key(Method method, const std::string &url)
+{
+	return (method == Method::Post ? "POST " : "GET ") + url;
+}
+
+WebResponse ReplayTransport::replay(const WebRequest &request, Method method, const Url &url, std::chrono::microseconds &delay)
+{
+	const HttpFixture::Exchange *exchange = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto cursor = m_cursors.find(key(method, url.str()));
+		if (cursor != m_cursors.end()) {
+			exchange = &m_exchanges[cursor->second.exchanges[cursor->second.next]];
+			cursor->second.next = (cursor->second.next + 1) % cursor->second.exchanges.size();
+		} else {
+			++m_missCount;
+		}
+	}
+	if (exchange == nullptr) {
+		fprintf(stderr, "no recorded exchange for %s\n", key(method, url.str()).data());
+		return TransportResponse(-1, std::string(), url);
+	}
+
+	TransportResponse response(exchange->httpStatusCode, std::string(exchange->responseBody), url);
+	for (auto &header : exchange->responseHeaders) {
+		response.addHeader(header.first, header.second);
+	}
+	for (auto &cookie : exchange->responseCookies) {
+		response.addCookie(cookie.first, cookie.second);
+	}
+	response.storeCookies(request.cookieJar(), url);
+	response.setEffectiveUrl(exchange->effectiveUrl);
+	response.setTimings(exchange->timings);
+	RequestMetrics::record(
+		RequestMetrics::classify(url.resource(), method == Method::Post),
+		exchange->httpStatusCode,
+		exchange->timings);
+	delay = exchange->timings.total;
+	return std::move(response);
+}
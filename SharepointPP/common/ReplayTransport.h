@@ -0,0 +1,103 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef COMMON_REPLAYTRANSPORT_H_
+#define COMMON_REPLAYTRANSPORT_H_
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "CompletionTimer.h"
+#include "HttpFixture.h"
+#include "Transport.h"
+
+namespace Microsoft {
+namespace Sharepoint {
+// Answers requests with the exchanges of a fixture file written by the
+// RecordingTransport, without network access.
+// A request is matched by its method and url. Exchanges recorded for the
+// same request are played back in the order they were recorded, and
+// from the start again when all were used, so a benchmark can loop over
+// a recorded session. Cookies set by a recorded response are stored in
+// the cookie jar of the request like curl does. A request which wasn't
+// recorded fails with status -1.
+class ReplayTransport : public Transport
+{
+ public:
+	enum class Timing
+	{
+		// answers right away
+		WireSpeed,
+		// answers after the total time the request took when recorded
+		Original
+	};
+
+ public:
+	__declspec(dllexport)
+		explicit ReplayTransport(const std::string &path, ReplayTransport::Timing timing = ReplayTransport::Timing::WireSpeed);
+
+ public:
+	// false if the fixture couldn't be read
+	__declspec(dllexport)
+		bool isLoaded() const;
+	__declspec(dllexport)
+		size_t exchangeCount() const;
+	// requests which matched no exchange
+	__declspec(dllexport)
+		size_t missCount() const;
+
+ public:
+	__declspec(dllexport)
+		WebResponse send(const WebRequest &request, Transport::Method method, const Url &url, std::string &&data) override;
+	__declspec(dllexport)
+		void sendAsync(const WebRequest &request, Transport::Method method, const Url &url, std::string &&data, Transport::CompletionType &&completion) override;
+
+ private:
+	struct Cursor
+	{
+		std::vector<size_t> exchanges;
+		size_t next {0};
+	};
+
+ private:
+	static std::string key(Transport::Method method, const std::string &url);
+	// the recorded response and the time it took
+	WebResponse replay(const WebRequest &request, Transport::Method method, const Url &url, std::chrono::microseconds &delay);
+
+ private:
+	Timing m_timing;
+	bool m_loaded;
+	std::vector<HttpFixture::Exchange> m_exchanges;
+	mutable std::mutex m_mutex;
+	std::unordered_map<std::string, Cursor> m_cursors;
+	size_t m_missCount;
+	// destroyed first, it may still call completions
+	CompletionTimer m_timer;
+};
+}  // namespace Sharepoint
+}  // namespace Microsoft
+
+#endif  // COMMON_REPLAYTRANSPORT_H_
@@ -0,0 +1,485 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "RequestMetrics.h"
+
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using Microsoft::Sharepoint::RequestMetrics;
+using Microsoft::Sharepoint::RequestTimings;
+
+namespace {
+// log linear buckets like a hdr histogram: the first SubBucketCount
+// buckets hold one value each, above that every power of two is split
+// into SubBucketHalf buckets of equal width
+const unsigned int SubBucketBits = 5;
+const uint64_t SubBucketCount = 1ULL << SubBucketBits;
+const uint64_t SubBucketHalf = SubBucketCount / 2;
+const unsigned int MaxValueBits = 38;
+const uint64_t MaxValue = (1ULL << MaxValueBits) - 1;
+const size_t BucketCount = (MaxValueBits - SubBucketBits + 2) * SubBucketHalf;
+
+// slot 0 counts requests without a response, slot 1 is status 100
+const long FirstStatusCode = 100;
+const long LastStatusCode = 599;
+const size_t StatusSlotCount = LastStatusCode - FirstStatusCode + 2;
+
+const char *const endpointLabels[RequestMetrics::EndpointCount] = {
+	"auth",
+	"list_read",
+	"file_download",
+	"batch",
+	"other"
+};
+
+// upper bounds of the exported histogram buckets
+struct HistogramBound
+{
+	const char *label;
+	uint64_t microseconds;
+};
+const HistogramBound histogramBounds[] = {
+	{"0.001", 1000},
+	{"0.0025", 2500},
+	{"0.005", 5000},
+	{"0.01", 10000},
+	{"0.025", 25000},
+	{"0.05", 50000},
+	{"0.1", 100000},
+	{"0.25", 250000},
+	{"0.5", 500000},
+	{"1", 1000000},
+	{"2.5", 2500000},
+	{"5", 5000000},
+	{"10", 10000000},
+	{"30", 30000000},
+	{"60", 60000000}
+};
+
+inline unsigned int highestBit(uint64_t value)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanReverse64(&index, value);
+	return index;
+#else
+	return 63 - static_cast<unsigned int>(__builtin_clzll(value));
+#endif
+}
+
+inline size_t bucketIndex(uint64_t value)
+{
+	if (value > MaxValue) {
+		value = MaxValue;
+	}
+	if (value < SubBucketCount) {
+		return static_cast<size_t>(value);
+	}
+	unsigned int shift = highestBit(value) - (SubBucketBits - 1);
+	return static_cast<size_t>((shift + 1) * SubBucketHalf + (value >> shift) - SubBucketHalf);
+}
+
+// the largest value which falls into the bucket
+inline uint64_t bucketHighest(size_t index)
+{
+	if (index < SubBucketCount) {
+		return index;
+	}
+	unsigned int shift = static_cast<unsigned int>(index / SubBucketHalf - 1);
+	uint64_t lowest = (index % SubBucketHalf + SubBucketHalf) << shift;
+	return lowest + (1ULL << shift) - 1;
+}
+
+// only the owning thread writes a counter, so a plain load and store
+// is enough and other threads still read whole values
+class Counter
+{
+ public:
+	void add(uint64_t amount)
+	{
+		m_value.store(m_value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+	}
+	uint64_t value() const
+	{
+		return m_value.load(std::memory_order_relaxed);
+	}
+
+ private:
+	std::atomic<uint64_t> m_value {0};
+};
+
+struct EndpointCounters
+{
+	std::array<Counter, BucketCount> latencyBuckets;
+	Counter latencySum;
+	Counter requests;
+	std::array<Counter, StatusSlotCount> statusCodes;
+	Counter retries;
+	Counter throttled;
+	Counter bytesUp;
+	Counter bytesDown;
+	Counter connectionsReused;
+};
+
+// the counters of one thread, handed to the next new thread when it exits
+struct Shard
+{
+	std::array<EndpointCounters, RequestMetrics::EndpointCount> endpoints;
+	bool inUse {false};
+};
+
+struct Registry
+{
+	std::mutex mutex;
+	std::vector<std::unique_ptr<Shard>> shards;
+};
+
+Registry &registry()
+{
+	static Registry registry;
+	return registry;
+}
+
+class ShardLease
+{
+ public:
+	ShardLease()
+	{
+		Registry &shards = registry();
+		std::lock_guard<std::mutex> lock(shards.mutex);
+		for (const std::unique_ptr<Shard> &shard : shards.shards) {
+			if (!shard->inUse) {
+				m_shard = shard.get();
+				break;
+			}
+		}
+		if (m_shard == nullptr) {
+			shards.shards.push_back(std::make_unique<Shard>());
+			m_shard = shards.shards.back().get();
+		}
+		m_shard->inUse = true;
+	}
+	~ShardLease()
+	{
+		Registry &shards = registry();
+		std::lock_guard<std::mutex> lock(shards.mutex);
+		m_shard->inUse = false;
+	}
+	ShardLease(const ShardLease &other) = delete;
+	ShardLease &operator=(const ShardLease &other) = delete;
+
+ public:
+	EndpointCounters &counters(RequestMetrics::Endpoint endpoint)
+	{
+		return m_shard->endpoints[static_cast<size_t>(endpoint)];
+	}
+
+ private:
+	Shard *m_shard {nullptr};
+};
+
+EndpointCounters &localCounters(RequestMetrics::Endpoint endpoint)
+{
+	// the registry is created first, so it outlives the leases
+	registry();
+	thread_local ShardLease lease;
+	return lease.counters(endpoint);
+}
+
+// calls visit with the counters of the endpoint of every thread
+template<class Visitor>
+void forEachShard(RequestMetrics::Endpoint endpoint, Visitor visit)
+{
+	Registry &shards = registry();
+	std::lock_guard<std::mutex> lock(shards.mutex);
+	for (const std::unique_ptr<Shard> &shard : shards.shards) {
+		visit(static_cast<const EndpointCounters &>(shard->endpoints[static_cast<size_t>(endpoint)]));
+	}
+}
+
+// the latency buckets of the endpoint summed over all threads
+std::vector<uint64_t> latencyBuckets(RequestMetrics::Endpoint endpoint)
+{
+	std::vector<uint64_t> buckets(BucketCount, 0);
+	forEachShard(endpoint, [&buckets](const EndpointCounters &counters) {
+		for (size_t i = 0; i < BucketCount; ++i) {
+			buckets[i] += counters.latencyBuckets[i].value();
+		}
+	});
+	return buckets;
+}
+
+bool containsNoCase(std::string_view text, std::string_view lowerPattern)
+{
+	if (lowerPattern.length() > text.length()) {
+		return false;
+	}
+	for (size_t start = 0; start + lowerPattern.length() <= text.length(); ++start) {
+		size_t i = 0;
+		while (i < lowerPattern.length()) {
+			char c = text[start + i];
+			if (c >= 'A' && c <= 'Z') {
+				c = static_cast<char>(c - 'A' + 'a');
+			}
+			if (c != lowerPattern[i]) {
+				break;
+			}
+			++i;
+		}
+		if (i == lowerPattern.length()) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool endsWithNoCase(std::string_view text, std::string_view lowerPattern)
+{
+	return text.length() >= lowerPattern.length() &&
+		containsNoCase(text.substr(text.length() - lowerPattern.length()), lowerPattern);
+}
+
+void appendMetric(std::string &output, const char *name, const char *endpoint, uint64_t value)
+{
+	char line[192];
+	snprintf(line, sizeof(line), "%s{endpoint=\"%s\"} %llu\n",
+		name, endpoint, static_cast<unsigned long long>(value));
+	output += line;
+}
+
+void appendHeader(std::string &output, const char *name, const char *type, const char *help)
+{
+	output += "# HELP ";
+	output += name;
+	output += ' ';
+	output += help;
+	output += "\n# TYPE ";
+	output += name;
+	output += ' ';
+	output += type;
+	output += '\n';
+}
+
+RequestMetrics::Endpoint endpointAt(size_t index)
+{
+	return static_cast<RequestMetrics::Endpoint>(index);
+}
+}  // namespace
+
+RequestMetrics::Endpoint RequestMetrics::classify(std::string_view resource, bool post)
+{
+	if (containsNoCase(resource, "/extsts.srf") ||
+		containsNoCase(resource, "/_forms/default.aspx") ||
+		containsNoCase(resource, "/_api/contextinfo")) {
+		return Endpoint::Authentication;
+	}
+	if (containsNoCase(resource, "/$batch")) {
+		return Endpoint::Batch;
+	}
+	if (!post && (
+		endsWithNoCase(resource, "/$value") ||
+		endsWithNoCase(resource, "/openbinarystream") ||
+		containsNoCase(resource, "/download.aspx"))) {
+		return Endpoint::FileDownload;
+	}
+	// caml queries and the change log are read with a post
+	if ((!post && (containsNoCase(resource, "/lists") || containsNoCase(resource, "/getlist"))) ||
+		(post && (endsWithNoCase(resource, "/getitems") || endsWithNoCase(resource, "/getchanges")))) {
+		return Endpoint::ListRead;
+	}
+	return Endpoint::Other;
+}
+
+void RequestMetrics::record(Endpoint endpoint, long httpStatusCode, const RequestTimings &timings)
+{
+	EndpointCounters &counters = localCounters(endpoint);
+	uint64_t latency = static_cast<uint64_t>(timings.total.count() > 0 ? timings.total.count() : 0);
+	counters.latencyBuckets[bucketIndex(latency)].add(1);
+	counters.latencySum.add(latency);
+	counters.requests.add(1);
+	if (httpStatusCode >= FirstStatusCode && httpStatusCode <= LastStatusCode) {
+		counters.statusCodes[static_cast<size_t>(httpStatusCode - FirstStatusCode + 1)].add(1);
+	} else {
+		counters.statusCodes[0].add(1);
+	}
+	if (httpStatusCode == 429 || httpStatusCode == 503) {
+		counters.throttled.add(1);
+	}
+	counters.bytesUp.add(static_cast<uint64_t>(timings.bytesUp > 0 ? timings.bytesUp : 0));
+	counters.bytesDown.add(static_cast<uint64_t>(timings.bytesDown > 0 ? timings.bytesDown : 0));
+	if (timings.connectionReused) {
+		counters.connectionsReused.add(1);
+	}
+}
+
+void RequestMetrics::recordRetry(Endpoint endpoint)
+{
+	localCounters(endpoint).retries.add(1);
+}
+
+std::chrono::microseconds RequestMetrics::latencyQuantile(Endpoint endpoint, double quantile)
+{
+	std::vector<uint64_t> buckets = latencyBuckets(endpoint);
+	uint64_t count = 0;
+	for (uint64_t bucket : buckets) {
+		count += bucket;
+	}
+	if (count == 0) {
+		return std::chrono::microseconds(0);
+	}
+	if (quantile < 0.0) {
+		quantile = 0.0;
+	} else if (quantile > 1.0) {
+		quantile = 1.0;
+	}
+	// rank of the value at the quantile, counting from 1
+	uint64_t rank = static_cast<uint64_t>(quantile * static_cast<double>(count) + 0.5);
+	if (rank == 0) {
+		rank = 1;
+	}
+	uint64_t seen = 0;
+	for (size_t i = 0; i < buckets.size(); ++i) {
+		seen += buckets[i];
+		if (seen >= rank) {
+			return std::chrono::microseconds(static_cast<long long>(bucketHighest(i)));
+		}
+	}
+	return std::chrono::microseconds(static_cast<long long>(MaxValue));
+}
+
+uint64_t RequestMetrics::requestCount(Endpoint endpoint)
+{
+	uint64_t count = 0;
+	forEachShard(endpoint, [&count](const EndpointCounters &counters) {
+		count += counters.requests.value();
+	});
+	return count;
+}
+
+std::string RequestMetrics::prometheusText()
+{
+	std::string output;
+	char line[192];
+
+	appendHeader(output, "sharepoint_request_duration_seconds", "histogram",
+		"Time from the start of a request until its response was received completely.");
+	for (size_t e = 0; e < EndpointCount; ++e) {
+		std::vector<uint64_t> buckets = latencyBuckets(endpointAt(e));
+		uint64_t latencySum = 0;
+		forEachShard(endpointAt(e), [&latencySum](const EndpointCounters &counters) {
+			latencySum += counters.latencySum.value();
+		});
+		// a bucket counts as below a bound only if all of its values are,
+		// so the exported buckets never report a request faster than it was
+		size_t bucket = 0;
+		uint64_t cumulative = 0;
+		for (const HistogramBound &bound : histogramBounds) {
+			while (bucket < BucketCount && bucketHighest(bucket) <= bound.microseconds) {
+				cumulative += buckets[bucket++];
+			}
+			snprintf(line, sizeof(line), "sharepoint_request_duration_seconds_bucket{endpoint=\"%s\",le=\"%s\"} %llu\n",
+				endpointLabels[e], bound.label, static_cast<unsigned long long>(cumulative));
+			output += line;
+		}
+		for (; bucket < BucketCount; ++bucket) {
+			cumulative += buckets[bucket];
+		}
+		snprintf(line, sizeof(line), "sharepoint_request_duration_seconds_bucket{endpoint=\"%s\",le=\"+Inf\"} %llu\n",
+			endpointLabels[e], static_cast<unsigned long long>(cumulative));
+		output += line;
+		snprintf(line, sizeof(line), "sharepoint_request_duration_seconds_sum{endpoint=\"%s\"} %.6f\n",
+			endpointLabels[e], static_cast<double>(latencySum) / 1e6);
+		output += line;
+		appendMetric(output, "sharepoint_request_duration_seconds_count", endpointLabels[e], cumulative);
+	}
+
+	appendHeader(output, "sharepoint_requests_total", "counter",
+		"Requests by http status code, code 0 if no response was received.");
+	for (size_t e = 0; e < EndpointCount; ++e) {
+		std::array<uint64_t, StatusSlotCount> statusCodes {};
+		forEachShard(endpointAt(e), [&statusCodes](const EndpointCounters &counters) {
+			for (size_t i = 0; i < StatusSlotCount; ++i) {
+				statusCodes[i] += counters.statusCodes[i].value();
+			}
+		});
+		for (size_t i = 0; i < StatusSlotCount; ++i) {
+			if (statusCodes[i] > 0) {
+				snprintf(line, sizeof(line), "sharepoint_requests_total{endpoint=\"%s\",code=\"%ld\"} %llu\n",
+					endpointLabels[e], i == 0 ? 0L : static_cast<long>(i) + FirstStatusCode - 1,
+					static_cast<unsigned long long>(statusCodes[i]));
+				output += line;
+			}
+		}
+	}
+
+	struct CounterMetric
+	{
+		const char *name;
+		const char *help;
+		Counter EndpointCounters::*counter;
+	};
+	const CounterMetric counterMetrics[] = {
+		{"sharepoint_request_retries_total", "Requests sent again after a failure.", &EndpointCounters::retries},
+		{"sharepoint_requests_throttled_total", "Responses with status 429 or 503.", &EndpointCounters::throttled},
+		{"sharepoint_request_sent_bytes_total", "Request headers and bodies sent.", &EndpointCounters::bytesUp},
+		{"sharepoint_response_received_bytes_total", "Response headers and bodies received.", &EndpointCounters::bytesDown},
+		{"sharepoint_connections_reused_total", "Requests sent without opening a new connection.", &EndpointCounters::connectionsReused}
+	};
+	std::array<std::array<uint64_t, EndpointCount>, sizeof(counterMetrics) / sizeof(counterMetrics[0])> totals {};
+	std::array<uint64_t, EndpointCount> requests {};
+	for (size_t e = 0; e < EndpointCount; ++e) {
+		forEachShard(endpointAt(e), [&](const EndpointCounters &counters) {
+			for (size_t m = 0; m < totals.size(); ++m) {
+				totals[m][e] += (counters.*counterMetrics[m].counter).value();
+			}
+			requests[e] += counters.requests.value();
+		});
+	}
+	for (size_t m = 0; m < totals.size(); ++m) {
+		appendHeader(output, counterMetrics[m].name, "counter", counterMetrics[m].help);
+		for (size_t e = 0; e < EndpointCount; ++e) {
+			appendMetric(output, counterMetrics[m].name, endpointLabels[e], totals[m][e]);
+		}
+	}
+
+	appendHeader(output, "sharepoint_connection_reuse_ratio", "gauge",
+		"Share of the requests which reused an open connection.");
+	// the reused connections are the last of the counters above
+	const size_t reusedIndex = totals.size() - 1;
+	for (size_t e = 0; e < EndpointCount; ++e) {
+		double ratio = requests[e] > 0 ?
+			static_cast<double>(totals[reusedIndex][e]) / static_cast<double>(requests[e]) : 0.0;
+		snprintf(line, sizeof(line), "sharepoint_connection_reuse_ratio{endpoint=\"%s\"} %.4f\n",
+			endpointLabels[e], ratio);
+		output += line;
+	}
+	return output;
+}
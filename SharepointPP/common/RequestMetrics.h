@@ -0,0 +1,83 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef COMMON_REQUESTMETRICS_H_
+#define COMMON_REQUESTMETRICS_H_
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "RequestTimings.h"
+
+namespace Microsoft {
+namespace Sharepoint {
+// Process wide metrics of all requests sent through WebRequest and the
+// AsyncEngine, grouped by the kind of endpoint a request went to.
+// Every thread records into counters of its own without locking, the
+// exporter sums the counters of all threads when it is asked for them.
+// Latencies are kept in log linear buckets with a relative precision of
+// 1/16 from 1 microsecond up to about 76 hours.
+class RequestMetrics
+{
+ public:
+	enum class Endpoint
+	{
+		// sts token, login page and context info
+		Authentication,
+		ListRead,
+		FileDownload,
+		Batch,
+		Other
+	};
+	static constexpr size_t EndpointCount = 5;
+
+ public:
+	// the kind of endpoint a request goes to, decided by the resource
+	// part of its url
+	__declspec(dllexport)
+		static RequestMetrics::Endpoint classify(std::string_view resource, bool post);
+	// httpStatusCode is negative if no response was received,
+	// 429 and 503 are counted as throttled
+	__declspec(dllexport)
+		static void record(RequestMetrics::Endpoint endpoint, long httpStatusCode, const RequestTimings &timings);
+	// for callers which send a request again after a failure
+	__declspec(dllexport)
+		static void recordRetry(RequestMetrics::Endpoint endpoint);
+
+ public:
+	// the latency below which the given fraction of the requests completed,
+	// 0 if nothing was recorded
+	__declspec(dllexport)
+		static std::chrono::microseconds latencyQuantile(RequestMetrics::Endpoint endpoint, double quantile);
+	__declspec(dllexport)
+		static uint64_t requestCount(RequestMetrics::Endpoint endpoint);
+	// all metrics in the prometheus text exposition format
+	__declspec(dllexport)
+		static std::string prometheusText();
+};
+}  // namespace Sharepoint
+}  // namespace Microsoft
+
+#endif  // COMMON_REQUESTMETRICS_H_
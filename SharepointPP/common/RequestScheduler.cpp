@@ -0,0 +1,311 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "RequestScheduler.h"
+
+#include <cctype>
+#include <utility>
+
+#include "TransportResponse.h"
+#include "WebRequest.h"
+
+using Microsoft::Sharepoint::RequestScheduler;
+using Microsoft::Sharepoint::TransportResponse;
+using Microsoft::Sharepoint::WebRequest;
+using Microsoft::Sharepoint::WebResponse;
+
+namespace {
+// waits without a timeout for the deadline which never comes, a
+// wait_until() with it would overflow
+template<typename PredicateType>
+bool waitUntil(
+	std::condition_variable &condition,
+	std::unique_lock<std::mutex> &lock,
+	RequestScheduler::ClockType::time_point deadline,
+	PredicateType predicate)
+{
+	if (deadline == RequestScheduler::ClockType::time_point::max()) {
+		condition.wait(lock, predicate);
+		return true;
+	}
+	return condition.wait_until(lock, deadline, predicate);
+}
+}
+
+struct RequestScheduler::Waiter
+{
+	Waiter(const std::string &host, const std::string &tenant) :
+		host(host),
+		tenant(tenant)
+	{
+	}
+
+	const std::string &host;
+	const std::string &tenant;
+	bool granted {false};
+	std::condition_variable wakeup;
+};
+
+RequestScheduler::Slot::Slot() :
+	m_scheduler(nullptr),
+	m_priority(Priority::Normal)
+{
+}
+
+RequestScheduler::Slot::Slot(RequestScheduler *scheduler, Priority priority, std::string &&host, std::string &&tenant) :
+	m_scheduler(scheduler),
+	m_priority(priority),
+	m_host(std::move(host)),
+	m_tenant(std::move(tenant))
+{
+}
+
+RequestScheduler::Slot::Slot(Slot &&other) :
+	m_scheduler(other.m_scheduler),
+	m_priority(other.m_priority),
+	m_host(std::move(other.m_host)),
+	m_tenant(std::move(other.m_tenant))
+{
+	other.m_scheduler = nullptr;
+}
+
+RequestScheduler::Slot &RequestScheduler::Slot::operator=(Slot &&other)
+{
+	if (this != &other) {
+		release();
+		m_scheduler = other.m_scheduler;
+		m_priority = other.m_priority;
+		m_host = std::move(other.m_host);
+		m_tenant = std::move(other.m_tenant);
+		other.m_scheduler = nullptr;
+	}
+	return *this;
+}
+
+RequestScheduler::Slot::~Slot()
+{
+	release();
+}
+
+bool RequestScheduler::Slot::isValid() const
+{
+	return m_scheduler != nullptr;
+}
+
+void RequestScheduler::Slot::release()
+{
+	if (m_scheduler != nullptr) {
+		m_scheduler->release(m_priority, m_host, m_tenant);
+		m_scheduler = nullptr;
+	}
+}
+
+RequestScheduler::RequestScheduler(size_t maxRequests, size_t maxRequestsPerHost, size_t maxRequestsPerTenant) :
+	m_maxRequests(maxRequests > 0 ? maxRequests : DefaultMaxRequests),
+	m_maxRequestsPerHost(maxRequestsPerHost),
+	m_maxRequestsPerTenant(maxRequestsPerTenant),
+	m_inFlight(0),
+	m_arrivals(0)
+{
+}
+
+RequestScheduler::~RequestScheduler()
+{
+}
+
+void RequestScheduler::setMaxRequests(Priority priority, size_t maxRequests)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_classes[static_cast<size_t>(priority)].maxRequests = maxRequests;
+	// a raised limit may let waiting requests go
+	dispatch();
+}
+
+void RequestScheduler::setMaxQueued(Priority priority, size_t maxQueued)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	Class &requestClass = m_classes[static_cast<size_t>(priority)];
+	requestClass.maxQueued = maxQueued > 0 ? maxQueued : 1;
+	requestClass.room.notify_all();
+}
+
+void RequestScheduler::setMaxWait(Priority priority, std::chrono::milliseconds maxWait)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_classes[static_cast<size_t>(priority)].maxWait = maxWait;
+}
+
+RequestScheduler::Slot RequestScheduler::acquire(const Url &url, Priority priority, ClockType::time_point deadline)
+{
+	ClockType::time_point arrival = ClockType::now();
+	std::string host(url.host());
+	for (char &c : host) {
+		c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+	}
+	std::string tenantName = tenant(host);
+	Class &requestClass = m_classes[static_cast<size_t>(priority)];
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if (requestClass.queue.size() >= requestClass.maxQueued) {
+		// the producer is held instead of the queue growing
+		++requestClass.statistics.blocked;
+		bool room = waitUntil(requestClass.room, lock, deadline, [&requestClass]() {
+			return requestClass.queue.size() < requestClass.maxQueued;
+		});
+		--requestClass.statistics.blocked;
+		if (!room) {
+			++requestClass.statistics.expired;
+			return Slot();
+		}
+	}
+
+	Waiter waiter(host, tenantName);
+	QueueType::key_type key(deadline, m_arrivals++);
+	requestClass.queue.emplace(key, &waiter);
+	if (requestClass.queue.size() > requestClass.statistics.peakQueued) {
+		requestClass.statistics.peakQueued = requestClass.queue.size();
+	}
+	dispatch();
+	if (!waitUntil(waiter.wakeup, lock, deadline, [&waiter]() { return waiter.granted; })) {
+		requestClass.queue.erase(key);
+		++requestClass.statistics.expired;
+		requestClass.room.notify_one();
+		return Slot();
+	}
+
+	auto wait = std::chrono::duration_cast<std::chrono::microseconds>(ClockType::now() - arrival);
+	requestClass.statistics.totalWait += wait;
+	if (wait > requestClass.statistics.maxWait) {
+		requestClass.statistics.maxWait = wait;
+	}
+	return Slot(this, priority, std::move(host), std::move(tenantName));
+}
+
+RequestScheduler::ClockType::time_point RequestScheduler::deadline(Priority priority) const
+{
+	std::chrono::milliseconds maxWait;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		maxWait = m_classes[static_cast<size_t>(priority)].maxWait;
+	}
+	if (maxWait.count() == 0) {
+		return ClockType::time_point::max();
+	}
+	return ClockType::now() + maxWait;
+}
+
+WebResponse RequestScheduler::send(const WebRequest &request, Priority priority, bool post, const Url &url, const std::string &data)
+{
+	Slot slot = acquire(url, priority, deadline(priority));
+	if (!slot.isValid()) {
+		return TransportResponse(DeadlinePassed, std::string(), url);
+	}
+	// the copy doesn't come back here, but still goes through the cache
+	WebRequest scheduledRequest(request);
+	scheduledRequest.setScheduler(nullptr);
+	if (post) {
+		return scheduledRequest.post(url, data);
+	}
+	return scheduledRequest.get(url);
+}
+
+RequestScheduler::ClassStatistics RequestScheduler::statistics(Priority priority) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	const Class &requestClass = m_classes[static_cast<size_t>(priority)];
+	ClassStatistics statistics = requestClass.statistics;
+	statistics.queued = requestClass.queue.size();
+	return statistics;
+}
+
+size_t RequestScheduler::inFlight() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_inFlight;
+}
+
+std::string RequestScheduler::tenant(std::string_view host)
+{
+	std::string_view name = host.substr(0, host.find('.'));
+	for (std::string_view suffix : {std::string_view("-my"), std::string_view("-admin")}) {
+		if (name.length() > suffix.length() &&
+			name.compare(name.length() - suffix.length(), suffix.length(), suffix) == 0) {
+			name.remove_suffix(suffix.length());
+			break;
+		}
+	}
+	std::string tenantName(name);
+	for (char &c : tenantName) {
+		c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+	}
+	return tenantName;
+}
+
+void RequestScheduler::dispatch()
+{
+	for (Class &requestClass : m_classes) {
+		auto waiting = requestClass.queue.begin();
+		while (waiting != requestClass.queue.end() && m_inFlight < m_maxRequests) {
+			if (requestClass.maxRequests > 0 && requestClass.inFlight >= requestClass.maxRequests) {
+				break;
+			}
+			Waiter *waiter = waiting->second;
+			if ((m_maxRequestsPerHost > 0 && count(m_hostInFlight, waiter->host) >= m_maxRequestsPerHost) ||
+				(m_maxRequestsPerTenant > 0 && count(m_tenantInFlight, waiter->tenant) >= m_maxRequestsPerTenant)) {
+				// the next one may go to another host
+				++waiting;
+				continue;
+			}
+			++m_inFlight;
+			++requestClass.inFlight;
+			++m_hostInFlight[waiter->host];
+			++m_tenantInFlight[waiter->tenant];
+			++requestClass.statistics.dispatched;
+			waiting = requestClass.queue.erase(waiting);
+			waiter->granted = true;
+			waiter->wakeup.notify_one();
+			requestClass.room.notify_one();
+		}
+	}
+}
+
+void RequestScheduler::release(Priority priority, const std::string &host, const std::string &tenant)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	--m_inFlight;
+	--m_classes[static_cast<size_t>(priority)].inFlight;
+	auto hostCount = m_hostInFlight.find(host);
+	if (hostCount != m_hostInFlight.end() && --hostCount->second == 0) {
+		m_hostInFlight.erase(hostCount);
+	}
+	auto tenantCount = m_tenantInFlight.find(tenant);
+	if (tenantCount != m_tenantInFlight.end() && --tenantCount->second == 0) {
+		m_tenantInFlight.erase(tenantCount);
+	}
+	dispatch();
+}
+
+size_t RequestScheduler::count(const std::unordered_map<std::string, size_t> &counts, const std::string &name)
+{
+	auto found = counts.find(name);
+	return found != counts.end() ? found->second : 0;
+}
@@ -0,0 +1,227 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef COMMON_REQUESTSCHEDULER_H_
+#define COMMON_REQUESTSCHEDULER_H_
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+#include "Url.h"
+#include "WebResponse.h"
+
+namespace Microsoft {
+namespace Sharepoint {
+class WebRequest;
+
+// Decides which request may be sent next, set on a WebRequest with
+// setScheduler() or used directly through acquire(). A request waits for
+// a slot in the queue of its priority class; a free slot goes to the
+// highest class first and within a class to the request with the
+// earliest deadline. A request whose host or tenant already has its
+// limit of requests on the way is passed over, the next one in line may
+// go to another host.
+// The queue of every class is bounded: a producer finding it full is
+// held until there is room again instead of the queue growing. A request
+// still waiting when its deadline passes isn't sent at all, it is
+// answered with the status code DeadlinePassed.
+// The tenant of a host is the first part of its name without -my or
+// -admin, so contoso.sharepoint.com and contoso-my.sharepoint.com share
+// their limit.
+// FileCache::download() takes a slot of the scheduler set on its request
+// for the whole transfer. Requests of an AsyncEngine aren't scheduled,
+// the engine keeps a limit of its own; so the downloads of LibrarySync
+// and the listings of Crawler, which run on engines, aren't scheduled
+// either, their parallelism is their only limit.
+class RequestScheduler
+{
+ public:
+	enum class Priority
+	{
+		// a user waits for the answer, e.g. metadata of an open view
+		Interactive,
+		Normal,
+		// downloads, uploads and crawls
+		Bulk
+	};
+	static constexpr size_t PriorityCount = 3;
+
+	typedef std::chrono::steady_clock ClockType;
+
+	struct ClassStatistics
+	{
+		// requests waiting for a slot right now
+		size_t queued {0};
+		size_t peakQueued {0};
+		// producers held because the queue was full right now
+		size_t blocked {0};
+		uint64_t dispatched {0};
+		// requests dropped because their deadline passed
+		uint64_t expired {0};
+		// the time from acquire() until the slot was given
+		std::chrono::microseconds totalWait {0};
+		std::chrono::microseconds maxWait {0};
+	};
+
+	// holds a slot until it is destroyed, an invalid slot (deadline passed)
+	// holds nothing
+	class Slot
+	{
+		friend class RequestScheduler;
+
+	 public:
+		__declspec(dllexport)
+			Slot();
+		__declspec(dllexport)
+			Slot(Slot &&other);
+		__declspec(dllexport)
+			Slot &operator=(Slot &&other);
+		__declspec(dllexport)
+			~Slot();
+		Slot(const Slot &other) = delete;
+		Slot &operator=(const Slot &other) = delete;
+
+	 public:
+		__declspec(dllexport)
+			bool isValid() const;
+		// gives the slot back before the slot is destroyed
+		__declspec(dllexport)
+			void release();
+
+	 private:
+		Slot(RequestScheduler *scheduler, Priority priority, std::string &&host, std::string &&tenant);
+
+	 private:
+		RequestScheduler *m_scheduler;
+		Priority m_priority;
+		std::string m_host;
+		std::string m_tenant;
+	};
+
+ public:
+	// the status code of a request whose deadline passed while it waited
+	static constexpr long DeadlinePassed = -3;
+	static constexpr size_t DefaultMaxRequests = 16;
+	static constexpr size_t DefaultMaxQueued = 256;
+
+ public:
+	// 0 stands for no limit per host or per tenant
+	__declspec(dllexport)
+		explicit RequestScheduler(
+			size_t maxRequests = DefaultMaxRequests,
+			size_t maxRequestsPerHost = 0,
+			size_t maxRequestsPerTenant = 0);
+	__declspec(dllexport)
+		~RequestScheduler();
+	RequestScheduler(const RequestScheduler &other) = delete;
+	RequestScheduler &operator=(const RequestScheduler &other) = delete;
+
+ public:
+	// the most requests of the class on their way, so e.g. bulk requests
+	// can't take all slots; all of them by default
+	__declspec(dllexport)
+		void setMaxRequests(RequestScheduler::Priority priority, size_t maxRequests);
+	__declspec(dllexport)
+		void setMaxQueued(RequestScheduler::Priority priority, size_t maxQueued);
+	// the deadline of requests sent through a WebRequest, relative to the
+	// time they are sent; 0, the default, waits as long as it takes
+	__declspec(dllexport)
+		void setMaxWait(RequestScheduler::Priority priority, std::chrono::milliseconds maxWait);
+
+ public:
+	// waits for a slot to send a request to the url, the slot is invalid if
+	// the deadline passed first
+	__declspec(dllexport)
+		RequestScheduler::Slot acquire(
+			const Url &url,
+			RequestScheduler::Priority priority,
+			RequestScheduler::ClockType::time_point deadline = RequestScheduler::ClockType::time_point::max());
+	// the deadline setMaxWait() gives a request of the class asking now
+	__declspec(dllexport)
+		RequestScheduler::ClockType::time_point deadline(RequestScheduler::Priority priority) const;
+	// sends the request once it has a slot, with the deadline of setMaxWait()
+	__declspec(dllexport)
+		WebResponse send(
+			const WebRequest &request,
+			RequestScheduler::Priority priority,
+			bool post,
+			const Url &url,
+			const std::string &data);
+
+ public:
+	__declspec(dllexport)
+		RequestScheduler::ClassStatistics statistics(RequestScheduler::Priority priority) const;
+	// requests on their way right now
+	__declspec(dllexport)
+		size_t inFlight() const;
+	__declspec(dllexport)
+		static std::string tenant(std::string_view host);
+
+ private:
+	struct Waiter;
+	// waiters in the order they get a slot: by deadline, then by arrival
+	typedef std::map<std::pair<ClockType::time_point, uint64_t>, Waiter *> QueueType;
+
+	struct Class
+	{
+		QueueType queue;
+		size_t maxRequests {0};
+		size_t maxQueued {DefaultMaxQueued};
+		std::chrono::milliseconds maxWait {0};
+		size_t inFlight {0};
+		// producers waiting for room in the queue
+		std::condition_variable room;
+		ClassStatistics statistics;
+	};
+
+ private:
+	// gives free slots to waiting requests, the lock is held
+	void dispatch();
+	void release(Priority priority, const std::string &host, const std::string &tenant);
+	static size_t count(const std::unordered_map<std::string, size_t> &counts, const std::string &name);
+
+ private:
+	size_t m_maxRequests;
+	size_t m_maxRequestsPerHost;
+	size_t m_maxRequestsPerTenant;
+
+	mutable std::mutex m_mutex;
+	std::array<Class, PriorityCount> m_classes;
+	size_t m_inFlight;
+	std::unordered_map<std::string, size_t> m_hostInFlight;
+	std::unordered_map<std::string, size_t> m_tenantInFlight;
+	uint64_t m_arrivals;
+};
+}  // namespace Sharepoint
+}  // namespace Microsoft
+
+#endif  // COMMON_REQUESTSCHEDULER_H_
@@ -0,0 +1,59 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef COMMON_REQUESTTIMINGS_H_
+#define COMMON_REQUESTTIMINGS_H_
+
+#include <chrono>
+
+namespace Microsoft {
+namespace Sharepoint {
+// Where the time of one request went, captured from curl when the
+// transfer completes. Every point in time counts from the start of the
+// request and includes the phases before it, so the tls handshake took
+// appConnect - connect and the server took startTransfer - preTransfer.
+struct RequestTimings
+{
+	// name resolved
+	std::chrono::microseconds nameLookup {0};
+	// tcp connection established
+	std::chrono::microseconds connect {0};
+	// tls handshake done, 0 for plain http
+	std::chrono::microseconds appConnect {0};
+	// request about to be sent
+	std::chrono::microseconds preTransfer {0};
+	// first byte of the response received
+	std::chrono::microseconds startTransfer {0};
+	// response completely received
+	std::chrono::microseconds total {0};
+	// request headers and body sent
+	long long bytesUp {0};
+	// response headers and body received
+	long long bytesDown {0};
+	// no new connection was opened for the request
+	bool connectionReused {false};
+};
+}  // namespace Sharepoint
+}  // namespace Microsoft
+
+#endif  // COMMON_REQUESTTIMINGS_H_
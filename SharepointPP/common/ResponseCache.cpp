@@ -0,0 +1,266 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "ResponseCache.h"
+
+#include <cctype>
+#include <string_view>
+#include <utility>
+
+#include "Transport.h"
+#include "TransportResponse.h"
+
+using Microsoft::Sharepoint::ResponseCache;
+using Microsoft::Sharepoint::Transport;
+using Microsoft::Sharepoint::TransportResponse;
+using Microsoft::Sharepoint::WebRequest;
+using Microsoft::Sharepoint::WebResponse;
+
+namespace {
+bool equalsNoCase(std::string_view left, std::string_view right)
+{
+	if (left.length() != right.length()) {
+		return false;
+	}
+	for (size_t i = 0; i < left.length(); ++i) {
+		if (tolower(static_cast<unsigned char>(left[i])) != tolower(static_cast<unsigned char>(right[i]))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// the value of the last header with the name, curl keeps the line break
+std::string headerValue(const WebResponse::HeaderContainerType &headers, std::string_view name)
+{
+	std::string value;
+	for (auto &header : headers) {
+		if (equalsNoCase(header.first, name)) {
+			value = header.second;
+		}
+	}
+	while (!value.empty() && (value.back() == '\r' || value.back() == '\n' || value.back() == ' ')) {
+		value.pop_back();
+	}
+	return value;
+}
+
+// the request headers which select another representation of the same url
+const char *const representationHeaders[] = {"Accept", "Accept-Language", "OData-Version"};
+}
+
+struct ResponseCache::StoredResponse
+{
+	std::string key;
+	// shared with the entry which replaces this one on revalidation
+	std::shared_ptr<const std::string> body;
+	WebResponse::HeaderContainerType headers;
+	std::string etag;
+	std::string lastModified;
+	size_t cost {0};
+};
+
+ResponseCache::ResponseCache(size_t maxBytes) :
+	m_maxBytes(maxBytes)
+{
+}
+
+ResponseCache::~ResponseCache()
+{
+}
+
+WebResponse ResponseCache::get(const WebRequest &request, const Url &url)
+{
+	WebRequest conditionalRequest(request);
+	Lookup lookup = prepare(url, conditionalRequest);
+	WebResponse response = conditionalRequest.transport()->send(
+		conditionalRequest, Transport::Method::Get, url, std::string());
+	return complete(std::move(lookup), url, std::move(response));
+}
+
+ResponseCache::Lookup ResponseCache::prepare(const Url &url, WebRequest &request)
+{
+	Lookup lookup;
+	lookup.key = key(request, url);
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		++m_statistics.requests;
+		auto entry = m_index.find(lookup.key);
+		if (entry != m_index.end()) {
+			lookup.stored = *entry->second;
+			m_entries.splice(m_entries.begin(), m_entries, entry->second);
+		}
+	}
+	if (lookup.stored) {
+		if (!lookup.stored->etag.empty()) {
+			request.addHeader("If-None-Match", lookup.stored->etag);
+		}
+		if (!lookup.stored->lastModified.empty()) {
+			request.addHeader("If-Modified-Since", lookup.stored->lastModified);
+		}
+	}
+	return lookup;
+}
+
+WebResponse ResponseCache::complete(Lookup &&lookup, const Url &url, WebResponse &&response)
+{
+	long httpStatusCode = response.httpStatusCode();
+	if (httpStatusCode == 304 && lookup.stored) {
+		const StoredResponse &stored = *lookup.stored;
+		WebResponse::HeaderContainerType notModifiedHeaders = response.header();
+		std::string etag = headerValue(notModifiedHeaders, "ETag");
+		std::string lastModified = headerValue(notModifiedHeaders, "Last-Modified");
+		if ((!etag.empty() && etag != stored.etag) ||
+			(!lastModified.empty() && lastModified != stored.lastModified)) {
+			// the server may hand out new validators for the same body
+			auto revalidated = std::make_shared<StoredResponse>(stored);
+			revalidated->etag = etag.empty() ? stored.etag : etag;
+			revalidated->lastModified = lastModified.empty() ? stored.lastModified : lastModified;
+			store(lookup.key, std::move(revalidated));
+		}
+		TransportResponse served(200, std::string(), url);
+		served.setSharedBody(stored.body);
+		for (auto &header : stored.headers) {
+			served.addHeader(header.first, header.second);
+		}
+		served.setEffectiveUrl(response.effectiveUrl());
+		// the timings of the round trip which revalidated the body
+		served.setTimings(response.timings());
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			++m_statistics.hits;
+		}
+		return std::move(served);
+	}
+
+	if (lookup.stored) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		++m_statistics.revalidationMisses;
+	}
+	if (httpStatusCode != 200) {
+		if (httpStatusCode == 404 || httpStatusCode == 410) {
+			erase(lookup.key);
+		}
+		return std::move(response);
+	}
+
+	WebResponse::HeaderContainerType headers = response.header();
+	auto stored = std::make_shared<StoredResponse>();
+	stored->etag = headerValue(headers, "ETag");
+	stored->lastModified = headerValue(headers, "Last-Modified");
+	std::string cacheControl = headerValue(headers, "Cache-Control");
+	for (char &c : cacheControl) {
+		c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+	}
+	bool noStore = cacheControl.find("no-store") != std::string::npos;
+	if ((stored->etag.empty() && stored->lastModified.empty()) || noStore) {
+		// can't be revalidated, a stored older version would only take space
+		erase(lookup.key);
+		return std::move(response);
+	}
+	// the response and the cache hold the same body
+	stored->body = response.sharedResponse();
+	stored->cost = lookup.key.length() + stored->body->length() + stored->etag.length() + stored->lastModified.length();
+	for (auto &header : headers) {
+		stored->cost += header.first.length() + header.second.length();
+	}
+	stored->headers = std::move(headers);
+	stored->key = lookup.key;
+	store(lookup.key, std::move(stored));
+	return std::move(response);
+}
+
+ResponseCache::Statistics ResponseCache::statistics() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	Statistics statistics = m_statistics;
+	statistics.entries = m_entries.size();
+	return statistics;
+}
+
+double ResponseCache::hitRatio() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_statistics.requests == 0) {
+		return 0.0;
+	}
+	return static_cast<double>(m_statistics.hits) / static_cast<double>(m_statistics.requests);
+}
+
+void ResponseCache::clear()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_index.clear();
+	m_entries.clear();
+	m_statistics.bytes = 0;
+}
+
+void ResponseCache::store(const std::string &key, std::shared_ptr<const StoredResponse> &&stored)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto existing = m_index.find(key);
+	if (existing != m_index.end()) {
+		m_statistics.bytes -= (*existing->second)->cost;
+		m_entries.erase(existing->second);
+		m_index.erase(existing);
+	}
+	if (stored->cost > m_maxBytes) {
+		return;
+	}
+	while (m_statistics.bytes + stored->cost > m_maxBytes && !m_entries.empty()) {
+		const StoredResponse &leastRecentlyUsed = *m_entries.back();
+		m_statistics.bytes -= leastRecentlyUsed.cost;
+		m_index.erase(leastRecentlyUsed.key);
+		m_entries.pop_back();
+		++m_statistics.evictions;
+	}
+	m_statistics.bytes += stored->cost;
+	++m_statistics.stores;
+	m_entries.push_front(std::move(stored));
+	m_index.emplace(key, m_entries.begin());
+}
+
+void ResponseCache::erase(const std::string &key)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto existing = m_index.find(key);
+	if (existing != m_index.end()) {
+		m_statistics.bytes -= (*existing->second)->cost;
+		m_entries.erase(existing->second);
+		m_index.erase(existing);
+	}
+}
+
+std::string ResponseCache::key(const WebRequest &request, const Url &url)
+{
+	std::string result(url.str());
+	WebRequest::HeaderContainerType headers = request.headers();
+	for (const char *name : representationHeaders) {
+		result += '\n';
+		for (auto &header : headers) {
+			if (equalsNoCase(header.first, name)) {
+				result += header.second;
+			}
+		}
+	}
+	return result;
+}
@@ -0,0 +1,132 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef COMMON_RESPONSECACHE_H_
+#define COMMON_RESPONSECACHE_H_
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "Url.h"
+#include "WebRequest.h"
+#include "WebResponse.h"
+
+namespace Microsoft {
+namespace Sharepoint {
+// An http cache for gets, set on a WebRequest with setResponseCache().
+// Responses with an ETag or a Last-Modified header are stored, keyed by
+// the url and the headers which select the representation (Accept,
+// Accept-Language, OData-Version). A later get of the same key sends
+// If-None-Match / If-Modified-Since and, when the server answers 304,
+// gets the stored body back with status 200, so unchanged data only
+// costs a round trip without a body.
+// The stored responses take at most the given number of bytes, the
+// least recently used ones are evicted first. The cache can be shared by
+// many threads, but only by the requests of one user: sharepoint trims
+// responses to what the user may see.
+class ResponseCache
+{
+ public:
+	struct Statistics
+	{
+		// gets sent through the cache
+		uint64_t requests {0};
+		// answered with 304 and served from the cache
+		uint64_t hits {0};
+		// sent with validators, but the resource has changed
+		uint64_t revalidationMisses {0};
+		uint64_t stores {0};
+		uint64_t evictions {0};
+		size_t entries {0};
+		size_t bytes {0};
+	};
+
+ private:
+	struct StoredResponse;
+
+ public:
+	// a get on its way, see prepare()
+	struct Lookup
+	{
+		std::string key;
+		// nullptr if nothing is stored for the key
+		std::shared_ptr<const StoredResponse> stored;
+	};
+
+ public:
+	static constexpr size_t DefaultMaxBytes = 32 * 1024 * 1024;
+
+ public:
+	__declspec(dllexport)
+		explicit ResponseCache(size_t maxBytes = DefaultMaxBytes);
+	__declspec(dllexport)
+		~ResponseCache();
+	ResponseCache(const ResponseCache &other) = delete;
+	ResponseCache &operator=(const ResponseCache &other) = delete;
+
+ public:
+	// sends the get through the transport of the request
+	__declspec(dllexport)
+		WebResponse get(const WebRequest &request, const Url &url);
+	// adds the validators of the stored response to the request, the
+	// lookup has to be handed to complete() with the response
+	__declspec(dllexport)
+		ResponseCache::Lookup prepare(const Url &url, WebRequest &request);
+	// stores the response or, if the server answered 304, returns the
+	// stored one in its place
+	__declspec(dllexport)
+		WebResponse complete(ResponseCache::Lookup &&lookup, const Url &url, WebResponse &&response);
+
+ public:
+	__declspec(dllexport)
+		ResponseCache::Statistics statistics() const;
+	// hits per request, 0 before the first one
+	__declspec(dllexport)
+		double hitRatio() const;
+	__declspec(dllexport)
+		void clear();
+
+ private:
+	typedef std::list<std::shared_ptr<const StoredResponse>> EntryList;
+
+ private:
+	void store(const std::string &key, std::shared_ptr<const StoredResponse> &&stored);
+	void erase(const std::string &key);
+	static std::string key(const WebRequest &request, const Url &url);
+
+ private:
+	size_t m_maxBytes;
+	mutable std::mutex m_mutex;
+	// most recently used first
+	EntryList m_entries;
+	std::unordered_map<std::string, EntryList::iterator> m_index;
+	Statistics m_statistics;
+};
+}  // namespace Sharepoint
+}  // namespace Microsoft
+
+#endif  // COMMON_RESPONSECACHE_H_
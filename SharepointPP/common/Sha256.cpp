@@ -0,0 +1,173 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "Sha256.h"
+
+#include <cstring>
+
+using Microsoft::Sharepoint::Sha256;
+
+namespace {
+const uint32_t roundConstants[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+inline uint32_t rotateRight(uint32_t value, int bits)
+{
+	return (value >> bits) | (value << (32 - bits));
+}
+}
+
+Sha256::Sha256() :
+	m_state {{0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19}},
+	m_block(),
+	m_blockLength(0),
+	m_length(0)
+{
+}
+
+void Sha256::update(std::string_view data)
+{
+	const uint8_t *input = reinterpret_cast<const uint8_t *>(data.data());
+	size_t remaining = data.length();
+	m_length += remaining;
+	if (m_blockLength > 0) {
+		size_t taken = m_block.size() - m_blockLength < remaining ? m_block.size() - m_blockLength : remaining;
+		memcpy(m_block.data() + m_blockLength, input, taken);
+		m_blockLength += taken;
+		input += taken;
+		remaining -= taken;
+		if (m_blockLength < m_block.size()) {
+			return;
+		}
+		transform(m_block.data());
+		m_blockLength = 0;
+	}
+	// whole blocks are hashed straight from the input
+	while (remaining >= m_block.size()) {
+		transform(input);
+		input += m_block.size();
+		remaining -= m_block.size();
+	}
+	memcpy(m_block.data(), input, remaining);
+	m_blockLength = remaining;
+}
+
+Sha256::DigestType Sha256::digest()
+{
+	uint64_t bitLength = m_length * 8;
+	// a single 1 bit, zeros up to 56 bytes in the block and the length
+	m_block[m_blockLength++] = 0x80;
+	if (m_blockLength > 56) {
+		memset(m_block.data() + m_blockLength, 0, m_block.size() - m_blockLength);
+		transform(m_block.data());
+		m_blockLength = 0;
+	}
+	memset(m_block.data() + m_blockLength, 0, 56 - m_blockLength);
+	for (int i = 0; i < 8; ++i) {
+		m_block[56 + i] = static_cast<uint8_t>(bitLength >> (56 - 8 * i));
+	}
+	transform(m_block.data());
+
+	DigestType result;
+	for (size_t i = 0; i < m_state.size(); ++i) {
+		for (int byte = 0; byte < 4; ++byte) {
+			result[i * 4 + byte] = static_cast<uint8_t>(m_state[i] >> (24 - 8 * byte));
+		}
+	}
+	return result;
+}
+
+std::string Sha256::hexDigest(std::string_view data)
+{
+	Sha256 sha;
+	sha.update(data);
+	return hex(sha.digest());
+}
+
+std::string Sha256::hex(const DigestType &digest)
+{
+	static const char hexDigits[] = "0123456789abcdef";
+	std::string hexString;
+	hexString.reserve(digest.size() * 2);
+	for (uint8_t byte : digest) {
+		hexString += hexDigits[byte >> 4];
+		hexString += hexDigits[byte & 0x0f];
+	}
+	return hexString;
+}
+
+void Sha256::transform(const uint8_t *block)
+{
+	uint32_t words[64];
+	for (int i = 0; i < 16; ++i) {
+		words[i] = (static_cast<uint32_t>(block[i * 4]) << 24) |
+			(static_cast<uint32_t>(block[i * 4 + 1]) << 16) |
+			(static_cast<uint32_t>(block[i * 4 + 2]) << 8) |
+			static_cast<uint32_t>(block[i * 4 + 3]);
+	}
+	for (int i = 16; i < 64; ++i) {
+		uint32_t s0 = rotateRight(words[i - 15], 7) ^ rotateRight(words[i - 15], 18) ^ (words[i - 15] >> 3);
+		uint32_t s1 = rotateRight(words[i - 2], 17) ^ rotateRight(words[i - 2], 19) ^ (words[i - 2] >> 10);
+		words[i] = words[i - 16] + s0 + words[i - 7] + s1;
+	}
+
+	uint32_t a = m_state[0];
+	uint32_t b = m_state[1];
+	uint32_t c = m_state[2];
+	uint32_t d = m_state[3];
+	uint32_t e = m_state[4];
+	uint32_t f = m_state[5];
+	uint32_t g = m_state[6];
+	uint32_t h = m_state[7];
+	for (int i = 0; i < 64; ++i) {
+		uint32_t s1 = rotateRight(e, 6) ^ rotateRight(e, 11) ^ rotateRight(e, 25);
+		uint32_t choice = (e & f) ^ (~e & g);
+		uint32_t temp1 = h + s1 + choice + roundConstants[i] + words[i];
+		uint32_t s0 = rotateRight(a, 2) ^ rotateRight(a, 13) ^ rotateRight(a, 22);
+		uint32_t majority = (a & b) ^ (a & c) ^ (b & c);
+		uint32_t temp2 = s0 + majority;
+		h = g;
+		g = f;
+		f = e;
+		e = d + temp1;
+		d = c;
+		c = b;
+		b = a;
+		a = temp1 + temp2;
+	}
+	m_state[0] += a;
+	m_state[1] += b;
+	m_state[2] += c;
+	m_state[3] += d;
+	m_state[4] += e;
+	m_state[5] += f;
+	m_state[6] += g;
+	m_state[7] += h;
+}
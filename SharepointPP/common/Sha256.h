@@ -0,0 +1,70 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef COMMON_SHA256_H_
+#define COMMON_SHA256_H_
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace Microsoft {
+namespace Sharepoint {
+// SHA-256 (FIPS 180-4), fed in pieces with update()
+class Sha256
+{
+ public:
+	typedef std::array<uint8_t, 32> DigestType;
+
+ public:
+	__declspec(dllexport)
+		Sha256();
+
+ public:
+	__declspec(dllexport)
+		void update(std::string_view data);
+	// the object can't be updated afterwards
+	__declspec(dllexport)
+		Sha256::DigestType digest();
+
+ public:
+	// the digest of the data as 64 lower case hex digits
+	__declspec(dllexport)
+		static std::string hexDigest(std::string_view data);
+	__declspec(dllexport)
+		static std::string hex(const Sha256::DigestType &digest);
+
+ private:
+	void transform(const uint8_t *block);
+
+ private:
+	std::array<uint32_t, 8> m_state;
+	std::array<uint8_t, 64> m_block;
+	size_t m_blockLength;
+	uint64_t m_length;
+};
+}  // namespace Sharepoint
+}  // namespace Microsoft
+
+#endif  // COMMON_SHA256_H_
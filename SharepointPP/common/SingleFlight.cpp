@@ -0,0 +1,143 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "SingleFlight.h"
+
+#include <utility>
+
+#include "TransportResponse.h"
+
+using Microsoft::Sharepoint::SingleFlight;
+using Microsoft::Sharepoint::TransportResponse;
+using Microsoft::Sharepoint::WebResponse;
+
+struct SingleFlight::Flight
+{
+	bool landed {false};
+	// stays -1 if the get threw
+	long httpStatusCode {-1};
+	std::string effectiveUrl;
+	WebResponse::HeaderContainerType headers;
+	WebResponse::CookieContainerType cookies;
+	Microsoft::Sharepoint::RequestTimings timings;
+	std::shared_ptr<const std::string> body;
+};
+
+SingleFlight::SingleFlight()
+{
+}
+
+SingleFlight::~SingleFlight()
+{
+}
+
+WebResponse SingleFlight::get(const WebRequest &request, const Url &url)
+{
+	std::string flightKey = key(request, url);
+	std::unique_lock<std::mutex> lock(m_mutex);
+	++m_statistics.requests;
+	auto found = m_flights.find(flightKey);
+	if (found != m_flights.end()) {
+		std::shared_ptr<Flight> flight = found->second;
+		++m_statistics.joined;
+		m_landed.wait(lock, [&flight]() { return flight->landed; });
+		lock.unlock();
+		return answer(*flight, url);
+	}
+	auto flight = std::make_shared<Flight>();
+	m_flights.emplace(flightKey, flight);
+	++m_statistics.flights;
+	lock.unlock();
+
+	// lands the flight however the get ends, if it throws the waiting
+	// gets are answered with a failed response
+	struct Landing
+	{
+		SingleFlight *singleFlight;
+		const std::string &flightKey;
+		Flight &flight;
+		~Landing()
+		{
+			std::unique_lock<std::mutex> lock(singleFlight->m_mutex);
+			flight.landed = true;
+			// a get starting from now on is sent again
+			singleFlight->m_flights.erase(flightKey);
+			lock.unlock();
+			singleFlight->m_landed.notify_all();
+		}
+	} landing {this, flightKey, *flight};
+
+	// the copy doesn't come back here, but still goes through the cache
+	WebRequest flightRequest(request);
+	flightRequest.setSingleFlight(nullptr);
+	WebResponse response = flightRequest.get(url);
+	flight->effectiveUrl = response.effectiveUrl();
+	flight->headers = response.header();
+	flight->cookies = response.cookies();
+	flight->timings = response.timings();
+	flight->body = response.sharedResponse();
+	flight->httpStatusCode = response.httpStatusCode();
+	return response;
+}
+
+SingleFlight::Statistics SingleFlight::statistics() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_statistics;
+}
+
+size_t SingleFlight::inFlight() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_flights.size();
+}
+
+std::string SingleFlight::key(const WebRequest &request, const Url &url)
+{
+	// sharepoint trims responses to what the user may see, the cookies
+	// tell the users apart
+	std::string flightKey = url.str();
+	for (auto &header : request.headers()) {
+		flightKey += '\n';
+		flightKey += header.first;
+		flightKey += ": ";
+		flightKey += header.second;
+	}
+	flightKey += "\nCookie: ";
+	flightKey += request.cookieHeader(url);
+	return flightKey;
+}
+
+WebResponse SingleFlight::answer(const Flight &flight, const Url &url)
+{
+	TransportResponse response(flight.httpStatusCode, std::string(), url);
+	response.setEffectiveUrl(flight.effectiveUrl);
+	response.setSharedBody(flight.body);
+	for (auto &header : flight.headers) {
+		response.addHeader(header.first, header.second);
+	}
+	for (auto &cookie : flight.cookies) {
+		response.addCookie(cookie.first, cookie.second);
+	}
+	response.setTimings(flight.timings);
+	return std::move(response);
+}
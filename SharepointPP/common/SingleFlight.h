@@ -0,0 +1,101 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef COMMON_SINGLEFLIGHT_H_
+#define COMMON_SINGLEFLIGHT_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "Url.h"
+#include "WebRequest.h"
+#include "WebResponse.h"
+
+namespace Microsoft {
+namespace Sharepoint {
+// Collapses identical gets which are on their way at the same time into
+// one request, set on a WebRequest with setSingleFlight(). Gets are
+// identical if they go to the same url with the same headers and the
+// same cookies. The first get is sent, the others wait for its response.
+// Every caller gets a response of its own, but all of them share the
+// body of the one response instead of copying it (see
+// WebResponse::sharedResponse()). A failed response is handed to all
+// waiting callers as well, if the get throws they get a response with
+// the status code -1 while the exception goes to its caller.
+// Nothing is kept once the response is there, the next get is sent again;
+// a ResponseCache on the request still revalidates the one get which is
+// sent.
+class SingleFlight
+{
+ public:
+	struct Statistics
+	{
+		// gets sent through the single flight
+		uint64_t requests {0};
+		// gets which went to the server
+		uint64_t flights {0};
+		// gets answered by the response of another one
+		uint64_t joined {0};
+	};
+
+ public:
+	__declspec(dllexport)
+		SingleFlight();
+	__declspec(dllexport)
+		~SingleFlight();
+	SingleFlight(const SingleFlight &other) = delete;
+	SingleFlight &operator=(const SingleFlight &other) = delete;
+
+ public:
+	// sends the get or waits for the identical one already on its way
+	__declspec(dllexport)
+		WebResponse get(const WebRequest &request, const Url &url);
+
+ public:
+	__declspec(dllexport)
+		SingleFlight::Statistics statistics() const;
+	// gets on their way right now
+	__declspec(dllexport)
+		size_t inFlight() const;
+
+ private:
+	struct Flight;
+
+ private:
+	static std::string key(const WebRequest &request, const Url &url);
+	static WebResponse answer(const Flight &flight, const Url &url);
+
+ private:
+	mutable std::mutex m_mutex;
+	std::condition_variable m_landed;
+	std::unordered_map<std::string, std::shared_ptr<Flight>> m_flights;
+	Statistics m_statistics;
+};
+}  // namespace Sharepoint
+}  // namespace Microsoft
+
+#endif  // COMMON_SINGLEFLIGHT_H_
@@ -0,0 +1,173 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "SyncIndex.h"
+
+#include <cstring>
+#include <fstream>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include "MappedFile.h"
+
+using Microsoft::Sharepoint::MappedFile;
+using Microsoft::Sharepoint::SyncIndex;
+
+namespace fs = std::filesystem;
+
+namespace {
+const char magic[8] = {'S', 'P', 'S', 'Y', 'N', 'C', '1', '\n'};
+
+// followed by the etag, the path and the content version
+struct Record
+{
+	int64_t itemId;
+	uint64_t size;
+	int64_t modified;
+	uint32_t folder;
+	uint32_t etagLength;
+	uint32_t pathLength;
+	// reserved and 0 in indexes written without content versions
+	uint32_t contentVersionLength;
+};
+}  // namespace
+
+SyncIndex::SyncIndex(const fs::path &path) :
+	m_path(path)
+{
+}
+
+SyncIndex::~SyncIndex()
+{
+}
+
+bool SyncIndex::load()
+{
+	m_entries.clear();
+	std::error_code error;
+	if (!fs::exists(m_path, error)) {
+		return true;
+	}
+	std::shared_ptr<MappedFile> file = MappedFile::open(m_path.string());
+	if (!file) {
+		return false;
+	}
+	std::string_view data = file->view();
+	if (data.length() < sizeof(magic) || memcmp(data.data(), magic, sizeof(magic)) != 0) {
+		return false;
+	}
+	size_t position = sizeof(magic);
+	while (position < data.length()) {
+		Record record;
+		if (data.length() - position < sizeof(record)) {
+			m_entries.clear();
+			return false;
+		}
+		// the mapping gives no alignment for the records
+		memcpy(&record, data.data() + position, sizeof(record));
+		position += sizeof(record);
+		if (data.length() - position <
+			static_cast<size_t>(record.etagLength) + record.pathLength + record.contentVersionLength) {
+			m_entries.clear();
+			return false;
+		}
+		Entry entry;
+		entry.etag.assign(data.data() + position, record.etagLength);
+		position += record.etagLength;
+		entry.path.assign(data.data() + position, record.pathLength);
+		position += record.pathLength;
+		entry.contentVersion.assign(data.data() + position, record.contentVersionLength);
+		position += record.contentVersionLength;
+		entry.size = record.size;
+		entry.modified = record.modified;
+		entry.folder = record.folder != 0;
+		m_entries[static_cast<long>(record.itemId)] = std::move(entry);
+	}
+	return true;
+}
+
+bool SyncIndex::save() const
+{
+	std::string data(magic, sizeof(magic));
+	for (auto &item : m_entries) {
+		const Entry &entry = item.second;
+		Record record {};
+		record.itemId = item.first;
+		record.size = entry.size;
+		record.modified = entry.modified;
+		record.folder = entry.folder ? 1 : 0;
+		record.etagLength = static_cast<uint32_t>(entry.etag.length());
+		record.pathLength = static_cast<uint32_t>(entry.path.length());
+		record.contentVersionLength = static_cast<uint32_t>(entry.contentVersion.length());
+		data.append(reinterpret_cast<const char *>(&record), sizeof(record));
+		data += entry.etag;
+		data += entry.path;
+		data += entry.contentVersion;
+	}
+
+	fs::path temporaryPath(m_path);
+	temporaryPath += ".tmp";
+	{
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		file.write(data.data(), static_cast<std::streamsize>(data.length()));
+		file.close();
+		if (!file) {
+			std::error_code error;
+			fs::remove(temporaryPath, error);
+			return false;
+		}
+	}
+	std::error_code error;
+	fs::rename(temporaryPath, m_path, error);
+	if (error) {
+		fs::remove(temporaryPath, error);
+		return false;
+	}
+	return true;
+}
+
+const SyncIndex::Entry *SyncIndex::find(long itemId) const
+{
+	auto entry = m_entries.find(itemId);
+	return entry != m_entries.end() ? &entry->second : nullptr;
+}
+
+void SyncIndex::set(long itemId, Entry &&entry)
+{
+	m_entries[itemId] = std::move(entry);
+}
+
+void SyncIndex::erase(long itemId)
+{
+	m_entries.erase(itemId);
+}
+
+void SyncIndex::clear()
+{
+	m_entries.clear();
+}
+
+const SyncIndex::EntryContainerType &SyncIndex::entries() const
+{
+	return m_entries;
+}
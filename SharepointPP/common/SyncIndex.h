@@ -0,0 +1,94 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef COMMON_SYNCINDEX_H_
+#define COMMON_SYNCINDEX_H_
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+
+namespace Microsoft {
+namespace Sharepoint {
+// The state of a synchronized library: list item id -> local path, etag,
+// content version and size of the file and the modification time of the
+// local copy.
+// The file holds fixed size record headers followed by the etag, the
+// path and the content version, it is mapped into memory to be read and replaced as a whole by a
+// renamed temporary file to be written, so it always holds a complete
+// state. Not thread safe.
+class SyncIndex
+{
+ public:
+	struct Entry
+	{
+		// relative to the synchronized directory, separated by '/'
+		std::string path;
+		// of the list item, changes with every edit of the metadata as well
+		std::string etag;
+		// of the file, empty if the server didn't tell
+		std::string contentVersion;
+		uint64_t size {0};
+		// last_write_time of the local file
+		int64_t modified {0};
+		bool folder {false};
+	};
+
+	typedef std::unordered_map<long, SyncIndex::Entry> EntryContainerType;
+
+ public:
+	__declspec(dllexport)
+		explicit SyncIndex(const std::filesystem::path &path);
+	__declspec(dllexport)
+		~SyncIndex();
+
+ public:
+	// replaces the entries by the ones of the file, a missing file gives
+	// none, false if the file is damaged
+	__declspec(dllexport)
+		bool load();
+	__declspec(dllexport)
+		bool save() const;
+
+ public:
+	// nullptr if the item is unknown
+	__declspec(dllexport)
+		const SyncIndex::Entry *find(long itemId) const;
+	__declspec(dllexport)
+		void set(long itemId, SyncIndex::Entry &&entry);
+	__declspec(dllexport)
+		void erase(long itemId);
+	__declspec(dllexport)
+		void clear();
+	__declspec(dllexport)
+		const SyncIndex::EntryContainerType &entries() const;
+
+ private:
+	std::filesystem::path m_path;
+	EntryContainerType m_entries;
+};
+}  // namespace Sharepoint
+}  // namespace Microsoft
+
+#endif  // COMMON_SYNCINDEX_H_
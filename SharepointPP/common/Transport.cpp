@@ -0,0 +1,73 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "Transport.h"
+
+#include <mutex>
+#include <utility>
+
+#include "CurlTransport.h"
+#include "WebRequest.h"
+
+using Microsoft::Sharepoint::CurlTransport;
+using Microsoft::Sharepoint::Transport;
+using Microsoft::Sharepoint::WebResponse;
+
+namespace {
+struct DefaultTransport
+{
+	std::mutex mutex;
+	std::shared_ptr<Transport> transport {std::make_shared<CurlTransport>()};
+};
+
+DefaultTransport &defaultTransportSlot()
+{
+	static DefaultTransport slot;
+	return slot;
+}
+}  // namespace
+
+Transport::~Transport()
+{
+}
+
+void Transport::sendAsync(const WebRequest &request, Method method, const Url &url, std::string &&data, CompletionType &&completion)
+{
+	WebResponse response = send(request, method, url, std::move(data));
+	if (completion) {
+		completion(std::move(response));
+	}
+}
+
+std::shared_ptr<Transport> Transport::defaultTransport()
+{
+	DefaultTransport &slot = defaultTransportSlot();
+	std::lock_guard<std::mutex> lock(slot.mutex);
+	return slot.transport;
+}
+
+void Transport::setDefaultTransport(const std::shared_ptr<Transport> &transport)
+{
+	DefaultTransport &slot = defaultTransportSlot();
+	std::lock_guard<std::mutex> lock(slot.mutex);
+	slot.transport = transport ? transport : std::make_shared<CurlTransport>();
+}
@@ -0,0 +1,77 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef COMMON_TRANSPORT_H_
+#define COMMON_TRANSPORT_H_
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "Url.h"
+#include "WebResponse.h"
+
+namespace Microsoft {
+namespace Sharepoint {
+class WebRequest;
+
+// Sends the requests of WebRequest and the AsyncEngine.
+// The CurlTransport talks to the network, other transports answer the
+// requests themselves, e.g. the MockSharepointTransport for benchmarks
+// without a tenant. A request uses its own transport if it has one and
+// the default transport of the process otherwise.
+class Transport
+{
+ public:
+	enum class Method
+	{
+		Get,
+		Post
+	};
+	typedef std::function<void(WebResponse &&response)> CompletionType;
+
+ public:
+	__declspec(dllexport)
+		virtual ~Transport();
+
+ public:
+	// sends the request and blocks until the response is complete
+	__declspec(dllexport)
+		virtual WebResponse send(const WebRequest &request, Transport::Method method, const Url &url, std::string &&data) = 0;
+	// sends the request and calls the completion with the response,
+	// on any thread. Sends on the calling thread unless overridden.
+	__declspec(dllexport)
+		virtual void sendAsync(const WebRequest &request, Transport::Method method, const Url &url, std::string &&data, Transport::CompletionType &&completion);
+
+ public:
+	// the CurlTransport until another one is set
+	__declspec(dllexport)
+		static std::shared_ptr<Transport> defaultTransport();
+	// nullptr sets the CurlTransport again
+	__declspec(dllexport)
+		static void setDefaultTransport(const std::shared_ptr<Transport> &transport);
+};
+}  // namespace Sharepoint
+}  // namespace Microsoft
+
+#endif  // COMMON_TRANSPORT_H_
@@ -0,0 +1,112 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef COMMON_TRANSPORTRESPONSE_H_
+#define COMMON_TRANSPORTRESPONSE_H_
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "CookieJar.h"
+#include "RequestTimings.h"
+#include "Url.h"
+#include "WebResponse.h"
+
+namespace Microsoft {
+namespace Sharepoint {
+// A response put together by a transport which doesn't use curl
+class TransportResponse : public WebResponse
+{
+ public:
+	TransportResponse(long httpStatusCode, std::string &&body, const Url &url)
+	{
+		m_httpStatusCode = httpStatusCode;
+		m_responseBuffer = std::move(body);
+		m_effectiveUrl = url.str();
+	}
+
+ public:
+	void addHeader(const std::string &name, const std::string &value)
+	{
+		m_headers.push_back(std::pair<std::string, std::string>(name, value));
+	}
+	// only lists the cookie in cookies(), see storeCookies()
+	void addCookie(const std::string &name, const std::string &value)
+	{
+		m_cookies.push_back(std::pair<std::string, std::string>(name, value));
+	}
+	void setEffectiveUrl(const std::string &effectiveUrl)
+	{
+		m_effectiveUrl = effectiveUrl;
+	}
+	void setTimings(const RequestTimings &timings)
+	{
+		m_timings = timings;
+	}
+	// the response reads the body other responses hold as well
+	void setSharedBody(const std::shared_ptr<const std::string> &body)
+	{
+		m_responseBuffer.clear();
+		m_sharedResponse = body;
+	}
+	size_t bodyLength() const
+	{
+		return body().length();
+	}
+	std::string_view body() const
+	{
+		if (m_sharedResponse) {
+			return *m_sharedResponse;
+		}
+		return m_responseBuffer;
+	}
+
+ public:
+	// stores the cookies of the response in the jar, for the host of the url
+	void storeCookies(const std::shared_ptr<CookieJar> &cookieJar, const Url &url) const
+	{
+		if (!cookieJar) {
+			return;
+		}
+		std::string_view host = url.host();
+		size_t portSeparator = host.rfind(':');
+		if (portSeparator != std::string_view::npos && host.find(']', portSeparator) == std::string_view::npos) {
+			host = host.substr(0, portSeparator);
+		}
+		for (auto &cookie : m_cookies) {
+			CookieJar::Cookie jarCookie;
+			jarCookie.name = cookie.first;
+			jarCookie.value = cookie.second;
+			jarCookie.domain = std::string(host);
+			jarCookie.secure = url.protocolPrefix() == "https://";
+			jarCookie.httpOnly = true;
+			cookieJar->add(std::move(jarCookie));
+		}
+	}
+};
+}  // namespace Sharepoint
+}  // namespace Microsoft
+
+#endif  // COMMON_TRANSPORTRESPONSE_H_
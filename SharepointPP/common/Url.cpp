@@ -22,84 +22,109 @@
 
 #include "Url.h"
 
-#include <regex>
+namespace {
+inline bool isSchemeStart(char c)
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+inline bool isSchemeChar(char c)
+{
+	return isSchemeStart(c) || (c >= '0' && c <= '9') || c == '+' || c == '-' || c == '.';
+}
+
+inline bool isResourceEnd(char c)
+{
+	return c == '?' || c == '#';
+}
+}  // namespace
 
+Url::Url(const std::string &url) :
+	m_buffer(url)
+{
+	parseUrl();
+}
 
-Url::Url(const std::string &url)
+Url::Url(std::string &&url) :
+	m_buffer(std::move(url))
 {
-	parseUrl(url);
+	parseUrl();
 }
 
-Url::Url(const std::string & host, const std::string & resource) :
-	m_host(host),
-	m_resource(resource)
+Url::Url(const char *url) :
+	m_buffer(url != nullptr ? url : "")
 {
-	parseUrl(host);
+	parseUrl();
+}
+
+Url::Url(const std::string & host, const std::string & resource)
+{
+	m_buffer.reserve(host.length() + resource.length());
+	m_buffer += host;
+	m_buffer += resource;
+	parseUrl();
 }
 
 Url::Url(
 	const std::string & protocolPrefix,
 	const std::string & host,
-	const std::string & resource) :
-	m_protocolPrefix(protocolPrefix),
-	m_host(host),
-	m_resource(resource)
-{
-}
-
-void Url::parseUrl(const std::string & url)
-{
-	try {
-		std::string regexPattern("([\\w-.\\:]+\\/\\/)?([\\w.-]+)(.*)");
-		std::regex regex(std::move(regexPattern), std::regex::flag_type::ECMAScript);
-		std::sregex_iterator itHost(url.begin(), url.end(), regex);
-		if (itHost != std::sregex_iterator()) {
-			{
-				std::string protocol(std::move(itHost->str(1)));
-				if (protocol.length() > 0) {
-					m_protocolPrefix = protocol;
-				}
-			}
-			{
-				std::string host(std::move(itHost->str(2)));
-				if (host.length() > 0) {
-					m_host = host;
-				}
-			}
-			std::string resource(std::move(itHost->str(3)));
-			if (resource.length() > 0) {
-				std::string regexPatternResource("([\\w\\/.&]*)([^\\w^\\/])(.*)");
-				std::regex regexResource(std::move(regexPatternResource), std::regex::flag_type::ECMAScript);
-				std::sregex_iterator itResource(resource.begin(), resource.end(), regexResource);
-				if (itResource != std::sregex_iterator()) {
-					m_resource = itResource->str(1);
-					if (itResource->str(2).length() == 1) {
-						m_resourceParametersSeparator = itResource->str(2)[0];
-					}
-					if (itResource->str(3).length() > 0) {
-						std::string parameters(std::move(itResource->str(3)));
-						if (parameters.length() > 0) {
-							std::string regexPatternParameters(
-								"(?:((?:[\\w^=\\+\\%\\\\\\.\\-]+)"
-								"([^\\w^\\&^\\+^\\\\^\\-^\\.])"
-								"(?:[\\w^=\\+\\%\\\\\\.\\-]+))+\\&?)");
-							std::regex regexParameters(std::move(regexPatternParameters), std::regex::flag_type::ECMAScript);
-							for (std::sregex_iterator itParameters(parameters.begin(), parameters.end(), regexParameters);
-								itParameters != std::sregex_iterator();
-								++itParameters) {
-								std::string parameterString(std::move(itParameters->str(1)));
-								if (parameterString.length() > 0) {
-									m_parameters.push_back(parameterString);
-								}
-							}
-						}
-					}
-				}
-			}
+	const std::string & resource)
+{
+	compose(protocolPrefix, host, resource, std::string_view());
+}
+
+// splits the url following RFC 3986 into
+// scheme "://" authority path-abempty [ "?" query ] [ "#" fragment ]
+// the protocol prefix is only recognized together with "//",
+// so "host:port/path" is read as authority and path
+void Url::parseUrl()
+{
+	const char *data = m_buffer.data();
+	const size_t length = m_buffer.length();
+	size_t pos = 0;
+	m_protocolEnd = 0;
+	if (length > 0 && isSchemeStart(data[0])) {
+		pos = 1;
+		while (pos < length && isSchemeChar(data[pos])) {
+			++pos;
+		}
+		if (pos + 3 <= length && data[pos] == ':' && data[pos + 1] == '/' && data[pos + 2] == '/') {
+			m_protocolEnd = pos + 3;
 		}
-	} catch (...) {}
+	}
+	pos = m_protocolEnd;
+	while (pos < length && data[pos] != '/' && !isResourceEnd(data[pos])) {
+		++pos;
+	}
+	m_hostEnd = pos;
+	while (pos < length && !isResourceEnd(data[pos])) {
+		++pos;
+	}
+	m_resourceEnd = pos;
 }
 
+void Url::compose(
+	std::string_view protocolPrefix,
+	std::string_view host,
+	std::string_view resource,
+	std::string_view separatorAndQuery)
+{
+	// the views may point into the current buffer
+	std::string buffer;
+	buffer.reserve(
+		protocolPrefix.length() + host.length() + resource.length() + separatorAndQuery.length());
+	buffer += protocolPrefix;
+	buffer += host;
+	buffer += resource;
+	buffer += separatorAndQuery;
+	m_protocolEnd = protocolPrefix.length();
+	m_hostEnd = m_protocolEnd + host.length();
+	m_resourceEnd = m_hostEnd;
+	while (m_resourceEnd < buffer.length() && !isResourceEnd(buffer[m_resourceEnd])) {
+		++m_resourceEnd;
+	}
+	m_buffer.swap(buffer);
+}
 
 Url::~Url()
 {
@@ -107,47 +132,77 @@ Url::~Url()
 
 void Url::setProtocolPrefix(const std::string & protocolPrefix)
 {
-	m_protocolPrefix = protocolPrefix;
+	compose(protocolPrefix, host(), resource(), std::string_view(m_buffer).substr(m_resourceEnd));
 }
 
 void Url::setHost(const std::string & host)
 {
-	m_host = host;
+	compose(protocolPrefix(), host, resource(), std::string_view(m_buffer).substr(m_resourceEnd));
 }
 
 void Url::setResource(const std::string & resource)
 {
-	m_resource = resource;
+	compose(protocolPrefix(), host(), resource, std::string_view(m_buffer).substr(m_resourceEnd));
 }
 
 void Url::setProtocolPrefix(std::string && protocolPrefix)
 {
-	m_protocolPrefix = std::move(protocolPrefix);
+	setProtocolPrefix(static_cast<const std::string &>(protocolPrefix));
 }
 
 void Url::setHost(std::string && host)
 {
-	m_host = std::move(host);
+	setHost(static_cast<const std::string &>(host));
 }
 
 void Url::setResource(std::string && resource)
 {
-	m_resource = std::move(resource);
+	setResource(static_cast<const std::string &>(resource));
 }
 
-Url::operator std::string() const
+std::string_view Url::protocolPrefix() const
+{
+	return std::string_view(m_buffer).substr(0, m_protocolEnd);
+}
+
+std::string_view Url::host() const
+{
+	return std::string_view(m_buffer).substr(m_protocolEnd, m_hostEnd - m_protocolEnd);
+}
+
+std::string_view Url::resource() const
+{
+	return std::string_view(m_buffer).substr(m_hostEnd, m_resourceEnd - m_hostEnd);
+}
+
+std::string_view Url::query() const
 {
-	std::ostringstream parameters;
-	std::copy(m_parameters.begin(), m_parameters.end(), std::ostream_iterator<std::string>(parameters, "&"));
-	std::string parametersString(parameters.str());
-	if(parametersString[parametersString.length() - 1] == '&') {
-		parametersString = parametersString.substr(0, parametersString.length() - 1);
+	if (m_resourceEnd < m_buffer.length()) {
+		return std::string_view(m_buffer).substr(m_resourceEnd + 1);
 	}
-	return m_protocolPrefix + m_host + m_resource + parametersString;
+	return std::string_view();
+}
+
+const std::string &Url::str() const
+{
+	return m_buffer;
+}
+
+Url::operator std::string() const
+{
+	return m_buffer;
 }
 
 Url & Url::operator=(const std::string & other)
 {
-	parseUrl(other);
+	m_buffer = other;
+	parseUrl();
 	return *this;
-}
\ No newline at end of file
+}
+
+Url & Url::operator=(std::string && other)
+{
+	m_buffer = std::move(other);
+	parseUrl();
+	return *this;
+}
@@ -1,25 +1,30 @@
 #pragma once
 #include <string>
-#include <vector>
-#include <sstream>
-#include <iterator>
+#include <string_view>
 
+// Url keeps the complete url text in one buffer and only remembers
+// where the protocol prefix, the host and the resource end.
+// Parsing is a single pass over the buffer without any further allocation.
 class Url
 {
 public:
 	__declspec(dllexport)
 		Url(const std::string &url);
+	__declspec(dllexport)
+		Url(std::string &&url);
+	__declspec(dllexport)
+		Url(const char *url);
 	__declspec(dllexport)
 		Url(const std::string &host, const std::string &resource);
 	__declspec(dllexport)
 		Url(const std::string &protocolPrefix, const std::string &host, const std::string &resource);
 	template<class ...Args>
 	Url(const std::string & host, const std::string & resource, const std::string &parameter, const Args &...parameters) :
-		m_host(host),
-		m_resource(resource)
+		Url(host, resource)
 	{
-		parseUrl(host);
-		parseParameters(parameters...);
+		m_buffer.reserve(m_buffer.length() + parameter.length() + (0 + ... + std::string_view(parameters).length()) + 1 + sizeof...(parameters));
+		appendParameter(parameter);
+		(appendParameter(parameters), ...);
 	}
 	__declspec(dllexport)
 		~Url();
@@ -38,25 +43,47 @@ public:
 	__declspec(dllexport)
 		void setResource(std::string &&resource);
 
+public:
+	// the views point into the url and are valid until it is modified
+	__declspec(dllexport)
+		std::string_view protocolPrefix() const;
+	__declspec(dllexport)
+		std::string_view host() const;
+	__declspec(dllexport)
+		std::string_view resource() const;
+	// everything after the resource parameters separator
+	__declspec(dllexport)
+		std::string_view query() const;
+	__declspec(dllexport)
+		const std::string &str() const;
+
 public:
 	__declspec(dllexport)
 		operator std::string() const;
 	__declspec(dllexport)
 		Url &operator=(const std::string &other);
+	__declspec(dllexport)
+		Url &operator=(std::string &&other);
 
 private:
-	void parseUrl(const std::string &url);
-	template<class ...Args>
-	void parseParameters(const std::string &parameter, const Args &...parameters)
+	void parseUrl();
+	void compose(
+		std::string_view protocolPrefix,
+		std::string_view host,
+		std::string_view resource,
+		std::string_view separatorAndQuery);
+	void appendParameter(std::string_view parameter)
 	{
-		m_parameters.push_back(parameter);
-		parseParameters(parameters...);
+		if (parameter.length() > 0) {
+			m_buffer += (m_resourceEnd < m_buffer.length()) ? '&' : '?';
+			m_buffer += parameter;
+		}
 	}
 
 private:
-	std::string m_protocolPrefix;
-	std::string m_host;
-	std::string m_resource;
-	char m_resourceParametersSeparator {'?'};
-	std::vector<std::string> m_parameters;
-};
\ No newline at end of file
+	std::string m_buffer;
+	size_t m_protocolEnd {0};
+	size_t m_hostEnd {0};
+	// position of the resource parameters separator or the end of the url
+	size_t m_resourceEnd {0};
+};
@@ -1,8 +1,7 @@
 // Copyright (c) 2011 rubicon IT GmbH
 #include "WebRequest.h"
 
-#include <curl/curl.h>
-
+#include <cstring>
 #include <sstream>
 #include <algorithm>
 #include <utility>
@@ -10,408 +9,158 @@
 #include <vector>
 
 #include "ConversionUtils.h"
-
+#include "CookieJar.h"
+#include "PercentEncoding.h"
+#include "ResponseCache.h"
+#include "SingleFlight.h"
+#include "Transport.h"
+
+using Microsoft::Sharepoint::CookieJar;
+using Microsoft::Sharepoint::PercentEncoding;
+using Microsoft::Sharepoint::RequestScheduler;
+using Microsoft::Sharepoint::ResponseCache;
+using Microsoft::Sharepoint::SingleFlight;
+using Microsoft::Sharepoint::Transport;
 using Microsoft::Sharepoint::WebRequest;
 using Microsoft::Sharepoint::WebResponse;
 
-class GlobalCurlInit
+WebResponse WebRequest::post(
+	const Url &url,
+	const std::string &data)
 {
- public:
-	GlobalCurlInit()
-	{
-		curl_global_init(CURL_GLOBAL_ALL);
+	if (m_scheduler) {
+		return m_scheduler->send(*this, m_priority, true, url, data);
 	}
-	~GlobalCurlInit()
-	{
-		curl_global_cleanup();
-	}
-};
-
-static GlobalCurlInit globalCurlInstance;
-
-std::string timeStampToHReadble(
-	const time_t rawtime,
-	const std::string &formatString)
-{
-	struct tm * dt;
-	char buffer [30];
-	dt = localtime(&rawtime);
-	strftime(buffer, sizeof(buffer), formatString.data(), dt);
-	return std::string(buffer);
+	return transport()->send(*this, Transport::Method::Post, url, std::string(data));
 }
 
-std::string reformatCookie(
-	const std::string &host,
-	const std::string &value,
-	const std::string &path,
-	bool httpOnly,
-	bool secure,
-	size_t expireDate)
+WebResponse WebRequest::get(
+	const Url &url)
 {
-	std::string output;
-	output += value;
-	output += "; ";
-	if (host.length() > 0) {
-		output += "domain=";
-		output += host;
-		output += "; ";
-	}
-	if (path.length() > 0) {
-		output += "path=";
-		output += path;
-		output += "; ";
+	if (m_singleFlight) {
+		return m_singleFlight->get(*this, url);
 	}
-	if (secure) {
-		output += "secure; ";
+	// after the single flight, a get which joins another one takes no slot
+	if (m_scheduler) {
+		return m_scheduler->send(*this, m_priority, false, url, std::string());
 	}
-	if (httpOnly) {
-		output += "HttpOnly; ";
+	if (m_responseCache) {
+		return m_responseCache->get(*this, url);
 	}
-	if (expireDate > 0) {
-		output += "Expires=";
-		output += timeStampToHReadble(expireDate, "%a, %d %b %Y %I:%M:%S GMT");
-		output += "; ";
-	}
-	return output;
+	return transport()->send(*this, Transport::Method::Get, url, std::string());
 }
 
-bool addOrReplaceHeader(
-	struct curl_slist *headerStruct,
-	const std::string &headerName,
-	const std::string &headerValue)
+void WebRequest::setContentType(const std::string & contentType)
 {
-	if (headerStruct != nullptr) {
-		std::string headerData(headerStruct->data);
-		if (headerData.length() > headerName.length() &&
-			headerData.substr(0, headerName.length()) == headerName) {
-			free(headerStruct->data);
-			headerStruct->data = new char[
-				headerName.length() + 1 + headerValue.length() + 1];
-			std::string tempBuffer(headerName + ": " + headerValue);
-			strncpy(headerStruct->data, tempBuffer.data(), tempBuffer.length());
-			headerStruct->data[tempBuffer.length()] = '\0';
-			return true;
-		}
-		if (headerStruct->next != nullptr) {
-			return addOrReplaceHeader(headerStruct->next, headerName, headerValue);
+	if (contentType.length() > 0) {
+		std::string contentTypeCopy = contentType;
+		std::string contentTypePrefix =
+			contentTypeCopy.substr(0, std::string("Content-Type:").length());
+		if (
+			contentTypePrefix == std::string("Content-Type:") &&
+			contentTypePrefix == std::string("content-Type:") &&
+			contentTypePrefix == std::string("Content-type:") &&
+			contentTypePrefix == std::string("content-type:")) {
+			contentTypeCopy =
+				contentTypeCopy.substr(std::string("Content-Type:").length()-1);
 		}
+		m_header.push_back(
+			std::pair<std::string, std::string>(
+				"Content-Type", contentTypeCopy));
 	}
-	return false;
 }
 
-void addCustomHeaderToHeaderStruct(
-	const WebRequest::HeaderContainerType &headers,
-	struct curl_slist *&headerStruct)
+WebRequest::CookieContainerType WebRequest::cookies() const
 {
-	for (auto &header : headers) {
-		if (!addOrReplaceHeader(headerStruct, header.first, header.second)) {
-			headerStruct = curl_slist_append(
-				headerStruct,
-				std::string(header.first + ": " + header.second).data());
-		}
-	}
+	return m_cookies;
 }
 
-class WebResponseImpl : public WebResponse
+WebRequest::HeaderContainerType WebRequest::headers() const
 {
- public:
-	virtual ~WebResponseImpl()
-	{
-	}
-
-	void setCURLFunctions()
-	{
-		curl_easy_setopt(
-			m_curlHandle,
-			CURLOPT_WRITEFUNCTION,
-			WebResponse::curlWriteFunction);
-		curl_easy_setopt(
-			m_curlHandle,
-			CURLOPT_HEADERFUNCTION,
-			WebResponse::curlHeaderFunction);
-	}
-
-	void readCookiesFromResponse()
-	{
-		CURLcode res;
-		struct curl_slist *cookies;
-
-		res = curl_easy_getinfo(m_curlHandle, CURLINFO_COOKIELIST, &cookies);
-		if(res != CURLE_OK) {
-			fprintf(stderr, "Curl curl_easy_getinfo failed: %s\n",
-				curl_easy_strerror(res));
-		}
-		readAllCookies(cookies);
-		curl_slist_free_all(cookies);
-	}
-
-	static std::string cookieToString(struct curl_slist *cookieStruct)
-	{
-		return std::string(cookieStruct->data, strlen(cookieStruct->data));
-	}
-
-	static std::vector<std::string> splitCookieString(std::string &&cookieString)
-	{
-		std::istringstream f(cookieString);
-		std::string s;
-		std::vector<std::string> cookieStrings;
-		while (getline(f, s, '\t')) {
-			cookieStrings.push_back(s);
-		}
-		return cookieStrings;
-	}
-
-	void readAllCookies(struct curl_slist *cookieStruct)
-	{
-		if (cookieStruct != nullptr) {
-			for (struct curl_slist *currentStruct = cookieStruct;
-				currentStruct->next != nullptr;
-				currentStruct = currentStruct->next) {
-				readSingleCookie(currentStruct);
-			}
-		}
-	}
-
-	void readSingleCookie(struct curl_slist *cookieStruct)
-	{
-		std::vector<std::string> cookieStrings(
-			std::move(splitCookieString(
-			std::move(cookieToString(cookieStruct)))));
-		if (cookieStrings.size() >= 6) {
-			bool httpOnly = false;
-			bool secure = false;
-			std::string host = "";
-			std::string path(cookieStrings[2]);
-			std::string name(cookieStrings[5]);
-			std::string value = "";
-			size_t expireDate(ConversionUtils::stringToSize_T(cookieStrings[4]));
-
-			std::string &hostPart = cookieStrings[0];
-			std::string httpOnlyStr("#HttpOnly_");
-			if (hostPart.length() >= httpOnlyStr.length() &&
-				hostPart.substr(0, httpOnlyStr.length()) == httpOnlyStr) {
-				httpOnly = true;
-				host = cookieStrings[0].substr(std::string("#HttpOnly_").length());
-			} else {
-				host = cookieStrings[0];
-			}
-
-			if (cookieStrings[3].length() > 0 && cookieStrings[3] == "TRUE") {
-				secure = true;
-			}
-
-			if (cookieStrings.size() >= 7) {
-				value = cookieStrings[6];
-			}
-
-			m_cookies.push_back(
-				std::pair<std::string, std::string>(
-					name, reformatCookie(
-						host, value, path, httpOnly, secure, expireDate)));
-		}
-	}
-
-	void setCURLHandle(CURL *handle)
-	{
-		m_curlHandle = handle;
-	}
-};
+	return m_header;
+}
 
-class FailedWebRequestResponse :
-	public WebResponse
+std::shared_ptr<CookieJar> WebRequest::cookieJar() const
 {
- public:
-	explicit FailedWebRequestResponse(long httpStatusCode)
-	{
-		m_httpStatusCode = httpStatusCode;
-	}
-};
+	return m_cookieJar;
+}
 
-WebResponse WebRequest::post(
-	const Url &url,
-	const std::string &data)
+void WebRequest::setCookieJar(const std::shared_ptr<CookieJar> &cookieJar)
 {
-	WebResponseImpl response;
-
-	// init new curl handle
-	CURL *curlHandle = curl_easy_init();
-	response.setCURLHandle(curlHandle);
-	if (!curlHandle) {
-		return FailedWebRequestResponse(-1);
-	}
-
-	// set url for the request
-	curl_easy_setopt(
-		curlHandle,
-		CURLOPT_URL,
-		static_cast<std::string>(url).data());
-	// set post as method to use for curl
-	curl_easy_setopt(curlHandle, CURLOPT_CUSTOMREQUEST, "POST");
-	// start cookie engine
-	curl_easy_setopt(curlHandle, CURLOPT_COOKIEFILE, "");
-
-	struct curl_slist *headerStruct = nullptr;
-
-	if (data.length() == 0) {
-		m_header.push_back(
-			std::pair<std::string, std::string>("Content-Length", "0"));
-	}
-
-	addCustomHeaderToHeaderStruct(m_header, headerStruct);
-
-	// set the header structure to the curl handle
-	if (headerStruct != nullptr) {
-		curl_easy_setopt(curlHandle, CURLOPT_HTTPHEADER, headerStruct);
-	}
+	m_cookieJar = cookieJar;
+}
 
-	// set the post data
-	if (data.length() > 0) {
-		curl_easy_setopt(curlHandle, CURLOPT_POSTFIELDS, data.data());
+std::string WebRequest::cookieHeader(const Url &url) const
+{
+	std::string cookieString;
+	if (m_cookieJar) {
+		cookieString = m_cookieJar->cookieHeader(url);
 	}
-
-	// set the cookies for the request
-	if (m_cookies.size() > 0) {
-		std::string cookieString;
-		typedef WebRequest::CookieContainerType::const_iterator ItType;
-		for (ItType it = m_cookies.begin(); it != m_cookies.end(); ++it) {
-			cookieString += std::move(it->first + '=' + it->second);
+	for (auto &cookie : m_cookies) {
+		if (cookieString.length() > 0) {
+			cookieString += "; ";
 		}
-		curl_easy_setopt(curlHandle, CURLOPT_COOKIE, cookieString.data());
-	}
-
-#ifdef _DEBUG
-	curl_easy_setopt(curlHandle, CURLOPT_VERBOSE, 1L);
-#endif
-
-	response.setCURLFunctions();
-	WebResponse *this_ = static_cast<WebResponse *>(&response);
-	curl_easy_setopt(curlHandle, CURLOPT_WRITEDATA, this_);
-	curl_easy_setopt(curlHandle, CURLOPT_HEADERDATA, this_);
-
-	// perform the actual request
-	CURLcode success = curl_easy_perform(curlHandle);
-
-	// check if the request was successful
-	if(success != CURLE_OK) {
-		fprintf(
-			stderr,
-			"curl_easy_perform() failed: %s\n",
-			curl_easy_strerror(success));
-		return FailedWebRequestResponse(-2);
-	}
-
-	response.readCookiesFromResponse();
-
-	if (headerStruct != nullptr) {
-		curl_slist_free_all(headerStruct);
-		headerStruct = nullptr;
+		cookieString += cookie.first;
+		cookieString += '=';
+		cookieString += cookie.second;
 	}
-
-	curlHandle = nullptr;
-
-	return std::move(response);
+	return cookieString;
 }
 
-WebResponse WebRequest::get(
-	const Url &url)
+std::shared_ptr<Transport> WebRequest::transport() const
 {
-	WebResponseImpl response;
-
-	// init new curl handle
-	CURL *curlHandle = curl_easy_init();
-	response.setCURLHandle(curlHandle);
-	if (!curlHandle) {
-		return FailedWebRequestResponse(-1);
-	}
-
-	// set url for the request
-	curl_easy_setopt(
-		curlHandle,
-		CURLOPT_URL,
-		static_cast<std::string>(url).data());
-	// set post as method to use for curl
-	curl_easy_setopt(curlHandle, CURLOPT_CUSTOMREQUEST, "GET");
-	// start cookie engine
-	curl_easy_setopt(curlHandle, CURLOPT_COOKIEFILE, "");
-
-	struct curl_slist *headerStruct = nullptr;
-
-	addCustomHeaderToHeaderStruct(m_header, headerStruct);
-
-	// set the header structure to the curl handle
-	if (headerStruct != nullptr) {
-		curl_easy_setopt(curlHandle, CURLOPT_HTTPHEADER, headerStruct);
-	}
-
-	// set the cookies for the request
-	if (m_cookies.size() > 0) {
-		std::string cookieString;
-		typedef WebRequest::CookieContainerType::const_iterator ItType;
-		for (ItType it = m_cookies.begin(); it != m_cookies.end(); ++it) {
-			cookieString += std::move(it->first + '=' + it->second);
-		}
-		curl_easy_setopt(curlHandle, CURLOPT_COOKIE, cookieString.data());
-	}
+	return m_transport ? m_transport : Transport::defaultTransport();
+}
 
-#ifdef _DEBUG
-	curl_easy_setopt(curlHandle, CURLOPT_VERBOSE, 1L);
-#endif
+void WebRequest::setTransport(const std::shared_ptr<Transport> &transport)
+{
+	m_transport = transport;
+}
 
-	response.setCURLFunctions();
-	WebResponse *this_ = static_cast<WebResponse *>(&response);
-	curl_easy_setopt(curlHandle, CURLOPT_WRITEDATA, this_);
-	curl_easy_setopt(curlHandle, CURLOPT_HEADERDATA, this_);
+std::shared_ptr<ResponseCache> WebRequest::responseCache() const
+{
+	return m_responseCache;
+}
 
-	// perform the actual request
-	CURLcode responseCode = curl_easy_perform(curlHandle);
+void WebRequest::setResponseCache(const std::shared_ptr<ResponseCache> &responseCache)
+{
+	m_responseCache = responseCache;
+}
 
-	// check if the request was successful
-	if(responseCode != CURLE_OK) {
-		fprintf(
-			stderr,
-			"curl_easy_perform() failed: %s\n",
-			curl_easy_strerror(responseCode));
-		return FailedWebRequestResponse(-2);
-	}
+std::shared_ptr<SingleFlight> WebRequest::singleFlight() const
+{
+	return m_singleFlight;
+}
 
-	if (headerStruct != nullptr) {
-		curl_slist_free_all(headerStruct);
-		headerStruct = nullptr;
-	}
+void WebRequest::setSingleFlight(const std::shared_ptr<SingleFlight> &singleFlight)
+{
+	m_singleFlight = singleFlight;
+}
 
-	curlHandle = nullptr;
+const WebRequest::BodySinkType &WebRequest::bodySink() const
+{
+	return m_bodySink;
+}
 
-	return std::move(response);
+void WebRequest::setBodySink(const WebRequest::BodySinkType &bodySink)
+{
+	m_bodySink = bodySink;
 }
 
-void WebRequest::setContentType(const std::string & contentType)
+std::shared_ptr<RequestScheduler> WebRequest::scheduler() const
 {
-	if (contentType.length() > 0) {
-		std::string contentTypeCopy = contentType;
-		std::string contentTypePrefix =
-			contentTypeCopy.substr(0, std::string("Content-Type:").length());
-		if (
-			contentTypePrefix == std::string("Content-Type:") &&
-			contentTypePrefix == std::string("content-Type:") &&
-			contentTypePrefix == std::string("Content-type:") &&
-			contentTypePrefix == std::string("content-type:")) {
-			contentTypeCopy =
-				contentTypeCopy.substr(std::string("Content-Type:").length()-1);
-		}
-		m_header.push_back(
-			std::pair<std::string, std::string>(
-				"Content-Type", contentTypeCopy));
-	}
+	return m_scheduler;
 }
 
-WebRequest::CookieContainerType WebRequest::cookies() const
+RequestScheduler::Priority WebRequest::priority() const
 {
-	return m_cookies;
+	return m_priority;
 }
 
-WebRequest::HeaderContainerType WebRequest::headers() const
+void WebRequest::setScheduler(const std::shared_ptr<RequestScheduler> &scheduler, RequestScheduler::Priority priority)
 {
-	return m_header;
+	m_scheduler = scheduler;
+	m_priority = priority;
 }
 
 void WebRequest::addCookie(const std::string & name, const std::string & value)
@@ -436,12 +185,5 @@ void WebRequest::addHeader(const std::string & name, const std::string & value)
 
 std::string WebRequest::getUnescapedString(const std::string & escapedString)
 {
-	std::string tempBuffer;
-	char *curlUnescapedString = curl_unescape(
-		escapedString.data(),
-		static_cast<int>(escapedString.length()));
-	tempBuffer.resize(strlen(curlUnescapedString));
-	strncpy(&tempBuffer[0], curlUnescapedString, tempBuffer.length());
-	curl_free(curlUnescapedString);
-	return tempBuffer;
+	return PercentEncoding::decode(escapedString);
 }
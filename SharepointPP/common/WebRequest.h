@@ -2,15 +2,23 @@
 #ifndef COMMON_WEBREQUEST_H_
 #define COMMON_WEBREQUEST_H_
 
+#include <functional>
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
 
+#include "CookieJar.h"
+#include "RequestScheduler.h"
 #include "WebResponse.h"
 #include "Url.h"
 
 namespace Microsoft {
 namespace Sharepoint {
+class ResponseCache;
+class SingleFlight;
+class Transport;
+
 class WebRequest
 {
 public:
@@ -18,6 +26,8 @@ public:
 	__declspec(dllexport) ~WebRequest() {}
 	typedef std::vector<std::pair<std::string, std::string>> CookieContainerType;
 	typedef std::vector<std::pair<std::string, std::string>> HeaderContainerType;
+	// gets a piece of the body, false aborts the transfer
+	typedef std::function<bool(const char *data, size_t length)> BodySinkType;
 
 public:
 	__declspec(dllexport)
@@ -41,12 +51,57 @@ public:
 	void setHeaders(const WebRequest::HeaderContainerType &headers);
 	__declspec(dllexport)
 	void addHeader(const std::string &name, const std::string &value);
+	// requests sharing a cookie jar send the cookies received by each other
+	__declspec(dllexport)
+	void setCookieJar(const std::shared_ptr<CookieJar> &cookieJar);
+	// sends this request through the transport instead of the default one
+	__declspec(dllexport)
+	void setTransport(const std::shared_ptr<Transport> &transport);
+	// gets revalidate the responses stored in the cache, nullptr turns it off
+	__declspec(dllexport)
+	void setResponseCache(const std::shared_ptr<ResponseCache> &responseCache);
+	// identical gets of many threads at the same time are sent only once,
+	// nullptr turns it off
+	__declspec(dllexport)
+	void setSingleFlight(const std::shared_ptr<SingleFlight> &singleFlight);
+	// the body of a 2xx answer is handed to the sink piece by piece as it
+	// arrives instead of being kept in the response, e.g. to write a large
+	// file to disk. Only the CurlTransport streams, other transports
+	// still put the body into the response. Not for requests going through
+	// a single flight or a response cache, they need the body.
+	__declspec(dllexport)
+	void setBodySink(const WebRequest::BodySinkType &bodySink);
+	// requests wait for a slot of the scheduler in the class of the
+	// priority before they are sent, nullptr turns it off
+	__declspec(dllexport)
+	void setScheduler(
+		const std::shared_ptr<RequestScheduler> &scheduler,
+		RequestScheduler::Priority priority = RequestScheduler::Priority::Normal);
 
 public:
 	__declspec(dllexport)
 	WebRequest::CookieContainerType cookies() const;
 	__declspec(dllexport)
 	WebRequest::HeaderContainerType headers() const;
+	__declspec(dllexport)
+	std::shared_ptr<CookieJar> cookieJar() const;
+	// the value of the Cookie header sent to the url: the matching cookies
+	// of the cookie jar followed by the cookies set on this request
+	__declspec(dllexport)
+	std::string cookieHeader(const Url &url) const;
+	// the transport set on this request or the default transport
+	__declspec(dllexport)
+	std::shared_ptr<Transport> transport() const;
+	__declspec(dllexport)
+	std::shared_ptr<ResponseCache> responseCache() const;
+	__declspec(dllexport)
+	std::shared_ptr<SingleFlight> singleFlight() const;
+	__declspec(dllexport)
+	const WebRequest::BodySinkType &bodySink() const;
+	__declspec(dllexport)
+	std::shared_ptr<RequestScheduler> scheduler() const;
+	__declspec(dllexport)
+	RequestScheduler::Priority priority() const;
 
 public:
 	__declspec(dllexport)
@@ -55,6 +110,13 @@ public:
 private:
 	WebRequest::CookieContainerType m_cookies;
 	WebRequest::HeaderContainerType m_header;
+	std::shared_ptr<CookieJar> m_cookieJar;
+	std::shared_ptr<Transport> m_transport;
+	std::shared_ptr<ResponseCache> m_responseCache;
+	std::shared_ptr<SingleFlight> m_singleFlight;
+	BodySinkType m_bodySink;
+	std::shared_ptr<RequestScheduler> m_scheduler;
+	RequestScheduler::Priority m_priority {RequestScheduler::Priority::Normal};
 };
 
 }  // namespace Sharepoint
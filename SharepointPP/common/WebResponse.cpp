@@ -21,7 +21,6 @@
 // SOFTWARE.
 
 #include "WebResponse.h"
-#include <curl/curl.h>
 
 #include <utility>
 #include <string>
@@ -30,19 +29,18 @@ using Microsoft::Sharepoint::WebResponse;
 
 WebResponse::WebResponse() :
 	m_responseBuffer(),
+	m_sharedResponse(),
 	m_cookies(),
 	m_headers(),
 	m_httpStatusCode(0),
-	m_curlHandle(nullptr)
+	m_timings(),
+	m_effectiveUrl()
 {
 }
 
 
 WebResponse::~WebResponse()
 {
-	if (m_curlHandle != nullptr) {
-		curl_easy_cleanup(m_curlHandle);
-	}
 }
 
 WebResponse::WebResponse(WebResponse && other) noexcept :
@@ -67,8 +65,11 @@ void WebResponse::swap(WebResponse & first, WebResponse & second) noexcept
 	using std::swap;
 	swap(first.m_cookies, second.m_cookies);
 	swap(first.m_responseBuffer, second.m_responseBuffer);
+	swap(first.m_sharedResponse, second.m_sharedResponse);
 	swap(first.m_headers, second.m_headers);
-	swap(first.m_curlHandle, second.m_curlHandle);
+	swap(first.m_httpStatusCode, second.m_httpStatusCode);
+	swap(first.m_timings, second.m_timings);
+	swap(first.m_effectiveUrl, second.m_effectiveUrl);
 }
 
 WebResponse::CookieContainerType WebResponse::cookies() const
@@ -83,21 +84,46 @@ WebResponse::HeaderContainerType WebResponse::header() const
 
 std::string WebResponse::response() const
 {
+	if (m_sharedResponse) {
+		return *m_sharedResponse;
+	}
 	return m_responseBuffer;
 }
 
-long WebResponse::httpStatusCode() const
+std::string WebResponse::takeResponse()
 {
-	if (m_httpStatusCode >= 0) {
-		CURLcode responseCode = curl_easy_getinfo(
-			m_curlHandle,
-			CURLINFO_RESPONSE_CODE,
-			&m_httpStatusCode);
-		if (responseCode == CURLE_OK) {
-			return m_httpStatusCode;
-		}
+	if (m_sharedResponse) {
+		// other responses may still read it
+		std::string body(*m_sharedResponse);
+		m_sharedResponse.reset();
+		return body;
 	}
-	return 0;
+	return std::move(m_responseBuffer);
+}
+
+std::shared_ptr<const std::string> WebResponse::sharedResponse()
+{
+	if (!m_sharedResponse) {
+		m_sharedResponse = std::make_shared<const std::string>(std::move(m_responseBuffer));
+		m_responseBuffer.clear();
+	}
+	return m_sharedResponse;
+}
+
+long WebResponse::httpStatusCode() const
+{
+	// taken when the transfer completed, negative if it failed
+	return m_httpStatusCode;
+}
+
+std::string WebResponse::effectiveUrl() const
+{
+	return m_effectiveUrl;
+}
+
+Microsoft::Sharepoint::RequestTimings WebResponse::timings() const
+{
+	return m_timings;
 }
 
 void WebResponse::setHttpStatusCode(long httpStatusCode)
@@ -24,10 +24,13 @@
 #ifndef WEBRESPONSE_H_
 #define WEBRESPONSE_H_
 
+#include <memory>
 #include <string>
 #include <vector>
 #include <utility>
 
+#include "RequestTimings.h"
+
 namespace Microsoft {
 namespace Sharepoint {
 class WebResponse
@@ -58,8 +61,22 @@ class WebResponse
 		WebResponse::HeaderContainerType header() const;
 	__declspec(dllexport)
 		std::string response() const;
+	// moves the body out of the response, response() is empty afterwards,
+	// a shared body is copied
+	__declspec(dllexport)
+		std::string takeResponse();
+	// the body as an immutable string which other responses may share,
+	// the body of this response moves into it on the first call
+	__declspec(dllexport)
+		std::shared_ptr<const std::string> sharedResponse();
 	__declspec(dllexport)
 		long httpStatusCode() const;
+	// the url of the last request, after redirects
+	__declspec(dllexport)
+		std::string effectiveUrl() const;
+	// the timing breakdown of the request, all 0 if it never started
+	__declspec(dllexport)
+		RequestTimings timings() const;
 
  public:
 	__declspec(dllexport)
@@ -79,10 +96,13 @@ class WebResponse
 
  protected:
 	std::string m_responseBuffer;
+	// holds the body instead of the buffer once it is shared
+	std::shared_ptr<const std::string> m_sharedResponse;
 	HeaderContainerType m_headers;
 	CookieContainerType m_cookies;
 	long m_httpStatusCode;
-	void *m_curlHandle;
+	RequestTimings m_timings;
+	std::string m_effectiveUrl;
 };
 }  // namespace Sharepoint
 }  // namespace Microsoft
@@ -0,0 +1,380 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "WebTransfer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <string>
+
+#include "CurlHandlePool.h"
+
+using Microsoft::Sharepoint::CookieJar;
+using Microsoft::Sharepoint::CurlHandlePool;
+using Microsoft::Sharepoint::FailedWebRequestResponse;
+using Microsoft::Sharepoint::RequestMetrics;
+using Microsoft::Sharepoint::WebRequest;
+using Microsoft::Sharepoint::WebResponse;
+using Microsoft::Sharepoint::WebResponseImpl;
+using Microsoft::Sharepoint::WebTransfer;
+
+class GlobalCurlInit
+{
+ public:
+	GlobalCurlInit()
+	{
+		curl_global_init(CURL_GLOBAL_ALL);
+	}
+	~GlobalCurlInit()
+	{
+		curl_global_cleanup();
+	}
+};
+
+static GlobalCurlInit globalCurlInstance;
+
+// curl sends smaller post bodies in one piece with the request header
+// (MAX_INITIAL_POST_SIZE), larger ones after it
+static const curl_off_t maxInitialPostSize = 64 * 1024;
+
+bool addOrReplaceHeader(
+	struct curl_slist *headerStruct,
+	const std::string &headerName,
+	const std::string &headerValue)
+{
+	if (headerStruct != nullptr) {
+		std::string headerData(headerStruct->data);
+		if (headerData.length() > headerName.length() &&
+			headerData.substr(0, headerName.length()) == headerName) {
+			// curl frees the list entries with free()
+			std::string tempBuffer(headerName + ": " + headerValue);
+			char *data = static_cast<char *>(malloc(tempBuffer.length() + 1));
+			if (data == nullptr) {
+				return false;
+			}
+			memcpy(data, tempBuffer.data(), tempBuffer.length() + 1);
+			free(headerStruct->data);
+			headerStruct->data = data;
+			return true;
+		}
+		if (headerStruct->next != nullptr) {
+			return addOrReplaceHeader(headerStruct->next, headerName, headerValue);
+		}
+	}
+	return false;
+}
+
+void Microsoft::Sharepoint::addCustomHeaderToHeaderStruct(
+	const WebRequest::HeaderContainerType &headers,
+	struct curl_slist *&headerStruct)
+{
+	for (auto &header : headers) {
+		if (!addOrReplaceHeader(headerStruct, header.first, header.second)) {
+			headerStruct = curl_slist_append(
+				headerStruct,
+				std::string(header.first + ": " + header.second).data());
+		}
+	}
+}
+
+void WebResponseImpl::setCURLFunctions()
+{
+	curl_easy_setopt(
+		m_curlHandle,
+		CURLOPT_WRITEFUNCTION,
+		WebResponse::curlWriteFunction);
+	curl_easy_setopt(
+		m_curlHandle,
+		CURLOPT_HEADERFUNCTION,
+		WebResponse::curlHeaderFunction);
+}
+
+void WebResponseImpl::setBodySink(const WebRequest::BodySinkType &bodySink)
+{
+	m_bodySink = bodySink;
+	curl_easy_setopt(
+		m_curlHandle,
+		CURLOPT_WRITEFUNCTION,
+		WebResponseImpl::curlStreamFunction);
+}
+
+size_t WebResponseImpl::curlStreamFunction(
+	void *buffer,
+	size_t size,
+	size_t nmemb,
+	void *userp)
+{
+	WebResponseImpl *this_ = static_cast<WebResponseImpl *>(static_cast<WebResponse *>(userp));
+	const char *data = static_cast<const char *>(buffer);
+	size_t length = size * nmemb;
+	if (!this_->m_streamDecided) {
+		// the headers are complete before the body starts, an error
+		// answer stays in the response to be read
+		long httpStatusCode = 0;
+		curl_easy_getinfo(this_->m_curlHandle, CURLINFO_RESPONSE_CODE, &httpStatusCode);
+		this_->m_streaming = httpStatusCode >= 200 && httpStatusCode < 300;
+		this_->m_streamDecided = true;
+	}
+	if (!this_->m_streaming) {
+		this_->m_responseBuffer.append(data, length);
+		return length;
+	}
+	// a short count makes curl abort the transfer
+	return this_->m_bodySink(data, length) ? length : 0;
+}
+
+void WebResponseImpl::readCookiesFromResponse(CookieJar *cookieJar)
+{
+	CURLcode res;
+	struct curl_slist *cookies = nullptr;
+
+	res = curl_easy_getinfo(m_curlHandle, CURLINFO_COOKIELIST, &cookies);
+	if(res != CURLE_OK) {
+		fprintf(stderr, "Curl curl_easy_getinfo failed: %s\n",
+			curl_easy_strerror(res));
+	}
+	readAllCookies(cookies, cookieJar);
+	curl_slist_free_all(cookies);
+}
+
+void WebResponseImpl::readAllCookies(struct curl_slist *cookieStruct, CookieJar *cookieJar)
+{
+	for (struct curl_slist *currentStruct = cookieStruct;
+		currentStruct != nullptr;
+		currentStruct = currentStruct->next) {
+		readSingleCookie(currentStruct, cookieJar);
+	}
+}
+
+void WebResponseImpl::readSingleCookie(struct curl_slist *cookieStruct, CookieJar *cookieJar)
+{
+	CookieJar::Cookie cookie;
+	if (CookieJar::parseNetscapeCookie(cookieStruct->data, cookie)) {
+		m_cookies.push_back(
+			std::pair<std::string, std::string>(cookie.name, cookie.value));
+		if (cookieJar != nullptr) {
+			cookieJar->add(std::move(cookie));
+		}
+	}
+}
+
+void WebResponseImpl::setCURLHandle(CURL *handle)
+{
+	m_curlHandle = handle;
+}
+
+void WebResponseImpl::readStatus()
+{
+	curl_easy_getinfo(m_curlHandle, CURLINFO_RESPONSE_CODE, &m_httpStatusCode);
+	const char *effectiveUrl = nullptr;
+	curl_easy_getinfo(m_curlHandle, CURLINFO_EFFECTIVE_URL, &effectiveUrl);
+	if (effectiveUrl != nullptr) {
+		m_effectiveUrl = effectiveUrl;
+	}
+}
+
+void WebResponseImpl::readTimings()
+{
+	// curl reports the points in time in microseconds
+	auto readTime = [this](CURLINFO info) {
+		curl_off_t value = 0;
+		curl_easy_getinfo(m_curlHandle, info, &value);
+		return std::chrono::microseconds(value);
+	};
+	m_timings.nameLookup = readTime(CURLINFO_NAMELOOKUP_TIME_T);
+	m_timings.connect = readTime(CURLINFO_CONNECT_TIME_T);
+	m_timings.appConnect = readTime(CURLINFO_APPCONNECT_TIME_T);
+	m_timings.preTransfer = readTime(CURLINFO_PRETRANSFER_TIME_T);
+	m_timings.startTransfer = readTime(CURLINFO_STARTTRANSFER_TIME_T);
+	m_timings.total = readTime(CURLINFO_TOTAL_TIME_T);
+
+	long requestSize = 0;
+	long headerSize = 0;
+	curl_off_t uploadSize = 0;
+	curl_off_t downloadSize = 0;
+	long newConnections = 0;
+	curl_easy_getinfo(m_curlHandle, CURLINFO_REQUEST_SIZE, &requestSize);
+	curl_easy_getinfo(m_curlHandle, CURLINFO_HEADER_SIZE, &headerSize);
+	curl_easy_getinfo(m_curlHandle, CURLINFO_SIZE_UPLOAD_T, &uploadSize);
+	curl_easy_getinfo(m_curlHandle, CURLINFO_SIZE_DOWNLOAD_T, &downloadSize);
+	curl_easy_getinfo(m_curlHandle, CURLINFO_NUM_CONNECTS, &newConnections);
+	// the request size holds the body only when it went with the header
+	curl_off_t bodySentWithHeader = 0;
+	if (uploadSize < maxInitialPostSize && requestSize > uploadSize) {
+		bodySentWithHeader = uploadSize;
+	}
+	m_timings.bytesUp = requestSize + uploadSize - bodySentWithHeader;
+	m_timings.bytesDown = headerSize + downloadSize;
+	// a request which was never sent didn't reuse anything either
+	m_timings.connectionReused = (newConnections == 0 && requestSize > 0);
+}
+
+Microsoft::Sharepoint::RequestTimings WebResponseImpl::timings() const
+{
+	return m_timings;
+}
+
+WebTransfer::WebTransfer(const WebRequest &request, Method method, const Url &url, std::string &&data) :
+	m_response(),
+	m_curlHandle(CurlHandlePool::acquire(request.cookieJar() != nullptr)),
+	m_headerStruct(nullptr),
+	m_data(std::move(data)),
+	m_cookieJar(request.cookieJar()),
+	m_endpoint(RequestMetrics::classify(url.resource(), method == Method::Post))
+{
+	m_response.setCURLHandle(m_curlHandle);
+	if (!m_curlHandle) {
+		return;
+	}
+
+	// set url for the request
+	curl_easy_setopt(
+		m_curlHandle,
+		CURLOPT_URL,
+		url.str().data());
+	// transfers may run on other threads than the one which created them
+	curl_easy_setopt(m_curlHandle, CURLOPT_NOSIGNAL, 1L);
+	// start cookie engine
+	curl_easy_setopt(m_curlHandle, CURLOPT_COOKIEFILE, "");
+
+	WebRequest::HeaderContainerType headers = request.headers();
+	if (method == Method::Post) {
+		// set post as method to use for curl
+		curl_easy_setopt(m_curlHandle, CURLOPT_CUSTOMREQUEST, "POST");
+		if (m_data.length() == 0) {
+			headers.push_back(
+				std::pair<std::string, std::string>("Content-Length", "0"));
+		} else if (static_cast<curl_off_t>(m_data.length()) < maxInitialPostSize) {
+			// without "Expect: 100-continue" curl sends the body with the
+			// header instead of waiting a round trip for the server
+			headers.push_back(
+				std::pair<std::string, std::string>("Expect", ""));
+		}
+	} else {
+		curl_easy_setopt(m_curlHandle, CURLOPT_CUSTOMREQUEST, "GET");
+	}
+
+	addCustomHeaderToHeaderStruct(headers, m_headerStruct);
+
+	// set the header structure to the curl handle
+	if (m_headerStruct != nullptr) {
+		curl_easy_setopt(m_curlHandle, CURLOPT_HTTPHEADER, m_headerStruct);
+	}
+
+	// set the post data, curl only keeps a pointer to it
+	if (m_data.length() > 0) {
+		curl_easy_setopt(m_curlHandle, CURLOPT_POSTFIELDS, m_data.data());
+		curl_easy_setopt(m_curlHandle, CURLOPT_POSTFIELDSIZE_LARGE,
+			static_cast<curl_off_t>(m_data.length()));
+	}
+
+	// set the cookies for the request
+	setCookieOptions(request, url);
+
+#ifdef _DEBUG
+	curl_easy_setopt(m_curlHandle, CURLOPT_VERBOSE, 1L);
+#endif
+
+	m_response.setCURLFunctions();
+	if (request.bodySink()) {
+		m_response.setBodySink(request.bodySink());
+	}
+	WebResponse *this_ = static_cast<WebResponse *>(&m_response);
+	curl_easy_setopt(m_curlHandle, CURLOPT_WRITEDATA, this_);
+	curl_easy_setopt(m_curlHandle, CURLOPT_HEADERDATA, this_);
+}
+
+WebTransfer::~WebTransfer()
+{
+	// the handle may still point to the header list until it is reset
+	CurlHandlePool::release(m_curlHandle, m_cookieJar != nullptr);
+	m_curlHandle = nullptr;
+	if (m_headerStruct != nullptr) {
+		curl_slist_free_all(m_headerStruct);
+		m_headerStruct = nullptr;
+	}
+}
+
+bool WebTransfer::isValid() const
+{
+	return m_curlHandle != nullptr;
+}
+
+CURL *WebTransfer::handle() const
+{
+	return m_curlHandle;
+}
+
+WebResponse WebTransfer::perform()
+{
+	if (!m_curlHandle) {
+		return FailedWebRequestResponse(-1);
+	}
+	// perform the actual request
+	return finish(curl_easy_perform(m_curlHandle));
+}
+
+WebResponse WebTransfer::finish(CURLcode result)
+{
+	if (!m_curlHandle) {
+		return FailedWebRequestResponse(-1);
+	}
+
+	m_response.readTimings();
+
+	// check if the request was successful
+	if(result != CURLE_OK) {
+		fprintf(
+			stderr,
+			"curl_easy_perform() failed: %s\n",
+			curl_easy_strerror(result));
+		RequestMetrics::record(m_endpoint, -2, m_response.timings());
+		// the timings tell how far a failed request came
+		return FailedWebRequestResponse(-2, m_response.timings());
+	}
+
+	m_response.readStatus();
+	RequestMetrics::record(m_endpoint, m_response.httpStatusCode(), m_response.timings());
+	m_response.readCookiesFromResponse(m_cookieJar.get());
+	// the response doesn't keep the handle, it goes back to the pool with the transfer
+	m_response.setCURLHandle(nullptr);
+
+	return std::move(m_response);
+}
+
+void WebTransfer::setCookieOptions(const WebRequest &request, const Url &url)
+{
+	if (m_cookieJar) {
+		// share dns cache, tls sessions and connections with the other
+		// requests of this cookie jar
+		curl_easy_setopt(m_curlHandle, CURLOPT_SHARE, m_cookieJar->shareHandle());
+	}
+	// only the matching cookies of the jar are sent
+	std::string cookieString = request.cookieHeader(url);
+	if (cookieString.length() > 0) {
+		// curl copies the string
+		curl_easy_setopt(m_curlHandle, CURLOPT_COOKIE, cookieString.data());
+	}
+}
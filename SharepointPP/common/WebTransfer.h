@@ -0,0 +1,146 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef COMMON_WEBTRANSFER_H_
+#define COMMON_WEBTRANSFER_H_
+
+#include <curl/curl.h>
+
+#include <memory>
+#include <string>
+
+#include "CookieJar.h"
+#include "RequestMetrics.h"
+#include "RequestTimings.h"
+#include "Transport.h"
+#include "Url.h"
+#include "WebRequest.h"
+#include "WebResponse.h"
+
+namespace Microsoft {
+namespace Sharepoint {
+// the response filled by the curl callbacks of a transfer
+class WebResponseImpl : public WebResponse
+{
+	// measures the header and cookie parsing on its own
+	friend class Benchmark;
+
+ public:
+	virtual ~WebResponseImpl()
+	{
+	}
+
+	void setCURLFunctions();
+	// hands the body of a 2xx answer to the sink instead of keeping it
+	void setBodySink(const WebRequest::BodySinkType &bodySink);
+	// parses every cookie the server has set exactly once,
+	// stores it in the cookie jar of the request and the response
+	void readCookiesFromResponse(CookieJar *cookieJar);
+	void setCURLHandle(CURL *handle);
+	// reads the status code and the effective url, before the handle is released
+	void readStatus();
+	// reads the timing breakdown, before the handle is released
+	void readTimings();
+	RequestTimings timings() const;
+
+ private:
+	void readAllCookies(struct curl_slist *cookieStruct, CookieJar *cookieJar);
+	void readSingleCookie(struct curl_slist *cookieStruct, CookieJar *cookieJar);
+	static size_t curlStreamFunction(
+		void *buffer,
+		size_t size,
+		size_t nmemb,
+		void *userp);
+
+ private:
+	// only used while the transfer runs, the response doesn't own it
+	CURL *m_curlHandle {nullptr};
+	WebRequest::BodySinkType m_bodySink;
+	// decided by the status code when the first piece of the body arrives
+	bool m_streamDecided {false};
+	bool m_streaming {false};
+};
+
+// merges the headers into the curl header list, a header already in the
+// list is replaced
+void addCustomHeaderToHeaderStruct(
+	const WebRequest::HeaderContainerType &headers,
+	struct curl_slist *&headerStruct);
+
+class FailedWebRequestResponse :
+	public WebResponse
+{
+ public:
+	explicit FailedWebRequestResponse(long httpStatusCode)
+	{
+		m_httpStatusCode = httpStatusCode;
+	}
+	FailedWebRequestResponse(long httpStatusCode, const RequestTimings &timings)
+	{
+		m_httpStatusCode = httpStatusCode;
+		m_timings = timings;
+	}
+};
+
+// One request prepared on a curl handle from the CurlHandlePool.
+// WebRequest performs it blocking, the AsyncEngine adds the handle to
+// its multi handle and finishes the transfer when curl reports it done.
+// The transfer keeps everything curl only points to (post data, header
+// list, cookie jar) alive until then. Finishing copies everything the
+// response needs out of the handle, the handle goes back to the pool
+// with the transfer.
+class WebTransfer
+{
+ public:
+	typedef Transport::Method Method;
+
+ public:
+	WebTransfer(const WebRequest &request, Method method, const Url &url, std::string &&data);
+	~WebTransfer();
+	WebTransfer(const WebTransfer &other) = delete;
+	WebTransfer &operator=(const WebTransfer &other) = delete;
+
+ public:
+	// false if no curl handle could be created
+	bool isValid() const;
+	CURL *handle() const;
+	// performs the transfer on the calling thread
+	WebResponse perform();
+	// collects the response after curl has completed the transfer
+	WebResponse finish(CURLcode result);
+
+ private:
+	void setCookieOptions(const WebRequest &request, const Url &url);
+
+ private:
+	WebResponseImpl m_response;
+	CURL *m_curlHandle;
+	struct curl_slist *m_headerStruct;
+	std::string m_data;
+	std::shared_ptr<CookieJar> m_cookieJar;
+	RequestMetrics::Endpoint m_endpoint;
+};
+}  // namespace Sharepoint
+}  // namespace Microsoft
+
+#endif  // COMMON_WEBTRANSFER_H_
@@ -0,0 +1,81 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "XmlDocumentPool.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+using Microsoft::Sharepoint::XmlDocumentPool;
+
+namespace {
+const size_t MaxPooledObjects = 4;
+
+struct ThreadPool
+{
+	std::vector<std::unique_ptr<tinyxml2::XMLDocument>> documents;
+	std::vector<std::unique_ptr<tinyxml2::XMLPrinter>> printers;
+};
+
+thread_local ThreadPool threadPool;
+}  // namespace
+
+XmlDocumentPool::DocumentLease XmlDocumentPool::document()
+{
+	std::vector<std::unique_ptr<tinyxml2::XMLDocument>> &documents = threadPool.documents;
+	if (documents.empty()) {
+		return DocumentLease(std::make_unique<tinyxml2::XMLDocument>());
+	}
+	std::unique_ptr<tinyxml2::XMLDocument> document(std::move(documents.back()));
+	documents.pop_back();
+	return DocumentLease(std::move(document));
+}
+
+XmlDocumentPool::PrinterLease XmlDocumentPool::printer()
+{
+	std::vector<std::unique_ptr<tinyxml2::XMLPrinter>> &printers = threadPool.printers;
+	if (printers.empty()) {
+		return PrinterLease(std::make_unique<tinyxml2::XMLPrinter>());
+	}
+	std::unique_ptr<tinyxml2::XMLPrinter> printer(std::move(printers.back()));
+	printers.pop_back();
+	return PrinterLease(std::move(printer));
+}
+
+void XmlDocumentPool::release(std::unique_ptr<tinyxml2::XMLDocument> &&document)
+{
+	std::vector<std::unique_ptr<tinyxml2::XMLDocument>> &documents = threadPool.documents;
+	if (documents.size() < MaxPooledObjects) {
+		document->Recycle();
+		documents.push_back(std::move(document));
+	}
+}
+
+void XmlDocumentPool::release(std::unique_ptr<tinyxml2::XMLPrinter> &&printer)
+{
+	std::vector<std::unique_ptr<tinyxml2::XMLPrinter>> &printers = threadPool.printers;
+	if (printers.size() < MaxPooledObjects) {
+		printer->ClearBuffer();
+		printers.push_back(std::move(printer));
+	}
+}
@@ -0,0 +1,96 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef COMMON_XMLDOCUMENTPOOL_H_
+#define COMMON_XMLDOCUMENTPOOL_H_
+
+#include <memory>
+#include <utility>
+
+#include "tinyxml2.h"
+
+namespace Microsoft {
+namespace Sharepoint {
+// Thread local pools of tinyxml2 documents and printers.
+// A returned document is recycled instead of destroyed, it keeps its
+// node pools and character buffer, so parsing the next response of a
+// similar size doesn't allocate. Each thread keeps a few objects of each
+// kind, further ones are destroyed on release.
+class XmlDocumentPool
+{
+ public:
+	// hands the object back to the pool of the releasing thread
+	template<class T>
+	class Lease
+	{
+	 public:
+		explicit Lease(std::unique_ptr<T> &&object) :
+			m_object(std::move(object))
+		{
+		}
+		Lease(Lease &&other) noexcept = default;
+		Lease(const Lease &other) = delete;
+		Lease &operator=(const Lease &other) = delete;
+		~Lease()
+		{
+			if (m_object) {
+				XmlDocumentPool::release(std::move(m_object));
+			}
+		}
+
+	 public:
+		T *operator->() const
+		{
+			return m_object.get();
+		}
+		T &operator*() const
+		{
+			return *m_object;
+		}
+		T *get() const
+		{
+			return m_object.get();
+		}
+
+	 private:
+		std::unique_ptr<T> m_object;
+	};
+	typedef Lease<tinyxml2::XMLDocument> DocumentLease;
+	typedef Lease<tinyxml2::XMLPrinter> PrinterLease;
+
+ public:
+	__declspec(dllexport)
+		static XmlDocumentPool::DocumentLease document();
+	__declspec(dllexport)
+		static XmlDocumentPool::PrinterLease printer();
+
+ private:
+	__declspec(dllexport)
+		static void release(std::unique_ptr<tinyxml2::XMLDocument> &&document);
+	__declspec(dllexport)
+		static void release(std::unique_ptr<tinyxml2::XMLPrinter> &&printer);
+};
+}  // namespace Sharepoint
+}  // namespace Microsoft
+
+#endif  // COMMON_XMLDOCUMENTPOOL_H_
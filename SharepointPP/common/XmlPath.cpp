@@ -0,0 +1,215 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "XmlPath.h"
+
+#include <cstring>
+#include <string>
+
+using Microsoft::Sharepoint::XmlPath;
+
+namespace {
+// the namespace uri a prefix is bound to within an element, the text of
+// the xmlns attribute declaring it, valid for one parse of the document
+struct ScopeEntry
+{
+	uint64_t generation {0};
+	const tinyxml2::XMLElement *element {nullptr};
+	std::string_view prefix;
+	const char *namespaceUri {nullptr};
+};
+
+// the xmlns attribute text a step's namespace uri was found in last
+struct StepEntry
+{
+	uint64_t generation {0};
+	const void *step {nullptr};
+	const char *namespaceUri {nullptr};
+};
+
+constexpr size_t CacheSize = 64;
+
+// siblings share the scope of their parent, so the parents are cached
+thread_local ScopeEntry scopeCache[CacheSize];
+thread_local StepEntry stepCache[CacheSize];
+
+size_t cacheSlot(const void *pointer, size_t salt)
+{
+	return ((reinterpret_cast<uintptr_t>(pointer) >> 4) ^ salt) % CacheSize;
+}
+
+// the value of the element's own declaration of the prefix
+const char *declaredNamespace(const tinyxml2::XMLElement &element, std::string_view prefix)
+{
+	for (const tinyxml2::XMLAttribute *attribute = element.FirstAttribute();
+		attribute != nullptr;
+		attribute = attribute->Next()) {
+		std::string_view attributeName(attribute->Name());
+		if (attributeName.substr(0, 5) != "xmlns") {
+			continue;
+		}
+		attributeName.remove_prefix(5);
+		if ((prefix.length() == 0 && attributeName.length() == 0) ||
+			(attributeName.length() == prefix.length() + 1 &&
+			attributeName[0] == ':' &&
+			attributeName.substr(1) == prefix)) {
+			return attribute->Value();
+		}
+	}
+	return nullptr;
+}
+}  // namespace
+
+XmlPath::XmlPath(std::string_view path, const XmlPath::NamespaceContainerType &namespaces) :
+	m_steps(),
+	m_valid(true)
+{
+	while (path.length() > 0) {
+		size_t stepEnd = path.find('/');
+		std::string_view step(path.substr(0, stepEnd));
+		path.remove_prefix(stepEnd == std::string_view::npos ? path.length() : stepEnd + 1);
+		if (step.length() == 0) {
+			continue;
+		}
+		size_t prefixEnd = step.find(':');
+		if (prefixEnd == std::string_view::npos) {
+			m_steps.push_back(Step {std::string(step), std::string(), true});
+			continue;
+		}
+		std::string_view prefix(step.substr(0, prefixEnd));
+		const std::string *namespaceUri = nullptr;
+		for (const auto &entry : namespaces) {
+			if (entry.first == prefix) {
+				namespaceUri = &entry.second;
+				break;
+			}
+		}
+		if (namespaceUri == nullptr) {
+			m_valid = false;
+		}
+		m_steps.push_back(Step {
+			std::string(step.substr(prefixEnd + 1)),
+			namespaceUri != nullptr ? *namespaceUri : std::string(),
+			false});
+	}
+}
+
+XmlPath::~XmlPath()
+{
+}
+
+bool XmlPath::isValid() const
+{
+	return m_valid;
+}
+
+const tinyxml2::XMLElement *XmlPath::first(const tinyxml2::XMLNode &node) const
+{
+	if (!m_valid || m_steps.empty()) {
+		return nullptr;
+	}
+	return firstMatch(node, 0);
+}
+
+tinyxml2::XMLElement *XmlPath::first(tinyxml2::XMLNode &node) const
+{
+	return const_cast<tinyxml2::XMLElement *>(
+		first(static_cast<const tinyxml2::XMLNode &>(node)));
+}
+
+const char *XmlPath::text(const tinyxml2::XMLNode &node) const
+{
+	const tinyxml2::XMLElement *element = first(node);
+	return element != nullptr ? element->GetText() : nullptr;
+}
+
+const tinyxml2::XMLElement *XmlPath::firstMatch(const tinyxml2::XMLNode &node, size_t step) const
+{
+	for (const tinyxml2::XMLElement *child = node.FirstChildElement();
+		child != nullptr;
+		child = child->NextSiblingElement()) {
+		if (matches(*child, m_steps[step])) {
+			if (step + 1 == m_steps.size()) {
+				return child;
+			}
+			const tinyxml2::XMLElement *match = firstMatch(*child, step + 1);
+			if (match != nullptr) {
+				return match;
+			}
+		}
+	}
+	return nullptr;
+}
+
+bool XmlPath::matches(const tinyxml2::XMLElement &element, const Step &step) const
+{
+	std::string_view name(element.Name());
+	size_t prefixEnd = name.find(':');
+	std::string_view localName(
+		prefixEnd == std::string_view::npos ? name : name.substr(prefixEnd + 1));
+	if (localName != step.localName) {
+		return false;
+	}
+	if (step.anyNamespace) {
+		return true;
+	}
+	std::string_view prefix(
+		prefixEnd == std::string_view::npos ? std::string_view() : name.substr(0, prefixEnd));
+	uint64_t generation = element.GetDocument()->Generation();
+	const char *namespaceUri = resolveNamespace(element, prefix, generation);
+	if (namespaceUri == nullptr) {
+		return false;
+	}
+	// a document declares a namespace once, usually, so after the first
+	// comparison of the text its declarations are told apart by address
+	StepEntry &entry = stepCache[cacheSlot(&step, 0)];
+	if (entry.generation == generation && entry.step == &step && entry.namespaceUri == namespaceUri) {
+		return true;
+	}
+	if (strcmp(namespaceUri, step.namespaceUri.c_str()) != 0) {
+		return false;
+	}
+	entry = StepEntry {generation, &step, namespaceUri};
+	return true;
+}
+
+const char *XmlPath::resolveNamespace(
+	const tinyxml2::XMLElement &element, std::string_view prefix, uint64_t generation)
+{
+	// the innermost xmlns / xmlns:prefix declaration in scope wins
+	const char *namespaceUri = declaredNamespace(element, prefix);
+	if (namespaceUri != nullptr) {
+		return namespaceUri;
+	}
+	const tinyxml2::XMLElement *parent =
+		element.Parent() != nullptr ? element.Parent()->ToElement() : nullptr;
+	if (parent == nullptr) {
+		return nullptr;
+	}
+	ScopeEntry *entry = &scopeCache[cacheSlot(parent, prefix.length())];
+	if (entry->generation == generation && entry->element == parent && entry->prefix == prefix) {
+		return entry->namespaceUri;
+	}
+	namespaceUri = resolveNamespace(*parent, prefix, generation);
+	*entry = ScopeEntry {generation, parent, prefix, namespaceUri};
+	return namespaceUri;
+}
@@ -0,0 +1,94 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef COMMON_XMLPATH_H_
+#define COMMON_XMLPATH_H_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+
+#include "tinyxml2.h"
+
+namespace Microsoft {
+namespace Sharepoint {
+// A child element path like "S:Envelope/S:Body/wst:RequestSecurityTokenResponse",
+// compiled once and evaluated against any number of documents.
+// The prefixes of the path are resolved against the given namespace table,
+// the prefixes of the document against its xmlns declarations, so both
+// sides may use different prefixes for the same namespace uri.
+// Evaluating takes no lock, paths can be shared by all parsing threads.
+// Each thread remembers the namespaces in scope per parse of a document,
+// so the xmlns declarations are looked up once, not for every element
+// (edits of a parsed tree aren't seen, parse it again).
+// A step without prefix matches its local name in any namespace.
+class XmlPath
+{
+ public:
+	// prefix -> namespace uri
+	typedef std::vector<std::pair<std::string, std::string>> NamespaceContainerType;
+
+ public:
+	__declspec(dllexport)
+		XmlPath(std::string_view path, const XmlPath::NamespaceContainerType &namespaces);
+	__declspec(dllexport)
+		~XmlPath();
+
+ public:
+	// false if the path uses a prefix missing in the namespace table
+	__declspec(dllexport)
+		bool isValid() const;
+	// the first element matching the path below the document or element
+	__declspec(dllexport)
+		const tinyxml2::XMLElement *first(const tinyxml2::XMLNode &node) const;
+	__declspec(dllexport)
+		tinyxml2::XMLElement *first(tinyxml2::XMLNode &node) const;
+	// the text of the first matching element, nullptr if there is none
+	__declspec(dllexport)
+		const char *text(const tinyxml2::XMLNode &node) const;
+
+ private:
+	struct Step
+	{
+		std::string localName;
+		std::string namespaceUri;
+		// a step without prefix
+		bool anyNamespace;
+	};
+
+ private:
+	const tinyxml2::XMLElement *firstMatch(const tinyxml2::XMLNode &node, size_t step) const;
+	bool matches(const tinyxml2::XMLElement &element, const Step &step) const;
+	static const char *resolveNamespace(
+		const tinyxml2::XMLElement &element, std::string_view prefix, uint64_t generation);
+
+ private:
+	std::vector<Step> m_steps;
+	bool m_valid;
+};
+}  // namespace Sharepoint
+}  // namespace Microsoft
+
+#endif  // COMMON_XMLPATH_H_
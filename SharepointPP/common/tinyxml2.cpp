@@ -24,6 +24,7 @@ distribution.
 #include "tinyxml2.h"
 
 #include <new>		// yes, this one new style header, is in the Android SDK.
+#include <atomic>
 #if defined(ANDROID_NDK) || defined(__BORLANDC__) || defined(__QNXNTO__)
 #   include <stddef.h>
 #   include <stdarg.h>
@@ -101,6 +102,34 @@ distribution.
 #endif
 
 
+#if defined(__AVX2__)
+#   define TINYXML2_SCAN_AVX2
+#   include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   define TINYXML2_SCAN_SSE2
+#   include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER) && (defined(TINYXML2_SCAN_AVX2) || defined(TINYXML2_SCAN_SSE2))
+#   include <intrin.h>
+#endif
+
+// The block scanner reads whole aligned blocks, so it may read past the
+// terminating null character, but never past the page the null is on.
+#if defined(__SANITIZE_ADDRESS__) && defined(_MSC_VER)
+#   define TINYXML2_NO_SANITIZE_ADDRESS __declspec(no_sanitize_address)
+#elif defined(__SANITIZE_ADDRESS__)
+#   define TINYXML2_NO_SANITIZE_ADDRESS __attribute__((no_sanitize_address))
+#elif defined(__has_feature)
+#   if __has_feature(address_sanitizer)
+#       define TINYXML2_NO_SANITIZE_ADDRESS __attribute__((no_sanitize_address))
+#   endif
+#endif
+#ifndef TINYXML2_NO_SANITIZE_ADDRESS
+#   define TINYXML2_NO_SANITIZE_ADDRESS
+#endif
+
+
 static const char LINE_FEED				= (char)0x0a;			// all line endings are normalized to LF
 static const char LF = LINE_FEED;
 static const char CARRIAGE_RETURN		= (char)0x0d;			// CR gets filtered out
@@ -134,6 +163,149 @@ static const Entity entities[NUM_ENTITIES] = {
     { "gt",	2,		'>'	 }
 };
 
+// --------- Scanning ----------- //
+
+// The inner loops of the parser look for the next character out of a
+// small set: the end tag of a text, the next character which needs
+// newline normalization or entity processing, the end of a whitespace
+// run. With SSE2 or AVX2 available these are found a block at a time.
+
+#if defined(TINYXML2_SCAN_AVX2) || defined(TINYXML2_SCAN_SSE2)
+
+#if defined(TINYXML2_SCAN_AVX2)
+struct ScanBlock {
+    static const size_t Size = 32;
+    static const unsigned int AllBits = 0xffffffffU;
+    typedef __m256i Register;
+
+    TINYXML2_NO_SANITIZE_ADDRESS static Register Load( const char* p ) {
+        return _mm256_load_si256( reinterpret_cast<const __m256i*>( p ) );
+    }
+    static unsigned int Equals( Register value, char c ) {
+        return static_cast<unsigned int>( _mm256_movemask_epi8( _mm256_cmpeq_epi8( value, _mm256_set1_epi8( c ) ) ) );
+    }
+    // characters from 0x09 to 0x0d
+    static unsigned int IsControlSpace( Register value ) {
+        const Register offset = _mm256_sub_epi8( value, _mm256_set1_epi8( 0x09 ) );
+        const Register limited = _mm256_min_epu8( offset, _mm256_set1_epi8( 0x0d - 0x09 ) );
+        return static_cast<unsigned int>( _mm256_movemask_epi8( _mm256_cmpeq_epi8( limited, offset ) ) );
+    }
+};
+#else
+struct ScanBlock {
+    static const size_t Size = 16;
+    static const unsigned int AllBits = 0xffffU;
+    typedef __m128i Register;
+
+    TINYXML2_NO_SANITIZE_ADDRESS static Register Load( const char* p ) {
+        return _mm_load_si128( reinterpret_cast<const __m128i*>( p ) );
+    }
+    static unsigned int Equals( Register value, char c ) {
+        return static_cast<unsigned int>( _mm_movemask_epi8( _mm_cmpeq_epi8( value, _mm_set1_epi8( c ) ) ) );
+    }
+    // characters from 0x09 to 0x0d
+    static unsigned int IsControlSpace( Register value ) {
+        const Register offset = _mm_sub_epi8( value, _mm_set1_epi8( 0x09 ) );
+        const Register limited = _mm_min_epu8( offset, _mm_set1_epi8( 0x0d - 0x09 ) );
+        return static_cast<unsigned int>( _mm_movemask_epi8( _mm_cmpeq_epi8( limited, offset ) ) );
+    }
+};
+#endif
+
+static inline unsigned int LowestBit( unsigned int mask )
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward( &index, mask );
+    return index;
+#else
+    return static_cast<unsigned int>( __builtin_ctz( mask ) );
+#endif
+}
+
+static inline int BitCount( unsigned int mask )
+{
+#if defined(_MSC_VER)
+    mask = mask - ( ( mask >> 1 ) & 0x55555555U );
+    mask = ( mask & 0x33333333U ) + ( ( mask >> 2 ) & 0x33333333U );
+    return static_cast<int>( ( ( ( mask + ( mask >> 4 ) ) & 0x0f0f0f0fU ) * 0x01010101U ) >> 24 );
+#else
+    return __builtin_popcount( mask );
+#endif
+}
+
+// Returns the first character for which stopMask() has its bit set and
+// adds the number of 'counted' characters before it to *count.
+// stopMask() has to match the null character, which ends every scan.
+template< class StopMask >
+static const char* ScanBlocks( const char* p, StopMask stopMask, char counted, int* count )
+{
+    const size_t offset = reinterpret_cast<uintptr_t>( p ) & ( ScanBlock::Size - 1 );
+    const char* block = p - offset;
+    unsigned int validBits = ( ScanBlock::AllBits << offset ) & ScanBlock::AllBits;
+    for( ;; ) {
+        const ScanBlock::Register value = ScanBlock::Load( block );
+        const unsigned int stops = stopMask( value ) & validBits;
+        const unsigned int counts = count ? ScanBlock::Equals( value, counted ) & validBits : 0;
+        if ( stops ) {
+            const unsigned int index = LowestBit( stops );
+            if ( count ) {
+                *count += BitCount( counts & ( ( 1U << index ) - 1 ) );
+            }
+            return block + index;
+        }
+        if ( count ) {
+            *count += BitCount( counts );
+        }
+        block += ScanBlock::Size;
+        validBits = ScanBlock::AllBits;
+    }
+}
+
+// First of c0, c1, c2 or the null character. Counts the line feeds on the way.
+static const char* ScanFor( const char* p, char c0, char c1, char c2, int* lineFeeds )
+{
+    return ScanBlocks( p, [c0, c1, c2]( ScanBlock::Register value ) {
+        return ScanBlock::Equals( value, 0 ) | ScanBlock::Equals( value, c0 )
+               | ScanBlock::Equals( value, c1 ) | ScanBlock::Equals( value, c2 );
+    }, LF, lineFeeds );
+}
+
+// First character which isn't whitespace. Counts the line feeds on the way.
+static const char* ScanWhiteSpace( const char* p, int* lineFeeds )
+{
+    return ScanBlocks( p, []( ScanBlock::Register value ) {
+        return ~( ScanBlock::Equals( value, ' ' ) | ScanBlock::IsControlSpace( value ) );
+    }, LF, lineFeeds );
+}
+
+#else
+
+static const char* ScanFor( const char* p, char c0, char c1, char c2, int* lineFeeds )
+{
+    while ( *p && *p != c0 && *p != c1 && *p != c2 ) {
+        if ( lineFeeds && *p == LF ) {
+            ++(*lineFeeds);
+        }
+        ++p;
+    }
+    return p;
+}
+
+static const char* ScanWhiteSpace( const char* p, int* lineFeeds )
+{
+    while ( XMLUtil::IsWhiteSpace( *p ) ) {
+        if ( lineFeeds && *p == LF ) {
+            ++(*lineFeeds);
+        }
+        ++p;
+    }
+    return p;
+}
+
+#endif
+
+
 
 StrPair::~StrPair()
 {
@@ -200,13 +372,17 @@ char* StrPair::ParseText( char* p, const char* endTag, int strFlags, int* curLin
     char  endChar = *endTag;
     size_t length = strlen( endTag );
 
+    TIXMLASSERT( endChar != LF );
+
     // Inner loop of text parsing.
-    while ( *p ) {
-        if ( *p == endChar && strncmp( p, endTag, length ) == 0 ) {
+    for( ;; ) {
+        p = const_cast<char*>( ScanFor( p, endChar, endChar, endChar, curLineNumPtr ) );
+        if ( !*p ) {
+            break;
+        }
+        if ( strncmp( p, endTag, length ) == 0 ) {
             Set( start, p, strFlags );
             return p + length;
-        } else if (*p == '\n') {
-            ++(*curLineNumPtr);
         }
         ++p;
         TIXMLASSERT( p );
@@ -276,7 +452,22 @@ const char* StrPair::GetStr()
             const char* p = _start;	// the read pointer
             char* q = _start;	// the write pointer
 
+            // the characters which need work, unused ones are the null character
+            const char newline0 = (_flags & NEEDS_NEWLINE_NORMALIZATION) ? CR : 0;
+            const char newline1 = (_flags & NEEDS_NEWLINE_NORMALIZATION) ? LF : 0;
+            const char entity = (_flags & NEEDS_ENTITY_PROCESSING) ? '&' : 0;
+
             while( p < _end ) {
+                // plain characters are moved a run at a time
+                const char* run = ScanFor( p, newline0, newline1, entity, 0 );
+                if ( run != p ) {
+                    if ( q != p ) {
+                        memmove( q, p, run - p );
+                    }
+                    q += run - p;
+                    p = run;
+                    continue;
+                }
                 if ( (_flags & NEEDS_NEWLINE_NORMALIZATION) && *p == CR ) {
                     // CR-LF pair becomes LF
                     // CR alone becomes LF
@@ -369,6 +560,15 @@ const char* StrPair::GetStr()
 
 // --------- XMLUtil ----------- //
 
+const char* XMLUtil::SkipWhiteSpaceRun( const char* p, int* curLineNumPtr )
+{
+    TIXMLASSERT( p );
+    p = ScanWhiteSpace( p, curLineNumPtr );
+    TIXMLASSERT( p );
+    return p;
+}
+
+
 const char* XMLUtil::writeBoolTrue  = "true";
 const char* XMLUtil::writeBoolFalse = "false";
 
@@ -2003,6 +2203,9 @@ const char* XMLDocument::_errorNames[XML_ERROR_COUNT] = {
 };
 
 
+// the generations handed out to documents, shared by all of them
+static std::atomic<uint64_t> lastGeneration( 0 );
+
 XMLDocument::XMLDocument( bool processEntities, Whitespace whitespaceMode ) :
     XMLNode( 0 ),
     _writeBOM( false ),
@@ -2012,8 +2215,11 @@ XMLDocument::XMLDocument( bool processEntities, Whitespace whitespaceMode ) :
     _errorStr(),
     _errorLineNum( 0 ),
     _charBuffer( 0 ),
+    _charBufferSize( 0 ),
+    _inSituBuffer(),
     _parseCurLineNum( 0 ),
 	_parsingDepth(0),
+	_generation( ++lastGeneration ),
     _unlinked(),
     _elementPool(),
     _attributePool(),
@@ -2046,6 +2252,43 @@ void XMLDocument::MarkInUse(XMLNode* node)
 
 void XMLDocument::Clear()
 {
+    ClearNodes();
+    ReleaseInSituBuffer();
+    delete [] _charBuffer;
+    _charBuffer = 0;
+    _charBufferSize = 0;
+}
+
+
+void XMLDocument::ReleaseInSituBuffer()
+{
+    if ( _charBuffer && _charBuffer == &_inSituBuffer[0] ) {
+        _charBuffer = 0;
+    }
+    std::string().swap( _inSituBuffer );
+}
+
+
+// a recycled document keeps a character buffer up to this size, a larger
+// one of an unusually large response is freed instead of staying in a pool
+static const size_t MaxRecycledCharBufferSize = 1024 * 1024;
+
+void XMLDocument::Recycle()
+{
+    ClearNodes();
+    // an in situ buffer belongs to one response and can't be reused
+    ReleaseInSituBuffer();
+    if ( _charBufferSize > MaxRecycledCharBufferSize ) {
+        delete [] _charBuffer;
+        _charBuffer = 0;
+        _charBufferSize = 0;
+    }
+}
+
+
+void XMLDocument::ClearNodes()
+{
+    _generation = ++lastGeneration;
     DeleteChildren();
 	while( _unlinked.Size()) {
 		DeleteNode(_unlinked[0]);	// Will remove from _unlinked as part of delete.
@@ -2056,8 +2299,6 @@ void XMLDocument::Clear()
 #endif
     ClearError();
 
-    delete [] _charBuffer;
-    _charBuffer = 0;
 	_parsingDepth = 0;
 
 #if 0
@@ -2239,6 +2480,7 @@ XMLError XMLDocument::LoadFile( FILE* fp )
     const size_t size = filelength;
     TIXMLASSERT( _charBuffer == 0 );
     _charBuffer = new char[size+1];
+    _charBufferSize = size+1;
     size_t read = fread( _charBuffer, 1, size, fp );
     if ( read != size ) {
         SetError( XML_ERROR_FILE_READ_ERROR, 0, 0 );
@@ -2284,7 +2526,8 @@ XMLError XMLDocument::SaveFile( FILE* fp, bool compact )
 
 XMLError XMLDocument::Parse( const char* p, size_t len )
 {
-    Clear();
+    // keeps the character buffer of the last parse if it is large enough
+    ClearNodes();
 
     if ( len == 0 || !p || !*p ) {
         SetError( XML_ERROR_EMPTY_DOCUMENT, 0, 0 );
@@ -2293,8 +2536,12 @@ XMLError XMLDocument::Parse( const char* p, size_t len )
     if ( len == (size_t)(-1) ) {
         len = strlen( p );
     }
-    TIXMLASSERT( _charBuffer == 0 );
-    _charBuffer = new char[ len+1 ];
+    ReleaseInSituBuffer();
+    if ( _charBufferSize < len+1 ) {
+        delete [] _charBuffer;
+        _charBuffer = new char[ len+1 ];
+        _charBufferSize = len+1;
+    }
     memcpy( _charBuffer, p, len );
     _charBuffer[len] = 0;
 
@@ -2313,6 +2560,35 @@ XMLError XMLDocument::Parse( const char* p, size_t len )
 }
 
 
+XMLError XMLDocument::ParseInSitu( std::string&& xml )
+{
+    ClearNodes();
+    ReleaseInSituBuffer();
+    // the buffer of earlier copying parses isn't needed anymore
+    delete [] _charBuffer;
+    _charBuffer = 0;
+    _charBufferSize = 0;
+
+    if ( xml.empty() ) {
+        SetError( XML_ERROR_EMPTY_DOCUMENT, 0, 0 );
+        return _errorID;
+    }
+    _inSituBuffer.swap( xml );
+    // the parse ends at the first null character, like Parse() with strlen
+    _charBuffer = &_inSituBuffer[0];
+
+    Parse();
+    if ( Error() ) {
+        DeleteChildren();
+        _elementPool.Clear();
+        _attributePool.Clear();
+        _textPool.Clear();
+        _commentPool.Clear();
+    }
+    return _errorID;
+}
+
+
 void XMLDocument::Print( XMLPrinter* streamer ) const
 {
     if ( streamer ) {
@@ -41,6 +41,7 @@ distribution.
 #   include <cstring>
 #endif
 #include <stdint.h>
+#include <string>
 
 /*
    TODO: intern strings instead of allocation.
@@ -553,23 +554,24 @@ public:
 	__declspec(dllexport) static const char* SkipWhiteSpace( const char* p, int* curLineNumPtr )	{
         TIXMLASSERT( p );
 
-        while( IsWhiteSpace(*p) ) {
-            if (curLineNumPtr && *p == '\n') {
-                ++(*curLineNumPtr);
-            }
-            ++p;
+        // most calls are at a character which isn't whitespace
+        if ( !IsWhiteSpace(*p) ) {
+            return p;
         }
-        TIXMLASSERT( p );
-        return p;
+        return SkipWhiteSpaceRun( p, curLineNumPtr );
     }
 	__declspec(dllexport) static char* SkipWhiteSpace( char* p, int* curLineNumPtr )				{
         return const_cast<char*>( SkipWhiteSpace( const_cast<const char*>(p), curLineNumPtr ) );
     }
 
+    // Skips a run of whitespace a block at a time, see SkipWhiteSpace().
+	__declspec(dllexport) static const char* SkipWhiteSpaceRun( const char* p, int* curLineNumPtr );
+
     // Anything in the high order range of UTF-8 is assumed to not be whitespace. This isn't
     // correct, but simple, and usually works.
 	__declspec(dllexport) static bool IsWhiteSpace( char p )					{
-        return !IsUTF8Continuation(p) && isspace( static_cast<unsigned char>(p) );
+        // the characters isspace() accepts in the "C" locale, without the call
+        return p == ' ' || ( p >= '\t' && p <= '\r' );
     }
 
 	__declspec(dllexport) inline static bool IsNameStartChar( unsigned char ch ) {
@@ -577,7 +579,8 @@ public:
             // This is a heuristic guess in attempt to not implement Unicode-aware isalpha()
             return true;
         }
-        if ( isalpha( ch ) ) {
+        // isalpha() in the "C" locale
+        if ( static_cast<unsigned char>( ( ch | 0x20 ) - 'a' ) < 26 ) {
             return true;
         }
         return ch == ':' || ch == '_';
@@ -585,7 +588,7 @@ public:
 
 	__declspec(dllexport) inline static bool IsNameChar( unsigned char ch ) {
         return IsNameStartChar( ch )
-               || isdigit( ch )
+               || ( ch >= '0' && ch <= '9' )
                || ch == '.'
                || ch == '-';
     }
@@ -1687,6 +1690,15 @@ public:
     */
 	__declspec(dllexport) XMLError Parse( const char* xml, size_t nBytes=(size_t)(-1) );
 
+    /**
+    	Parse an XML document in situ: the document takes ownership of
+    	the string and parses it in place instead of copying it into its
+    	own character buffer. The text of the nodes points into the
+    	string, which is modified by the parse and released by Clear().
+    	Returns XML_SUCCESS (0) on success, or an errorID.
+    */
+	__declspec(dllexport) XMLError ParseInSitu( std::string&& xml );
+
     /**
     	Load an XML file from disk.
     	Returns XML_SUCCESS (0) on success, or
@@ -1813,7 +1825,10 @@ public:
 	__declspec(dllexport) void DeleteNode( XMLNode* node );
 
 	__declspec(dllexport) void ClearError() {
-        SetError(XML_SUCCESS, 0, 0);
+        // no error message is formatted, clearing a recycled document doesn't allocate
+        _errorID = XML_SUCCESS;
+        _errorLineNum = 0;
+        _errorStr.Reset();
     }
 
     /// Return true if there was an error parsing the document.
@@ -1844,6 +1859,25 @@ public:
     /// Clear the document, resetting it to the initial state.
 	__declspec(dllexport) void Clear();
 
+    /**
+    	Clear the document like Clear(), but keep the memory pools and
+    	the character buffer, so the next Parse() of a document of similar
+    	size does not allocate. Used to reuse documents from a pool.
+    	A buffer handed over by ParseInSitu() is released, and so is a
+    	character buffer larger than 1 MiB.
+    */
+	__declspec(dllexport) void Recycle();
+
+    /**
+    	A number which changes whenever the nodes of the document are
+    	cleared (Parse(), ParseInSitu(), LoadFile(), Clear(), Recycle()),
+    	unique among all documents. Lets callers cache facts about the
+    	nodes of one parse. Edits of the tree don't change it.
+    */
+	__declspec(dllexport) uint64_t Generation() const	{
+        return _generation;
+    }
+
 	/**
 		Copies this document to a target document.
 		The target will be completely cleared before the copy.
@@ -1877,8 +1911,12 @@ private:
     mutable StrPair	_errorStr;
     int             _errorLineNum;
     char*			_charBuffer;
+    size_t			_charBufferSize;
+    // owns the character buffer after ParseInSitu()
+    std::string		_inSituBuffer;
     int				_parseCurLineNum;
 	int				_parsingDepth;
+	uint64_t		_generation;
 	// Memory tracking does add some overhead.
 	// However, the code assumes that you don't
 	// have a bunch of unlinked nodes around.
@@ -1895,6 +1933,8 @@ private:
 	static const char* _errorNames[XML_ERROR_COUNT];
 
 	__declspec(dllexport) void Parse();
+	void ClearNodes();
+	void ReleaseInSituBuffer();
 
 	__declspec(dllexport) void SetError( XMLError error, int lineNum, const char* format, ... );
 
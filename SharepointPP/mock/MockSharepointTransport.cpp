@@ -0,0 +1,1010 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "MockSharepointTransport.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "../common/PercentEncoding.h"
+#include "../common/RequestTimings.h"
+#include "../common/TransportResponse.h"
+#include "../common/WebRequest.h"
+
+using Microsoft::Sharepoint::ChangeFeed;
+using Microsoft::Sharepoint::MockSharepointTransport;
+using Microsoft::Sharepoint::PercentEncoding;
+using Microsoft::Sharepoint::RequestMetrics;
+using Microsoft::Sharepoint::RequestTimings;
+using Microsoft::Sharepoint::Transport;
+using Microsoft::Sharepoint::TransportResponse;
+using Microsoft::Sharepoint::WebRequest;
+using Microsoft::Sharepoint::WebResponse;
+
+namespace {
+// the timestamps of the mock never change, so two runs send the same bytes
+const char *const fixedTimestamp = "2018-06-01T12:00:00Z";
+const char *const listGuid = "6d8a7c2e-3f41-4b4e-9b7a-0c1d2e3f4a5b";
+
+std::string lowerCase(std::string_view text)
+{
+	std::string lower(text);
+	for (char &c : lower) {
+		if (c >= 'A' && c <= 'Z') {
+			c = static_cast<char>(c - 'A' + 'a');
+		}
+	}
+	return lower;
+}
+
+bool endsWith(std::string_view text, std::string_view suffix)
+{
+	return text.length() >= suffix.length() &&
+		text.substr(text.length() - suffix.length()) == suffix;
+}
+
+// the text between the first start tag and the following end tag
+std::string_view elementText(std::string_view xml, std::string_view startTag, std::string_view endTag, size_t from = 0)
+{
+	size_t start = xml.find(startTag, from);
+	if (start == std::string_view::npos) {
+		return std::string_view();
+	}
+	start += startTag.length();
+	size_t end = xml.find(endTag, start);
+	if (end == std::string_view::npos) {
+		return std::string_view();
+	}
+	return xml.substr(start, end - start);
+}
+
+// the number after the key in the decoded query, or the fallback
+size_t queryNumber(std::string_view query, std::string_view key, size_t fallback)
+{
+	size_t position = query.find(key);
+	if (position == std::string_view::npos) {
+		return fallback;
+	}
+	position += key.length();
+	size_t value = 0;
+	bool found = false;
+	while (position < query.length() && query[position] >= '0' && query[position] <= '9') {
+		value = value * 10 + static_cast<size_t>(query[position++] - '0');
+		found = true;
+	}
+	return found ? value : fallback;
+}
+
+bool hasCookie(std::string_view cookieHeader, std::string_view name)
+{
+	size_t position = 0;
+	while (position < cookieHeader.length()) {
+		while (position < cookieHeader.length() && cookieHeader[position] == ' ') {
+			++position;
+		}
+		if (cookieHeader.substr(position, name.length()) == name &&
+			cookieHeader.substr(position + name.length(), 1) == "=") {
+			return true;
+		}
+		size_t next = cookieHeader.find(';', position);
+		if (next == std::string_view::npos) {
+			break;
+		}
+		position = next + 1;
+	}
+	return false;
+}
+
+std::string requestHeader(const WebRequest &request, std::string_view name)
+{
+	for (auto &header : request.headers()) {
+		if (lowerCase(header.first) == lowerCase(name)) {
+			return header.second;
+		}
+	}
+	return std::string();
+}
+
+std::string errorBody(const char *code, const char *message)
+{
+	std::string body(
+		"<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+		"<m:error xmlns:m=\"http://schemas.microsoft.com/ado/2007/08/dataservices/metadata\"><m:code>");
+	body += code;
+	body += "</m:code><m:message xml:lang=\"en-US\">";
+	body += message;
+	body += "</m:message></m:error>";
+	return body;
+}
+
+TransportResponse stsResponse(const std::string &data, const Url &url)
+{
+	std::string_view request(data);
+	std::string_view username = elementText(request, "<o:Username>", "</o:Username>");
+	std::string_view password = elementText(request, "<o:Password>", "</o:Password>");
+	size_t appliesTo = request.find("<wsp:AppliesTo");
+	std::string_view endpoint = appliesTo != std::string_view::npos ?
+		elementText(request, "<a:Address>", "</a:Address>", appliesTo) : std::string_view();
+	std::string body(
+		"<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+		"<S:Envelope"
+		" xmlns:S=\"http://www.w3.org/2003/05/soap-envelope\""
+		" xmlns:wsa=\"http://www.w3.org/2005/08/addressing\""
+		" xmlns:wsse=\"http://docs.oasis-open.org/wss/2004/01/oasis-200401-wss-wssecurity-secext-1.0.xsd\""
+		" xmlns:wst=\"http://schemas.xmlsoap.org/ws/2005/02/trust\""
+		" xmlns:wsp=\"http://schemas.xmlsoap.org/ws/2004/09/policy\">"
+		"<S:Body>");
+	if (username.empty() || password.empty() || endpoint.empty()) {
+		// the real sts answers with a fault, the client only looks for the token
+		body += "<S:Fault><S:Code><S:Value>S:Sender</S:Value></S:Code>"
+			"<S:Reason><S:Text xml:lang=\"en-US\">Authentication Failure</S:Text></S:Reason></S:Fault>";
+	} else {
+		body += "<wst:RequestSecurityTokenResponse>"
+			"<wsp:AppliesTo><wsa:EndpointReference><wsa:Address>";
+		body += endpoint;
+		body += "</wsa:Address></wsa:EndpointReference></wsp:AppliesTo>"
+			"<wst:RequestedSecurityToken>"
+			"<wsse:BinarySecurityToken Id=\"Compact0\">t%3Dmock%26u%3D";
+		PercentEncoding::appendEncoded(username, body);
+		body += "</wsse:BinarySecurityToken></wst:RequestedSecurityToken>"
+			"</wst:RequestSecurityTokenResponse>";
+	}
+	body += "</S:Body></S:Envelope>";
+	TransportResponse response(200, std::move(body), url);
+	response.addHeader("Content-Type", "application/soap+xml; charset=utf-8");
+	return response;
+}
+
+TransportResponse loginPageResponse(const WebRequest &request, const std::string &data, const Url &url)
+{
+	if (data.compare(0, 2, "t=") != 0) {
+		return TransportResponse(403, errorBody("-2147024891, System.UnauthorizedAccessException", "Access denied."), url);
+	}
+	// the cookie carries the token, without the characters a cookie value can't hold
+	std::string fedAuth("77u/");
+	for (char c : data) {
+		if (c != ';' && c != ',' && c != ' ' && c != '"' && c != '\\') {
+			fedAuth += c;
+		}
+	}
+	TransportResponse response(200, std::string("<html><body>signed in</body></html>"), url);
+	response.addHeader("Content-Type", "text/html; charset=utf-8");
+	response.addCookie("FedAuth", fedAuth);
+	response.addHeader("Set-Cookie", "FedAuth=" + fedAuth + "; path=/; secure; HttpOnly");
+	response.addCookie("rtFa", "mock");
+	response.addHeader("Set-Cookie", "rtFa=mock; path=/; secure; HttpOnly");
+	response.storeCookies(request.cookieJar(), url);
+	return response;
+}
+
+TransportResponse contextInfoResponse(size_t digestNumber, const Url &url)
+{
+	char digest[64];
+	snprintf(digest, sizeof(digest), "0x%032zX,01 Jun 2018 12:00:00 -0000", digestNumber);
+	std::string body(
+		"<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+		"<d:GetContextWebInformation"
+		" xmlns:d=\"http://schemas.microsoft.com/ado/2007/08/dataservices\""
+		" xmlns:m=\"http://schemas.microsoft.com/ado/2007/08/dataservices/metadata\""
+		" m:type=\"SP.ContextWebInformation\">"
+		"<d:FormDigestTimeoutSeconds m:type=\"Edm.Int32\">1800</d:FormDigestTimeoutSeconds>"
+		"<d:FormDigestValue>");
+	body += digest;
+	body += "</d:FormDigestValue>"
+		"<d:LibraryVersion>16.0.0.0</d:LibraryVersion>"
+		"<d:SiteFullUrl>";
+	body += url.protocolPrefix();
+	body += url.host();
+	body += "</d:SiteFullUrl></d:GetContextWebInformation>";
+	TransportResponse response(200, std::move(body), url);
+	response.addHeader("Content-Type", "application/xml;charset=utf-8");
+	return response;
+}
+
+std::string listTitle(std::string_view resource)
+{
+	std::string listName("List");
+	size_t titleStart = resource.find("getbytitle('");
+	if (titleStart != std::string_view::npos) {
+		titleStart += std::string_view("getbytitle('").length();
+		size_t titleEnd = resource.find("')", titleStart);
+		if (titleEnd != std::string_view::npos) {
+			listName = std::string(resource.substr(titleStart, titleEnd - titleStart));
+		}
+	}
+	return listName;
+}
+
+// the last change of the content, a minute later with every version
+std::string contentTimestamp(size_t contentVersion)
+{
+	size_t minutes = 12 * 60 + contentVersion - 1;
+	char timestamp[32];
+	snprintf(timestamp, sizeof(timestamp), "2018-06-%02zuT%02zu:%02zu:00Z",
+		1 + minutes / (24 * 60) % 28, minutes / 60 % 24, minutes % 60);
+	return timestamp;
+}
+
+bool expandsFile(const Url &url)
+{
+	std::string query = PercentEncoding::decode(url.query());
+	size_t expand = query.find("$expand=");
+	return expand != std::string::npos && query.find("File", expand) != std::string::npos;
+}
+
+// the item of the given version, its file is <list>/Folder<n>/Item<id>.txt
+// with a hundred items per folder, the file entry is inlined if asked for
+void appendItemEntry(std::string &body, size_t id, size_t version, size_t contentVersion, bool withFile,
+	const std::string &listName, size_t titleLength, size_t fileSize,
+	std::string_view namespaces = std::string_view())
+{
+	std::string number = std::to_string(id);
+	body += "<entry";
+	body += namespaces;
+	body += " m:etag=\"&quot;";
+	body += std::to_string(version);
+	body += "&quot;\"><id>";
+	body += listGuid;
+	body += "</id><category term=\"SP.Data.";
+	body += listName;
+	body += "ListItem\" scheme=\"http://schemas.microsoft.com/ado/2007/08/dataservices/scheme\" />"
+		"<link rel=\"edit\" href=\"Web/Lists(guid'";
+	body += listGuid;
+	body += "')/Items(";
+	body += number;
+	body += ")\" />";
+	if (withFile) {
+		body += "<link rel=\"http://schemas.microsoft.com/ado/2007/08/dataservices/related/File\""
+			" type=\"application/atom+xml;type=entry\" title=\"File\" href=\"Web/Lists(guid'";
+		body += listGuid;
+		body += "')/Items(";
+		body += number;
+		body += ")/File\"><m:inline><entry><content type=\"application/xml\"><m:properties>"
+			"<d:Length m:type=\"Edm.Int64\">";
+		body += std::to_string(fileSize);
+		body += "</d:Length><d:TimeLastModified m:type=\"Edm.DateTime\">";
+		body += contentTimestamp(contentVersion);
+		body += "</d:TimeLastModified></m:properties></content></entry></m:inline></link>";
+	}
+	body += "<title /><updated>";
+	body += fixedTimestamp;
+	body += "</updated><author><name /></author><content type=\"application/xml\"><m:properties>"
+		"<d:FileSystemObjectType m:type=\"Edm.Int32\">0</d:FileSystemObjectType>"
+		"<d:Id m:type=\"Edm.Int32\">";
+	body += number;
+	body += "</d:Id><d:Title>";
+	// the title starts with the id and is filled up to its length
+	body += number;
+	if (titleLength > number.length()) {
+		body.append(titleLength - number.length(), 'x');
+	}
+	body += "</d:Title><d:Modified m:type=\"Edm.DateTime\">";
+	body += fixedTimestamp;
+	body += "</d:Modified><d:Created m:type=\"Edm.DateTime\">";
+	body += fixedTimestamp;
+	body += "</d:Created><d:AuthorId m:type=\"Edm.Int32\">7</d:AuthorId><d:FileRef>/";
+	body += listName;
+	body += "/Folder";
+	body += std::to_string((id - 1) / 100 + 1);
+	body += "/Item";
+	body += number;
+	body += ".txt</d:FileRef><d:File_x0020_Size>";
+	body += std::to_string(fileSize);
+	body += "</d:File_x0020_Size><d:ID m:type=\"Edm.Int32\">";
+	body += number;
+	body += "</d:ID></m:properties></content></entry>";
+}
+
+size_t itemVersion(const std::unordered_map<size_t, size_t> &versions, size_t id)
+{
+	auto version = versions.find(id);
+	return version != versions.end() ? version->second : 1;
+}
+
+TransportResponse listItemsResponse(const Url &url, size_t itemCount, size_t pageSize, size_t titleLength, size_t fileSize,
+	const std::unordered_map<size_t, size_t> &versions, const std::unordered_map<size_t, size_t> &contentVersions,
+	const std::unordered_set<size_t> &deleted)
+{
+	std::string query = PercentEncoding::decode(url.query());
+	size_t top = queryNumber(query, "$top=", pageSize);
+	if (top == 0) {
+		top = pageSize;
+	}
+	size_t lastId = queryNumber(query, "p_ID=", 0);
+	size_t firstId = lastId + 1;
+	size_t endId = lastId + top < itemCount ? lastId + top : itemCount;
+
+	std::string resource(url.resource());
+	std::string listName = listTitle(resource);
+	std::string base;
+	base += url.protocolPrefix();
+	base += url.host();
+	size_t apiStart = resource.find("/_api/");
+	base += resource.substr(0, apiStart != std::string::npos ? apiStart + 6 : 0);
+
+	std::string body;
+	body.reserve(512 + (endId >= firstId ? endId - firstId + 1 : 0) * (1000 + titleLength));
+	body += "<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+		"<feed xml:base=\"";
+	body += base;
+	body += "\" xmlns=\"http://www.w3.org/2005/Atom\""
+		" xmlns:d=\"http://schemas.microsoft.com/ado/2007/08/dataservices\""
+		" xmlns:m=\"http://schemas.microsoft.com/ado/2007/08/dataservices/metadata\""
+		" xmlns:georss=\"http://www.georss.org/georss\" xmlns:gml=\"http://www.opengis.net/gml\">"
+		"<id>";
+	body += listGuid;
+	body += "</id><title /><updated>";
+	body += fixedTimestamp;
+	body += "</updated>";
+	bool withFile = expandsFile(url);
+	for (size_t id = firstId; id <= endId; ++id) {
+		// deleted items leave a gap in the page like in sharepoint
+		if (deleted.count(id) == 0) {
+			appendItemEntry(body, id, itemVersion(versions, id), itemVersion(contentVersions, id), withFile,
+				listName, titleLength, fileSize);
+		}
+	}
+	if (endId < itemCount) {
+		body += "<link rel=\"next\" href=\"";
+		body += url.protocolPrefix();
+		body += url.host();
+		body += resource;
+		body += "?%24skiptoken=Paged%3dTRUE%26p_ID%3d";
+		body += std::to_string(endId);
+		body += "&amp;%24top=";
+		body += std::to_string(top);
+		body += "\" />";
+	}
+	body += "</feed>";
+	TransportResponse response(200, std::move(body), url);
+	response.addHeader("Content-Type", "application/atom+xml;type=feed;charset=utf-8");
+	return response;
+}
+
+TransportResponse itemResponse(const Url &url, size_t id, size_t version, size_t contentVersion, size_t titleLength, size_t fileSize)
+{
+	std::string body("<?xml version=\"1.0\" encoding=\"utf-8\"?>");
+	appendItemEntry(body, id, version, contentVersion, expandsFile(url), listTitle(url.resource()), titleLength, fileSize,
+		" xmlns=\"http://www.w3.org/2005/Atom\""
+		" xmlns:d=\"http://schemas.microsoft.com/ado/2007/08/dataservices\""
+		" xmlns:m=\"http://schemas.microsoft.com/ado/2007/08/dataservices/metadata\"");
+	TransportResponse response(200, std::move(body), url);
+	response.addHeader("Content-Type", "application/atom+xml;type=entry;charset=utf-8");
+	return response;
+}
+
+TransportResponse rootFolderResponse(const Url &url)
+{
+	std::string body(
+		"<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+		"<entry xmlns=\"http://www.w3.org/2005/Atom\""
+		" xmlns:d=\"http://schemas.microsoft.com/ado/2007/08/dataservices\""
+		" xmlns:m=\"http://schemas.microsoft.com/ado/2007/08/dataservices/metadata\">"
+		"<content type=\"application/xml\"><m:properties><d:Name>");
+	std::string listName = listTitle(url.resource());
+	body += listName;
+	body += "</d:Name><d:ServerRelativeUrl>/";
+	body += listName;
+	body += "</d:ServerRelativeUrl></m:properties></content></entry>";
+	TransportResponse response(200, std::move(body), url);
+	response.addHeader("Content-Type", "application/atom+xml;type=entry;charset=utf-8");
+	return response;
+}
+
+TransportResponse batchResponse(const std::string &data, const Url &url, size_t batchNumber)
+{
+	static const char *const methods[] = {"GET ", "POST ", "PUT ", "PATCH ", "MERGE ", "DELETE "};
+	size_t parts = 0;
+	size_t lineStart = 0;
+	while (lineStart < data.length()) {
+		size_t lineEnd = data.find('\n', lineStart);
+		if (lineEnd == std::string::npos) {
+			lineEnd = data.length();
+		}
+		std::string_view line(data.data() + lineStart, lineEnd - lineStart);
+		for (const char *method : methods) {
+			if (line.compare(0, strlen(method), method) == 0 && line.find(" HTTP/1.1") != std::string_view::npos) {
+				++parts;
+				break;
+			}
+		}
+		lineStart = lineEnd + 1;
+	}
+	char boundary[64];
+	snprintf(boundary, sizeof(boundary), "batchresponse_%08zx-0000-4000-8000-000000000000", batchNumber);
+	std::string body;
+	for (size_t part = 0; part < parts; ++part) {
+		body += "--";
+		body += boundary;
+		body += "\r\nContent-Type: application/http\r\nContent-Transfer-Encoding: binary\r\n\r\n"
+			"HTTP/1.1 200 OK\r\nCONTENT-TYPE: application/json;odata=verbose;charset=utf-8\r\n\r\n"
+			"{\"d\":{}}\r\n";
+	}
+	body += "--";
+	body += boundary;
+	body += "--\r\n";
+	TransportResponse response(200, std::move(body), url);
+	response.addHeader("Content-Type", std::string("multipart/mixed; boundary=") + boundary);
+	return response;
+}
+
+TransportResponse itemUpdateResponse(const Url &url)
+{
+	// a merge answers without a body, the etag tells the new version
+	TransportResponse response(204, std::string(), url);
+	response.addHeader("ETag", "\"2\"");
+	return response;
+}
+
+TransportResponse fileUploadResponse(const std::string &data, const Url &url)
+{
+	std::string resource(url.resource());
+	std::string name;
+	size_t nameStart = resource.find("url='");
+	if (nameStart != std::string::npos) {
+		nameStart += std::string_view("url='").length();
+		name = resource.substr(nameStart, resource.find('\'', nameStart) - nameStart);
+	}
+	std::string body(
+		"<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+		"<entry xmlns=\"http://www.w3.org/2005/Atom\""
+		" xmlns:d=\"http://schemas.microsoft.com/ado/2007/08/dataservices\""
+		" xmlns:m=\"http://schemas.microsoft.com/ado/2007/08/dataservices/metadata\">"
+		"<content type=\"application/xml\"><m:properties>"
+		"<d:Length m:type=\"Edm.Int64\">");
+	body += std::to_string(data.length());
+	body += "</d:Length><d:Name>";
+	body += name;
+	body += "</d:Name><d:TimeLastModified m:type=\"Edm.DateTime\">";
+	body += fixedTimestamp;
+	body += "</d:TimeLastModified></m:properties></content></entry>";
+	TransportResponse response(200, std::move(body), url);
+	response.addHeader("Content-Type", "application/atom+xml;type=entry;charset=utf-8");
+	return response;
+}
+
+std::string changeToken(size_t changeNumber)
+{
+	// <version>;<scope>;<object id>;<ticks>;<change number>, only the
+	// change number moves
+	return std::string("1;3;") + listGuid + ";636634800000000000;" + std::to_string(changeNumber);
+}
+
+// the change number of ChangeTokenStart in the change query, 0 without one
+size_t startChangeNumber(std::string_view query)
+{
+	size_t tokenStart = query.find("\"ChangeTokenStart\"");
+	if (tokenStart == std::string_view::npos) {
+		return 0;
+	}
+	size_t valueStart = query.find("\"StringValue\":\"", tokenStart);
+	if (valueStart == std::string_view::npos) {
+		return 0;
+	}
+	valueStart += std::string_view("\"StringValue\":\"").length();
+	size_t valueEnd = query.find('"', valueStart);
+	size_t numberStart = query.rfind(';', valueEnd);
+	if (valueEnd == std::string_view::npos || numberStart == std::string_view::npos || numberStart < valueStart) {
+		return 0;
+	}
+	return strtoul(std::string(query.substr(numberStart + 1, valueEnd - numberStart - 1)).c_str(), nullptr, 10);
+}
+
+size_t fetchLimit(std::string_view query)
+{
+	size_t limitStart = query.find("\"FetchLimit\":");
+	if (limitStart == std::string_view::npos) {
+		return 1000;
+	}
+	limitStart += std::string_view("\"FetchLimit\":").length();
+	size_t limit = strtoul(std::string(query.substr(limitStart, 12)).c_str(), nullptr, 10);
+	return limit > 0 ? limit : 1000;
+}
+
+// changes holds the log from firstNumber on
+TransportResponse changesResponse(const std::vector<std::pair<ChangeFeed::ChangeType, size_t>> &changes, size_t firstNumber, const Url &url)
+{
+	std::string body(
+		"<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+		"<feed xmlns=\"http://www.w3.org/2005/Atom\""
+		" xmlns:d=\"http://schemas.microsoft.com/ado/2007/08/dataservices\""
+		" xmlns:m=\"http://schemas.microsoft.com/ado/2007/08/dataservices/metadata\">"
+		"<id>");
+	body += url.str();
+	body += "</id><title /><updated>";
+	body += fixedTimestamp;
+	body += "</updated>";
+	char uniqueId[40];
+	for (size_t i = 0; i < changes.size(); ++i) {
+		std::string itemId = std::to_string(changes[i].second);
+		snprintf(uniqueId, sizeof(uniqueId), "00000000-0000-4000-8000-%012zx", changes[i].second);
+		body += "<entry><category term=\"SP.ChangeItem\""
+			" scheme=\"http://schemas.microsoft.com/ado/2007/08/dataservices/scheme\" />"
+			"<title /><updated>";
+		body += fixedTimestamp;
+		body += "</updated><author><name /></author><content type=\"application/xml\"><m:properties>"
+			"<d:ChangeToken m:type=\"SP.ChangeToken\"><d:StringValue>";
+		body += changeToken(firstNumber + i);
+		body += "</d:StringValue></d:ChangeToken><d:ChangeType m:type=\"Edm.Int32\">";
+		body += std::to_string(static_cast<int>(changes[i].first));
+		body += "</d:ChangeType><d:Time m:type=\"Edm.DateTime\">";
+		body += fixedTimestamp;
+		body += "</d:Time><d:ItemId m:type=\"Edm.Int32\">";
+		body += itemId;
+		body += "</d:ItemId><d:ListId m:type=\"Edm.Guid\">";
+		body += listGuid;
+		body += "</d:ListId><d:UniqueId m:type=\"Edm.Guid\">";
+		body += uniqueId;
+		body += "</d:UniqueId></m:properties></content></entry>";
+	}
+	body += "</feed>";
+	TransportResponse response(200, std::move(body), url);
+	response.addHeader("Content-Type", "application/atom+xml;type=feed;charset=utf-8");
+	return response;
+}
+
+TransportResponse currentChangeTokenResponse(size_t changeNumber, const Url &url)
+{
+	std::string body(
+		"<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+		"<d:CurrentChangeToken xmlns:d=\"http://schemas.microsoft.com/ado/2007/08/dataservices\""
+		" xmlns:m=\"http://schemas.microsoft.com/ado/2007/08/dataservices/metadata\""
+		" m:type=\"SP.ChangeToken\"><d:StringValue>");
+	body += changeToken(changeNumber);
+	body += "</d:StringValue></d:CurrentChangeToken>";
+	TransportResponse response(200, std::move(body), url);
+	response.addHeader("Content-Type", "application/xml;charset=utf-8");
+	return response;
+}
+
+// answers a Range header of the form bytes=<first>-[<last>] with 206
+TransportResponse fileResponse(const WebRequest &request, const Url &url, size_t fileSize)
+{
+	size_t first = 0;
+	size_t last = fileSize > 0 ? fileSize - 1 : 0;
+	bool ranged = false;
+	std::string range = requestHeader(request, "Range");
+	if (range.compare(0, 6, "bytes=") == 0 && range.find(',') == std::string::npos) {
+		char *end = nullptr;
+		first = strtoul(range.c_str() + 6, &end, 10);
+		if (end != nullptr && *end == '-') {
+			ranged = true;
+			if (end[1] != '\0') {
+				last = strtoul(end + 1, nullptr, 10);
+			}
+		}
+		if (ranged && first >= fileSize) {
+			TransportResponse response(416, std::string(), url);
+			response.addHeader("Content-Range", "bytes */" + std::to_string(fileSize));
+			return response;
+		}
+		if (last >= fileSize) {
+			last = fileSize - 1;
+		}
+	}
+	size_t length = fileSize > 0 && last >= first ? last - first + 1 : 0;
+	std::string body(length, '\0');
+	for (size_t i = 0; i < length; ++i) {
+		body[i] = static_cast<char>('a' + (first + i) % 26);
+	}
+	TransportResponse response(ranged ? 206 : 200, std::move(body), url);
+	response.addHeader("Content-Type", "application/octet-stream");
+	if (ranged) {
+		response.addHeader("Content-Range",
+			"bytes " + std::to_string(first) + "-" + std::to_string(last) + "/" + std::to_string(fileSize));
+	}
+	return response;
+}
+
+// the number of path parts named <prefix><number>, the depth in the mock tree
+size_t treeDepth(std::string_view path, std::string_view prefix)
+{
+	size_t depth = 0;
+	size_t partStart = 0;
+	while (partStart < path.length()) {
+		size_t partEnd = path.find('/', partStart);
+		if (partEnd == std::string_view::npos) {
+			partEnd = path.length();
+		}
+		std::string part = lowerCase(path.substr(partStart, partEnd - partStart));
+		if (part.length() > prefix.length() && part.compare(0, prefix.length(), prefix) == 0 &&
+			part.find_first_not_of("0123456789", prefix.length()) == std::string::npos) {
+			++depth;
+		}
+		partStart = partEnd + 1;
+	}
+	return depth;
+}
+
+std::string feedStart(const Url &url)
+{
+	std::string body(
+		"<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+		"<feed xmlns=\"http://www.w3.org/2005/Atom\""
+		" xmlns:d=\"http://schemas.microsoft.com/ado/2007/08/dataservices\""
+		" xmlns:m=\"http://schemas.microsoft.com/ado/2007/08/dataservices/metadata\">"
+		"<id>");
+	body += url.str();
+	body += "</id><title /><updated>";
+	body += fixedTimestamp;
+	body += "</updated>";
+	return body;
+}
+
+TransportResponse feedResponse(std::string &&body, const Url &url)
+{
+	body += "</feed>";
+	TransportResponse response(200, std::move(body), url);
+	response.addHeader("Content-Type", "application/atom+xml;type=feed;charset=utf-8");
+	return response;
+}
+
+// the server relative path of the web whose api is called
+std::string webPath(const Url &url)
+{
+	std::string_view resource = url.resource();
+	size_t apiStart = lowerCase(resource).find("/_api/");
+	return std::string(resource.substr(0, apiStart != std::string::npos ? apiStart : resource.length()));
+}
+
+TransportResponse websResponse(const Url &url, const MockSharepointTransport::SiteTree &tree)
+{
+	std::string path = webPath(url);
+	std::string body = feedStart(url);
+	if (treeDepth(path, "web") < tree.webDepth) {
+		for (size_t web = 1; web <= tree.websPerWeb; ++web) {
+			std::string name = "Web" + std::to_string(web);
+			body += "<entry><category term=\"SP.Web\" scheme=\"http://schemas.microsoft.com/ado/2007/08/dataservices/scheme\" />"
+				"<content type=\"application/xml\"><m:properties><d:ServerRelativeUrl>";
+			body += path + "/" + name;
+			body += "</d:ServerRelativeUrl><d:Title>";
+			body += name;
+			body += "</d:Title><d:Url>";
+			body += std::string(url.protocolPrefix()) + std::string(url.host()) + path + "/" + name;
+			body += "</d:Url></m:properties></content></entry>";
+		}
+	}
+	return feedResponse(std::move(body), url);
+}
+
+TransportResponse listsResponse(const Url &url, const MockSharepointTransport::SiteTree &tree)
+{
+	std::string path = webPath(url);
+	std::string body = feedStart(url);
+	for (size_t list = 1; list <= tree.listsPerWeb; ++list) {
+		std::string name = "List" + std::to_string(list);
+		body += "<entry><category term=\"SP.List\" scheme=\"http://schemas.microsoft.com/ado/2007/08/dataservices/scheme\" />"
+			"<link rel=\"http://schemas.microsoft.com/ado/2007/08/dataservices/related/RootFolder\""
+			" type=\"application/atom+xml;type=entry\" title=\"RootFolder\" href=\"Web/Lists/RootFolder\">"
+			"<m:inline><entry><category term=\"SP.Folder\" scheme=\"http://schemas.microsoft.com/ado/2007/08/dataservices/scheme\" />"
+			"<content type=\"application/xml\"><m:properties><d:ServerRelativeUrl>";
+		body += path + "/" + name;
+		body += "</d:ServerRelativeUrl></m:properties></content></entry></m:inline></link>"
+			"<content type=\"application/xml\"><m:properties>"
+			"<d:BaseTemplate m:type=\"Edm.Int32\">101</d:BaseTemplate>"
+			"<d:Hidden m:type=\"Edm.Boolean\">false</d:Hidden><d:Title>";
+		body += name;
+		body += "</d:Title></m:properties></content></entry>";
+	}
+	return feedResponse(std::move(body), url);
+}
+
+// the folder of GetFolderByServerRelativeUrl(@a1)?@a1='<path>'
+std::string folderPath(const Url &url)
+{
+	std::string query = PercentEncoding::decode(url.query());
+	size_t valueStart = query.find("@a1='");
+	if (valueStart == std::string::npos) {
+		return std::string();
+	}
+	valueStart += std::string_view("@a1='").length();
+	std::string path;
+	for (size_t i = valueStart; i < query.length(); ++i) {
+		if (query[i] == '\'') {
+			// a doubled quote stands for one
+			if (i + 1 < query.length() && query[i + 1] == '\'') {
+				path += '\'';
+				++i;
+				continue;
+			}
+			break;
+		}
+		path += query[i];
+	}
+	return path;
+}
+
+TransportResponse foldersResponse(const Url &url, const MockSharepointTransport::SiteTree &tree)
+{
+	std::string path = folderPath(url);
+	std::string body = feedStart(url);
+	if (treeDepth(path, "folder") < tree.folderDepth) {
+		for (size_t folder = 1; folder <= tree.foldersPerFolder; ++folder) {
+			std::string name = "Folder" + std::to_string(folder);
+			body += "<entry><category term=\"SP.Folder\" scheme=\"http://schemas.microsoft.com/ado/2007/08/dataservices/scheme\" />"
+				"<content type=\"application/xml\"><m:properties><d:Name>";
+			body += name;
+			body += "</d:Name><d:ServerRelativeUrl>";
+			body += path + "/" + name;
+			body += "</d:ServerRelativeUrl></m:properties></content></entry>";
+		}
+	}
+	return feedResponse(std::move(body), url);
+}
+
+TransportResponse filesResponse(const Url &url, const MockSharepointTransport::SiteTree &tree, size_t fileSize)
+{
+	std::string path = folderPath(url);
+	std::string body = feedStart(url);
+	for (size_t file = 1; file <= tree.filesPerFolder; ++file) {
+		std::string name = "File" + std::to_string(file) + ".txt";
+		body += "<entry><category term=\"SP.File\" scheme=\"http://schemas.microsoft.com/ado/2007/08/dataservices/scheme\" />"
+			"<content type=\"application/xml\"><m:properties><d:Length m:type=\"Edm.Int64\">";
+		body += std::to_string(fileSize);
+		body += "</d:Length><d:Name>";
+		body += name;
+		body += "</d:Name><d:ServerRelativeUrl>";
+		body += path + "/" + name;
+		body += "</d:ServerRelativeUrl><d:TimeLastModified m:type=\"Edm.DateTime\">";
+		body += fixedTimestamp;
+		body += "</d:TimeLastModified></m:properties></content></entry>";
+	}
+	return feedResponse(std::move(body), url);
+}
+
+// the id of items(<id>) in the resource, 0 if there is none
+size_t itemId(std::string_view resource)
+{
+	size_t idStart = resource.find("/items(");
+	if (idStart == std::string_view::npos) {
+		return 0;
+	}
+	return strtoul(std::string(resource.substr(idStart + 7, 20)).c_str(), nullptr, 10);
+}
+}  // namespace
+
+MockSharepointTransport::MockSharepointTransport() :
+	m_settings(std::make_shared<const Settings>()),
+	m_requestCount(0),
+	m_throttledCount(0),
+	m_digestCount(0)
+{
+}
+
+MockSharepointTransport::~MockSharepointTransport()
+{
+}
+
+template<class Change>
+void MockSharepointTransport::changeSettings(Change &&change)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto settings = std::make_shared<Settings>(*m_settings);
+	change(*settings);
+	m_settings = std::move(settings);
+}
+
+void MockSharepointTransport::setLatency(std::chrono::microseconds latency)
+{
+	changeSettings([latency](Settings &settings) {
+		settings.latencies.fill(latency);
+	});
+}
+
+void MockSharepointTransport::setLatency(RequestMetrics::Endpoint endpoint, std::chrono::microseconds latency)
+{
+	changeSettings([endpoint, latency](Settings &settings) {
+		settings.latencies[static_cast<size_t>(endpoint)] = latency;
+	});
+}
+
+void MockSharepointTransport::setThrottling(size_t everyNthRequest, std::chrono::seconds retryAfter)
+{
+	changeSettings([everyNthRequest, retryAfter](Settings &settings) {
+		settings.throttleEveryNth = everyNthRequest;
+		settings.retryAfter = retryAfter;
+	});
+}
+
+void MockSharepointTransport::setListSize(size_t itemCount, size_t pageSize)
+{
+	changeSettings([itemCount, pageSize](Settings &settings) {
+		settings.listItemCount = itemCount;
+		settings.pageSize = pageSize > 0 ? pageSize : 1;
+	});
+}
+
+void MockSharepointTransport::setItemTitleLength(size_t length)
+{
+	changeSettings([length](Settings &settings) {
+		settings.itemTitleLength = length;
+	});
+}
+
+void MockSharepointTransport::setFileSize(size_t bytes)
+{
+	changeSettings([bytes](Settings &settings) {
+		settings.fileSize = bytes;
+	});
+}
+
+void MockSharepointTransport::setSiteTree(const SiteTree &tree)
+{
+	changeSettings([&tree](Settings &settings) {
+		settings.siteTree = tree;
+	});
+}
+
+void MockSharepointTransport::addChange(ChangeFeed::ChangeType type, size_t itemId)
+{
+	// logged under the same lock as the change of the items
+	changeSettings([this, type, itemId](Settings &settings) {
+		m_changes.push_back(std::pair<ChangeFeed::ChangeType, size_t>(type, itemId));
+		if (type == ChangeFeed::ChangeType::DeleteObject) {
+			settings.deletedItems.insert(itemId);
+			return;
+		}
+		if (type == ChangeFeed::ChangeType::Add || type == ChangeFeed::ChangeType::Restore) {
+			settings.deletedItems.erase(itemId);
+			if (itemId > settings.listItemCount) {
+				settings.listItemCount = itemId;
+			}
+		}
+		if (type != ChangeFeed::ChangeType::Add) {
+			++settings.itemVersions.emplace(itemId, 1).first->second;
+		}
+		if (type == ChangeFeed::ChangeType::Update) {
+			++settings.contentVersions.emplace(itemId, 1).first->second;
+		}
+	});
+}
+
+size_t MockSharepointTransport::requestCount() const
+{
+	return m_requestCount.load();
+}
+
+size_t MockSharepointTransport::throttledCount() const
+{
+	return m_throttledCount.load();
+}
+
+WebResponse MockSharepointTransport::send(const WebRequest &request, Method method, const Url &url, std::string &&data)
+{
+	std::chrono::microseconds latency(0);
+	WebResponse response = answer(request, method, url, data, latency);
+	if (latency.count() > 0) {
+		std::this_thread::sleep_for(latency);
+	}
+	return response;
+}
+
+void MockSharepointTransport::sendAsync(const WebRequest &request, Method method, const Url &url, std::string &&data, CompletionType &&completion)
+{
+	std::chrono::microseconds latency(0);
+	WebResponse response = answer(request, method, url, data, latency);
+	m_timer.schedule(latency, std::move(completion), std::move(response));
+}
+
+WebResponse MockSharepointTransport::answer(const WebRequest &request, Method method, const Url &url, const std::string &data, std::chrono::microseconds &latency)
+{
+	std::shared_ptr<const Settings> settings;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		settings = m_settings;
+	}
+	bool post = method == Method::Post;
+	std::string resource = lowerCase(url.resource());
+	RequestMetrics::Endpoint endpoint = RequestMetrics::classify(resource, post);
+	latency = settings->latencies[static_cast<size_t>(endpoint)];
+
+	size_t requestNumber = ++m_requestCount;
+	TransportResponse response(404, errorBody("-1, Microsoft.SharePoint.Client.ResourceNotFoundException", "Not found."), url);
+	if (settings->throttleEveryNth > 0 && requestNumber % settings->throttleEveryNth == 0) {
+		++m_throttledCount;
+		response = TransportResponse(429, errorBody("-2147024860, Microsoft.SharePoint.SPQueryThrottledException",
+			"The request has been throttled."), url);
+		response.addHeader("Retry-After", std::to_string(settings->retryAfter.count()));
+	} else if (post && endsWith(resource, "/extsts.srf")) {
+		response = stsResponse(data, url);
+	} else if (post && resource.find("/_forms/default.aspx") != std::string::npos) {
+		response = loginPageResponse(request, data, url);
+	} else if (!hasCookie(request.cookieHeader(url), "FedAuth")) {
+		response = TransportResponse(403, errorBody("-2147024891, System.UnauthorizedAccessException", "Access denied."), url);
+	} else if (post && endsWith(resource, "/_api/contextinfo")) {
+		response = contextInfoResponse(++m_digestCount, url);
+	} else if (post && endsWith(resource, "/_api/$batch")) {
+		response = batchResponse(data, url, requestNumber);
+	} else if (!post && itemId(resource) > 0 &&
+		(itemId(resource) > settings->listItemCount || settings->deletedItems.count(itemId(resource)) > 0)) {
+		// keeps the 404 of a missing item
+	} else if (!post && (endsWith(resource, "/$value") || endsWith(resource, "/openbinarystream"))) {
+		response = fileResponse(request, url, settings->fileSize);
+	} else if (!post && endsWith(resource, "/items")) {
+		response = listItemsResponse(url, settings->listItemCount, settings->pageSize, settings->itemTitleLength,
+			settings->fileSize, settings->itemVersions, settings->contentVersions, settings->deletedItems);
+	} else if (!post && itemId(resource) > 0 && endsWith(resource, ")")) {
+		size_t id = itemId(resource);
+		response = itemResponse(url, id, itemVersion(settings->itemVersions, id), itemVersion(settings->contentVersions, id),
+			settings->itemTitleLength, settings->fileSize);
+	} else if (!post && endsWith(resource, "/rootfolder")) {
+		response = rootFolderResponse(url);
+	} else if (!post && endsWith(resource, "/_api/web/webs")) {
+		response = websResponse(url, settings->siteTree);
+	} else if (!post && endsWith(resource, "/_api/web/lists")) {
+		response = listsResponse(url, settings->siteTree);
+	} else if (!post && endsWith(resource, "/getfolderbyserverrelativeurl(@a1)/folders")) {
+		response = foldersResponse(url, settings->siteTree);
+	} else if (!post && endsWith(resource, "/getfolderbyserverrelativeurl(@a1)/files")) {
+		response = filesResponse(url, settings->siteTree, settings->fileSize);
+	} else if (post && resource.find("/items(") != std::string::npos && endsWith(resource, ")")) {
+		response = itemUpdateResponse(url);
+	} else if (post && resource.find("/files/add(") != std::string::npos) {
+		response = fileUploadResponse(data, url);
+	} else if (post && endsWith(resource, "/getchanges")) {
+		// change numbers start at 1, a token names the last change read
+		size_t first = startChangeNumber(data) + 1;
+		size_t limit = fetchLimit(data);
+		std::vector<std::pair<ChangeFeed::ChangeType, size_t>> changes;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			for (size_t number = first; number <= m_changes.size() && changes.size() < limit; ++number) {
+				changes.push_back(m_changes[number - 1]);
+			}
+		}
+		response = changesResponse(changes, first, url);
+	} else if (!post && endsWith(resource, "/currentchangetoken")) {
+		size_t last = 0;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			last = m_changes.size();
+		}
+		response = currentChangeTokenResponse(last, url);
+	}
+
+	if (!post && response.httpStatusCode() == 200) {
+		// the same url and settings always give the same body, its hash serves as etag
+		std::string etag = "\"" + std::to_string(std::hash<std::string_view>()(response.body())) + "\"";
+		if (requestHeader(request, "If-None-Match") == etag) {
+			response = TransportResponse(304, std::string(), url);
+		}
+		response.addHeader("ETag", etag);
+	}
+
+	RequestTimings timings;
+	timings.preTransfer = std::chrono::microseconds(0);
+	timings.startTransfer = latency;
+	timings.total = latency;
+	timings.bytesUp = static_cast<long long>(url.str().length() + data.length());
+	timings.bytesDown = static_cast<long long>(response.bodyLength());
+	timings.connectionReused = requestNumber > 1;
+	response.setTimings(timings);
+	RequestMetrics::record(endpoint, response.httpStatusCode(), timings);
+	return std::move(response);
+}
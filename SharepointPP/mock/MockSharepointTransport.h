@@ -0,0 +1,175 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef MOCK_MOCKSHAREPOINTTRANSPORT_H_
+#define MOCK_MOCKSHAREPOINTTRANSPORT_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "../common/ChangeFeed.h"
+#include "../common/CompletionTimer.h"
+#include "../common/RequestMetrics.h"
+#include "../common/Transport.h"
+
+namespace Microsoft {
+namespace Sharepoint {
+// A stand-in for a sharepoint tenant which answers requests in process,
+// to measure the client offline and reproducibly. It serves
+// - the sts (extSTS.srf), accepting every user with a non-empty password
+// - the login page (_forms/default.aspx), setting FedAuth and rtFa
+// - _api/contextinfo
+// - list item feeds (lists/getbytitle('...')/items), paged with $top and
+//   $skiptoken like sharepoint, single items (items(n)) and the root
+//   folder of a list, every item is a file of the library, with
+//   $expand=File its file entry (Length, TimeLastModified) is inlined
+// - $batch, answering every part with 200
+// - file contents ($value, OpenBinaryStream), a byte range with 206
+// - item updates (a post to items(n)), answered with 204
+// - file uploads (Files/add(url='...')), answered with the file entry
+// - the change log of every list (GetChanges, CurrentChangeToken), which
+//   holds the changes added with addChange()
+// - a tree of webs, lists, folders and files below every site, see
+//   setSiteTree() (web/webs, web/lists, GetFolderByServerRelativeUrl(@a1)
+//   with /Folders and /Files)
+// Everything but the sts and the login page needs the FedAuth cookie.
+// Answers to gets carry an ETag, a get with a matching If-None-Match is
+// answered with 304.
+// Each endpoint class can be given a latency and every n-th request can
+// be throttled. sendAsync() doesn't block, its completion is called on
+// the timer thread of the transport once the latency has passed.
+// The requests are recorded in the RequestMetrics with the simulated
+// latency and the body sizes.
+class MockSharepointTransport : public Transport
+{
+ public:
+	// the shape of the tree below every site: web<n> below a web up to
+	// the depth, list<n> in every web, folder<n> below the root folder
+	// of a list up to the depth and file<n>.txt in every folder
+	struct SiteTree
+	{
+		size_t websPerWeb {2};
+		size_t webDepth {1};
+		size_t listsPerWeb {2};
+		size_t foldersPerFolder {3};
+		size_t folderDepth {2};
+		size_t filesPerFolder {5};
+	};
+
+ public:
+	__declspec(dllexport)
+		MockSharepointTransport();
+	// delivers the responses still waiting for their latency
+	__declspec(dllexport)
+		~MockSharepointTransport();
+	MockSharepointTransport(const MockSharepointTransport &other) = delete;
+	MockSharepointTransport &operator=(const MockSharepointTransport &other) = delete;
+
+ public:
+	// the time until a request is answered, 0 by default
+	__declspec(dllexport)
+		void setLatency(std::chrono::microseconds latency);
+	__declspec(dllexport)
+		void setLatency(RequestMetrics::Endpoint endpoint, std::chrono::microseconds latency);
+	// every n-th request is answered with 429 and a Retry-After header,
+	// 0 turns throttling off
+	__declspec(dllexport)
+		void setThrottling(size_t everyNthRequest, std::chrono::seconds retryAfter);
+	// the items of every list and how many of them a page holds
+	// unless the request asks for another count with $top
+	__declspec(dllexport)
+		void setListSize(size_t itemCount, size_t pageSize);
+	// characters of the title of every list item
+	__declspec(dllexport)
+		void setItemTitleLength(size_t length);
+	__declspec(dllexport)
+		void setFileSize(size_t bytes);
+	__declspec(dllexport)
+		void setSiteTree(const MockSharepointTransport::SiteTree &tree);
+	// appends a change of the item to the change log, every change but an
+	// add gives the item a new version (its etag), only an update changes
+	// its content (the File/TimeLastModified of $expand=File), a deletion
+	// removes it from the list
+	__declspec(dllexport)
+		void addChange(ChangeFeed::ChangeType type, size_t itemId);
+
+ public:
+	__declspec(dllexport)
+		size_t requestCount() const;
+	__declspec(dllexport)
+		size_t throttledCount() const;
+
+ public:
+	__declspec(dllexport)
+		WebResponse send(const WebRequest &request, Transport::Method method, const Url &url, std::string &&data) override;
+	__declspec(dllexport)
+		void sendAsync(const WebRequest &request, Transport::Method method, const Url &url, std::string &&data, Transport::CompletionType &&completion) override;
+
+ private:
+	struct Settings
+	{
+		std::array<std::chrono::microseconds, RequestMetrics::EndpointCount> latencies {};
+		size_t throttleEveryNth {0};
+		std::chrono::seconds retryAfter {0};
+		size_t listItemCount {1000};
+		size_t pageSize {100};
+		size_t itemTitleLength {16};
+		size_t fileSize {64 * 1024};
+		SiteTree siteTree;
+		// the items changed by addChange(), the others are at version 1
+		std::unordered_map<size_t, size_t> itemVersions;
+		std::unordered_map<size_t, size_t> contentVersions;
+		std::unordered_set<size_t> deletedItems;
+	};
+
+ private:
+	// replaces the settings by a changed copy under the lock, requests
+	// being answered keep the old ones
+	template<class Change>
+	void changeSettings(Change &&change);
+	// answers the request and records it, latency is set to the time the answer should take
+	WebResponse answer(const WebRequest &request, Transport::Method method, const Url &url, const std::string &data, std::chrono::microseconds &latency);
+
+ private:
+	mutable std::mutex m_mutex;
+	// never changed in place, so a request only copies the pointer
+	std::shared_ptr<const Settings> m_settings;
+	std::vector<std::pair<ChangeFeed::ChangeType, size_t>> m_changes;
+	std::atomic<size_t> m_requestCount;
+	std::atomic<size_t> m_throttledCount;
+	std::atomic<size_t> m_digestCount;
+	// destroyed first, it may still call completions
+	CompletionTimer m_timer;
+};
+}  // namespace Sharepoint
+}  // namespace Microsoft
+
+#endif  // MOCK_MOCKSHAREPOINTTRANSPORT_H_
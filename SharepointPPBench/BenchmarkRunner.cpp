@@ -0,0 +1,155 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "BenchmarkRunner.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <sstream>
+
+using Microsoft::Sharepoint::BenchmarkRunner;
+
+namespace {
+std::atomic<size_t> allocations(0);
+std::atomic<size_t> bytes(0);
+volatile size_t keptValue = 0;
+}
+
+// every allocation of the process is counted, the library code is
+// compiled into the benchmark so its allocations count as well
+void *operator new(size_t size)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	bytes.fetch_add(size, std::memory_order_relaxed);
+	void *memory = malloc(size > 0 ? size : 1);
+	if (memory == nullptr) {
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void operator delete(void *memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept
+{
+	free(memory);
+}
+
+BenchmarkRunner::BenchmarkRunner(std::chrono::milliseconds minimumTime, const std::string &filter) :
+	m_minimumTime(minimumTime),
+	m_filter(filter)
+{
+}
+
+const std::vector<BenchmarkRunner::Result> &BenchmarkRunner::results() const
+{
+	return m_results;
+}
+
+bool BenchmarkRunner::compare(const std::string &baselineFile, double tolerancePercent) const
+{
+	std::vector<Result> baseline = readResults(baselineFile);
+	if (baseline.empty()) {
+		fprintf(stderr, "no results in baseline %s\n", baselineFile.c_str());
+		return false;
+	}
+	bool passed = true;
+	printf("\n%-32s %12s %12s %10s\n", "compared to baseline", "ns/op", "allocs/op", "change");
+	for (const Result &result : m_results) {
+		auto old = std::find_if(baseline.begin(), baseline.end(), [&result](const Result &other) {
+			return other.name == result.name;
+		});
+		if (old == baseline.end()) {
+			printf("%-32s %12s %12s %10s\n", result.name.c_str(), "-", "-", "new");
+			continue;
+		}
+		double change = 0.0;
+		if (old->nanosecondsPerOperation > 0.0) {
+			change = (result.nanosecondsPerOperation / old->nanosecondsPerOperation - 1.0) * 100.0;
+		}
+		// allocations don't depend on the machine, a single one more is a regression
+		bool slower = change > tolerancePercent;
+		bool moreAllocations = result.allocationsPerOperation > old->allocationsPerOperation + 0.5;
+		const char *verdict = "";
+		if (slower && moreAllocations) {
+			verdict = "  SLOWER, MORE ALLOCATIONS";
+		} else if (slower) {
+			verdict = "  SLOWER";
+		} else if (moreAllocations) {
+			verdict = "  MORE ALLOCATIONS";
+		}
+		printf("%-32s %12.1f %12.2f %+9.1f%%%s\n", result.name.c_str(), old->nanosecondsPerOperation,
+			old->allocationsPerOperation, change, verdict);
+		if (slower || moreAllocations) {
+			passed = false;
+		}
+	}
+	return passed;
+}
+
+size_t BenchmarkRunner::allocationCount()
+{
+	return allocations.load(std::memory_order_relaxed);
+}
+
+size_t BenchmarkRunner::allocatedBytes()
+{
+	return bytes.load(std::memory_order_relaxed);
+}
+
+void BenchmarkRunner::keep(size_t value)
+{
+	keptValue = keptValue + value;
+}
+
+void BenchmarkRunner::report(const Result &result) const
+{
+	if (m_results.empty()) {
+		printf("%-32s %12s %12s %12s %12s\n", "benchmark", "iterations", "ns/op", "allocs/op", "bytes/op");
+	}
+	printf("%-32s %12zu %12.1f %12.2f %12.1f\n", result.name.c_str(), result.iterations,
+		result.nanosecondsPerOperation, result.allocationsPerOperation, result.bytesPerOperation);
+	fflush(stdout);
+}
+
+std::vector<BenchmarkRunner::Result> BenchmarkRunner::readResults(const std::string &file)
+{
+	// reads the table printed by report(), the output of a run can be saved as baseline
+	std::vector<Result> results;
+	std::ifstream input(file);
+	std::string line;
+	while (std::getline(input, line)) {
+		std::istringstream fields(line);
+		Result result;
+		if (fields >> result.name >> result.iterations >> result.nanosecondsPerOperation >>
+			result.allocationsPerOperation >> result.bytesPerOperation) {
+			results.push_back(std::move(result));
+		}
+	}
+	return results;
+}
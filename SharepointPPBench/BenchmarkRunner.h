@@ -0,0 +1,129 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef BENCHMARK_BENCHMARKRUNNER_H_
+#define BENCHMARK_BENCHMARKRUNNER_H_
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Microsoft {
+namespace Sharepoint {
+// Runs every benchmark until it has taken at least the minimum time and
+// reports the time and the allocations (made with operator new) per
+// operation. The operations run in batches, the inputs a batch consumes
+// are prepared before the clock starts.
+class BenchmarkRunner
+{
+ public:
+	struct Result
+	{
+		std::string name;
+		size_t iterations {0};
+		double nanosecondsPerOperation {0.0};
+		double allocationsPerOperation {0.0};
+		double bytesPerOperation {0.0};
+	};
+
+ public:
+	// only benchmarks containing the filter in their name are run
+	BenchmarkRunner(std::chrono::milliseconds minimumTime, const std::string &filter);
+
+ public:
+	template<class Operation>
+	void run(const std::string &name, Operation &&operation)
+	{
+		run(name, [](size_t) {}, std::forward<Operation>(operation));
+	}
+
+	// prepare(n) readies the inputs of the next n operations,
+	// operation(i) runs the i-th of them
+	template<class Prepare, class Operation>
+	void run(const std::string &name, Prepare &&prepare, Operation &&operation)
+	{
+		if (name.find(m_filter) == std::string::npos) {
+			return;
+		}
+		// the first call initializes static data and pools
+		prepare(1);
+		operation(0);
+
+		Result result;
+		result.name = name;
+		std::chrono::nanoseconds elapsed(0);
+		size_t allocations = 0;
+		size_t bytes = 0;
+		size_t batchSize = 1;
+		while (elapsed < m_minimumTime) {
+			prepare(batchSize);
+			size_t allocationsBefore = allocationCount();
+			size_t bytesBefore = allocatedBytes();
+			auto start = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < batchSize; ++i) {
+				operation(i);
+			}
+			elapsed += std::chrono::steady_clock::now() - start;
+			allocations += allocationCount() - allocationsBefore;
+			bytes += allocatedBytes() - bytesBefore;
+			result.iterations += batchSize;
+			batchSize = std::min(batchSize * 2, maxBatchSize);
+		}
+		double iterations = static_cast<double>(result.iterations);
+		result.nanosecondsPerOperation = static_cast<double>(elapsed.count()) / iterations;
+		result.allocationsPerOperation = static_cast<double>(allocations) / iterations;
+		result.bytesPerOperation = static_cast<double>(bytes) / iterations;
+		report(result);
+		m_results.push_back(std::move(result));
+	}
+
+	const std::vector<Result> &results() const;
+
+	// compares the results with the output of an earlier run, false if
+	// a benchmark got slower than the tolerance allows or allocates more
+	bool compare(const std::string &baselineFile, double tolerancePercent) const;
+
+ public:
+	static size_t allocationCount();
+	static size_t allocatedBytes();
+	// keeps the compiler from dropping a result nobody reads
+	static void keep(size_t value);
+
+ private:
+	void report(const Result &result) const;
+	static std::vector<Result> readResults(const std::string &file);
+
+ private:
+	static constexpr size_t maxBatchSize = 4096;
+
+ private:
+	std::chrono::nanoseconds m_minimumTime;
+	std::string m_filter;
+	std::vector<Result> m_results;
+};
+}  // namespace Sharepoint
+}  // namespace Microsoft
+
+#endif  // BENCHMARK_BENCHMARKRUNNER_H_
@@ -0,0 +1,105 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "CoroutineBenchmarks.h"
+
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../SharepointPP/authentication/Authentication.h"
+#include "../SharepointPP/common/AsyncEngine.h"
+#include "../SharepointPP/common/Coroutines.h"
+#include "../SharepointPP/common/Transport.h"
+#include "../SharepointPP/common/Url.h"
+#include "../SharepointPP/mock/MockSharepointTransport.h"
+
+// Coroutines.h declares nothing below C++20, the project compiles this
+// file with /std:c++20 and the others with /std:c++17
+#ifndef __cpp_impl_coroutine
+#error "CoroutineBenchmarks.cpp has to be compiled as C++20"
+#endif
+
+using Microsoft::Sharepoint::AsyncClient;
+using Microsoft::Sharepoint::AsyncEngine;
+using Microsoft::Sharepoint::Authentication;
+using Microsoft::Sharepoint::BenchmarkRunner;
+using Microsoft::Sharepoint::MockSharepointTransport;
+using Microsoft::Sharepoint::Task;
+using Microsoft::Sharepoint::Transport;
+
+namespace {
+const size_t listItems = 1000;
+const size_t pageSize = 100;
+const size_t parallelListings = 16;
+
+// 0 if a page couldn't be read
+Task<size_t> countEntries(const AsyncClient &client, const Url &url)
+{
+	size_t count = 0;
+	long httpStatusCode = 0;
+	auto entries = client.entries(url, &httpStatusCode);
+	while (co_await entries.next() != nullptr) {
+		++count;
+	}
+	co_return httpStatusCode == 200 ? count : 0;
+}
+}  // namespace
+
+void Microsoft::Sharepoint::benchmarkCoroutines(BenchmarkRunner &runner)
+{
+	auto mock = std::make_shared<MockSharepointTransport>();
+	mock->setListSize(listItems, pageSize);
+	Transport::setDefaultTransport(mock);
+	{
+		Authentication authentication;
+		authentication.setSharepointEndpoint("https://contoso.sharepoint.com");
+		if (!authentication.authenticate("alice@contoso.onmicrosoft.com", "password")) {
+			Transport::setDefaultTransport(nullptr);
+			return;
+		}
+		AsyncEngine engine;
+		AsyncClient client(engine, authentication.getPreparedRequest());
+		const Url url(std::string("https://contoso.sharepoint.com/sites/team/_api/web/lists/getbytitle('Documents')/items"));
+
+		// the ten pages of the list one after the other
+		runner.run("coroutine.page_list", [&client, &url](size_t) {
+			BenchmarkRunner::keep(syncWait(countEntries(client, url)));
+		});
+
+		// as many listings at once, the waiting ones hold no thread
+		runner.run("coroutine.page_list_parallel", [&client, &url](size_t) {
+			std::vector<std::future<size_t>> counts;
+			counts.reserve(parallelListings);
+			for (size_t i = 0; i < parallelListings; ++i) {
+				std::promise<size_t> count;
+				counts.push_back(count.get_future());
+				fulfil(countEntries(client, url), std::move(count));
+			}
+			for (auto &count : counts) {
+				BenchmarkRunner::keep(count.get());
+			}
+		});
+	}
+	Transport::setDefaultTransport(nullptr);
+}
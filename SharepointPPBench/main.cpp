@@ -0,0 +1,473 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <curl/curl.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "BenchmarkRunner.h"
+#include "CoroutineBenchmarks.h"
+
+#include "../SharepointPP/authentication/Authentication.h"
+#include "../SharepointPP/authentication/STSRequest.h"
+#include "../SharepointPP/common/CookieJar.h"
+#include "../SharepointPP/common/Url.h"
+#include "../SharepointPP/common/WebRequest.h"
+#include "../SharepointPP/common/WebResponse.h"
+#include "../SharepointPP/common/WebTransfer.h"
+#include "../SharepointPP/common/XmlDocumentPool.h"
+#include "../SharepointPP/common/XmlPath.h"
+#include "../SharepointPP/common/tinyxml2.h"
+#include "../SharepointPP/mock/MockSharepointTransport.h"
+
+using Microsoft::Sharepoint::Authentication;
+using Microsoft::Sharepoint::BenchmarkRunner;
+using Microsoft::Sharepoint::benchmarkCoroutines;
+using Microsoft::Sharepoint::CookieJar;
+using Microsoft::Sharepoint::MockSharepointTransport;
+using Microsoft::Sharepoint::WebRequest;
+using Microsoft::Sharepoint::WebResponse;
+using Microsoft::Sharepoint::WebResponseImpl;
+using Microsoft::Sharepoint::XmlDocumentPool;
+using Microsoft::Sharepoint::XmlPath;
+
+namespace Microsoft {
+namespace Sharepoint {
+// reaches the parsers the library keeps private
+class Benchmark
+{
+ public:
+	static std::string parseSTSResponse(std::string &&responseXml, const std::string &endpoint)
+	{
+		return Authentication::parseSTSResponse(std::move(responseXml), endpoint);
+	}
+	static void parseContextInfoResponse(Authentication &authentication, std::string &&responseXml)
+	{
+		authentication.parseContextInfoResponse(std::move(responseXml));
+	}
+	static size_t receiveHeader(WebResponseImpl &response, std::string &line)
+	{
+		return WebResponseImpl::curlHeaderFunction(&line[0], 1, line.length(), static_cast<WebResponse *>(&response));
+	}
+	static void readSingleCookie(WebResponseImpl &response, struct curl_slist *cookie, CookieJar *cookieJar)
+	{
+		response.readSingleCookie(cookie, cookieJar);
+	}
+};
+}  // namespace Sharepoint
+}  // namespace Microsoft
+
+using Microsoft::Sharepoint::Benchmark;
+
+namespace {
+const char *endpoint = "https://contoso.sharepoint.com";
+
+// the bodies of the login and of a page of list items, as the mock sharepoint sends them
+struct Responses
+{
+	std::string sts;
+	std::string contextInfo;
+	std::string listItems;
+};
+
+Responses collectResponses()
+{
+	Responses responses;
+	auto mock = std::make_shared<MockSharepointTransport>();
+	mock->setListSize(1000, 100);
+	mock->setItemTitleLength(32);
+	auto cookieJar = std::make_shared<CookieJar>();
+
+	WebRequest stsRequest;
+	stsRequest.setTransport(mock);
+	stsRequest.setContentType("application/xml");
+	responses.sts = stsRequest.post(Url(std::string("https://login.microsoftonline.com/extSTS.srf")),
+		STSRequest::build("alice@contoso.onmicrosoft.com", "password", endpoint)).takeResponse();
+
+	WebRequest loginPageRequest;
+	loginPageRequest.setTransport(mock);
+	loginPageRequest.setCookieJar(cookieJar);
+	loginPageRequest.post(Url(std::string(endpoint) + "/_forms/default.aspx?wa=wsignin1.0"),
+		Benchmark::parseSTSResponse(std::string(responses.sts), endpoint));
+
+	WebRequest contextInfoRequest;
+	contextInfoRequest.setTransport(mock);
+	contextInfoRequest.setCookieJar(cookieJar);
+	contextInfoRequest.setContentType("application/x-www-form-urlencoded");
+	responses.contextInfo = contextInfoRequest.post(Url(std::string(endpoint) + "/_api/contextinfo"), "").takeResponse();
+
+	WebRequest listRequest;
+	listRequest.setTransport(mock);
+	listRequest.setCookieJar(cookieJar);
+	responses.listItems = listRequest.get(Url(std::string(endpoint) +
+		"/sites/team/_api/web/lists/getbytitle('Documents')/items")).takeResponse();
+	return responses;
+}
+
+// the header lines curl hands to the callback for a list items response
+std::vector<std::string> responseHeaderLines()
+{
+	return {
+		"HTTP/1.1 200 OK\r\n",
+		"Cache-Control: private, max-age=0\r\n",
+		"Transfer-Encoding: chunked\r\n",
+		"Content-Type: application/atom+xml;type=feed;charset=utf-8\r\n",
+		"Expires: Sun, 30 Dec 2018 10:21:45 GMT\r\n",
+		"Last-Modified: Mon, 14 Jan 2019 10:21:45 GMT\r\n",
+		"Server: Microsoft-IIS/10.0\r\n",
+		"X-SharePointHealthScore: 0\r\n",
+		"X-SP-SERVERSTATE: ReadOnly=0\r\n",
+		"DATASERVICEVERSION: 3.0\r\n",
+		"SPClientServiceRequestDuration: 41\r\n",
+		"SPRequestGuid: 5b2c9a9e-9048-7000-a4b1-4e0a4e7b7c8d\r\n",
+		"request-id: 5b2c9a9e-9048-7000-a4b1-4e0a4e7b7c8d\r\n",
+		"MS-CV: nposW0iQAHCksU4KTnt8jQ.0\r\n",
+		"Strict-Transport-Security: max-age=31536000\r\n",
+		"X-FRAME-OPTIONS: SAMEORIGIN\r\n",
+		"X-Powered-By: ASP.NET\r\n",
+		"MicrosoftSharePointTeamServices: 16.0.0.8428\r\n",
+		"X-Content-Type-Options: nosniff\r\n",
+		"X-MS-InvokeApp: 1; RequireReadOnly\r\n",
+		"Date: Mon, 14 Jan 2019 10:21:45 GMT\r\n",
+		"\r\n"
+	};
+}
+
+// the cookie list curl reports after the login page, in the netscape format
+std::vector<std::string> loginCookieLines()
+{
+	return {
+		"#HttpOnly_contoso.sharepoint.com\tFALSE\t/\tTRUE\t0\trtFa\t" + std::string(600, 'r'),
+		"#HttpOnly_contoso.sharepoint.com\tFALSE\t/\tTRUE\t0\tFedAuth\t" + std::string(1400, 'f'),
+		"contoso.sharepoint.com\tFALSE\t/\tFALSE\t1547461305\tSPOIDCRL\t" + std::string(100, 's')
+	};
+}
+
+// the std::regex parser Url used before the single-pass one, to compare
+// their speed and results; the hyphen of the first character class is
+// moved to its end, only msvc accepts "\w-." in a class
+struct RegexUrl
+{
+	std::string protocolPrefix;
+	std::string host;
+	std::string resource;
+	char resourceParametersSeparator {'\0'};
+	std::vector<std::string> parameters;
+
+	explicit RegexUrl(const std::string &url)
+	{
+		try {
+			std::regex regex("([\\w.\\:-]+\\/\\/)?([\\w.-]+)(.*)", std::regex::ECMAScript);
+			std::sregex_iterator itHost(url.begin(), url.end(), regex);
+			if (itHost == std::sregex_iterator()) {
+				return;
+			}
+			protocolPrefix = itHost->str(1);
+			host = itHost->str(2);
+			std::string rest(itHost->str(3));
+			if (rest.length() == 0) {
+				return;
+			}
+			std::regex regexResource("([\\w\\/.&]*)([^\\w^\\/])(.*)", std::regex::ECMAScript);
+			std::sregex_iterator itResource(rest.begin(), rest.end(), regexResource);
+			if (itResource == std::sregex_iterator()) {
+				return;
+			}
+			resource = itResource->str(1);
+			if (itResource->str(2).length() == 1) {
+				resourceParametersSeparator = itResource->str(2)[0];
+			}
+			std::string parameterList(itResource->str(3));
+			std::regex regexParameters(
+				"(?:((?:[\\w^=\\+\\%\\\\\\.\\-]+)"
+				"([^\\w^\\&^\\+^\\\\^\\-^\\.])"
+				"(?:[\\w^=\\+\\%\\\\\\.\\-]+))+\\&?)", std::regex::ECMAScript);
+			for (std::sregex_iterator itParameters(parameterList.begin(), parameterList.end(), regexParameters);
+				itParameters != std::sregex_iterator();
+				++itParameters) {
+				if (itParameters->str(1).length() > 0) {
+					parameters.push_back(itParameters->str(1));
+				}
+			}
+		} catch (...) {}
+	}
+
+	// the query, as the parameters were split from it
+	std::string query() const
+	{
+		std::string value;
+		for (const std::string &parameter : parameters) {
+			value += value.empty() ? "" : "&";
+			value += parameter;
+		}
+		return value;
+	}
+
+	// whether the parts put together give the parsed url again
+	bool reproduces(const std::string &url) const
+	{
+		std::string value(protocolPrefix + host + resource);
+		if (resourceParametersSeparator != '\0') {
+			value += resourceParametersSeparator;
+			value += query();
+		}
+		return value == url;
+	}
+};
+
+// both parsers have to agree on the parts the regexes recovered: the
+// protocol prefix and the host always, the rest where the regexes cut the
+// url correctly, and a parsed url has to give back its text unchanged
+bool sameAsRegexUrl(const std::string &value)
+{
+	Url url(value);
+	RegexUrl reference(value);
+	if (url.str() != value ||
+		url.protocolPrefix() != reference.protocolPrefix ||
+		url.host() != reference.host) {
+		return false;
+	}
+	if (!reference.reproduces(value)) {
+		return true;
+	}
+	return url.resource() == reference.resource && url.query() == reference.query();
+}
+
+bool benchmarkUrl(BenchmarkRunner &runner)
+{
+	const std::vector<std::string> urls {
+		std::string(endpoint) + "/_api/contextinfo",
+		std::string(endpoint) + "/sites/team/_api/web/lists/getbytitle('Documents')/items?%24top=100&%24skiptoken=Paged%3dTRUE%26p_ID%3d300",
+		std::string(endpoint) + "/sites/team/_api/web/GetFileByServerRelativeUrl('/sites/team/Shared%20Documents/report.docx')/$value"
+	};
+	Url url(urls[0]);
+	runner.run("url.parse", [&url, &urls](size_t i) {
+		url = urls[i % urls.size()];
+		BenchmarkRunner::keep(url.resource().length());
+	});
+
+	std::vector<Url> parsed;
+	for (const std::string &value : urls) {
+		parsed.emplace_back(value);
+	}
+	runner.run("url.to_string", [&parsed](size_t i) {
+		std::string value = parsed[i % parsed.size()];
+		BenchmarkRunner::keep(value.length());
+	});
+
+	// the sign in url is one the regexes split correctly
+	std::vector<std::string> checked(urls);
+	checked.push_back(std::string(endpoint) + "/_forms/default.aspx?wa=wsignin1.0");
+	checked.push_back("https://login.microsoftonline.com/extSTS.srf");
+	for (const std::string &value : checked) {
+		if (!sameAsRegexUrl(value)) {
+			fprintf(stderr, "url: the parser differs from the regex parser for %s\n", value.c_str());
+			return false;
+		}
+	}
+	runner.run("url.parse_regex", [&urls](size_t i) {
+		RegexUrl reference(urls[i % urls.size()]);
+		BenchmarkRunner::keep(reference.resource.length());
+	});
+
+	// the single-pass parser has to stay at least 100 times faster
+	const BenchmarkRunner::Result *parse = nullptr;
+	const BenchmarkRunner::Result *parseRegex = nullptr;
+	for (const BenchmarkRunner::Result &result : runner.results()) {
+		if (result.name == "url.parse") {
+			parse = &result;
+		} else if (result.name == "url.parse_regex") {
+			parseRegex = &result;
+		}
+	}
+	if (parse != nullptr && parseRegex != nullptr && parse->nanosecondsPerOperation > 0.0) {
+		double speedup = parseRegex->nanosecondsPerOperation / parse->nanosecondsPerOperation;
+		printf("url.parse is %.0f times as fast as url.parse_regex\n", speedup);
+		if (speedup < 100.0) {
+			fprintf(stderr, "url: the parser is less than 100 times as fast as the regex parser\n");
+			return false;
+		}
+	}
+	return true;
+}
+
+void benchmarkHeaders(BenchmarkRunner &runner)
+{
+	std::vector<std::string> lines = responseHeaderLines();
+	std::vector<std::unique_ptr<WebResponseImpl>> responses;
+	runner.run("headers.receive_response", [&responses](size_t count) {
+		responses.clear();
+		for (size_t i = 0; i < count; ++i) {
+			responses.push_back(std::make_unique<WebResponseImpl>());
+		}
+	}, [&responses, &lines](size_t i) {
+		for (std::string &line : lines) {
+			BenchmarkRunner::keep(Benchmark::receiveHeader(*responses[i], line));
+		}
+	});
+
+	// the headers of an authenticated post, with the accept header given twice
+	WebRequest::HeaderContainerType headers {
+		{"X-RequestDigest", "0x2A8DA0DBC4A5E5A37C4F9D4B5F1B8D5E2A0F6B1C7D3E9F0A1B2C3D4E5F6A7B8C9D0E1F2A3B4C5D6E7F8A9B0C1D2E3F4A5B6,14 Jan 2019 10:21:45 -0000"},
+		{"accept", "application/xml;odata=verbose"},
+		{"Content-Type", "application/xml"},
+		{"accept", "application/json;odata=nometadata"},
+		{"Content-Length", "0"}
+	};
+	runner.run("headers.add_custom", [&headers](size_t) {
+		struct curl_slist *headerStruct = nullptr;
+		Microsoft::Sharepoint::addCustomHeaderToHeaderStruct(headers, headerStruct);
+		BenchmarkRunner::keep(headerStruct != nullptr);
+		curl_slist_free_all(headerStruct);
+	});
+}
+
+void benchmarkCookies(BenchmarkRunner &runner)
+{
+	std::vector<std::string> lines = loginCookieLines();
+	std::vector<struct curl_slist> cookieList(lines.size());
+	for (size_t i = 0; i < lines.size(); ++i) {
+		cookieList[i].data = &lines[i][0];
+		cookieList[i].next = (i + 1 < lines.size()) ? &cookieList[i + 1] : nullptr;
+	}
+	CookieJar cookieJar;
+	std::vector<std::unique_ptr<WebResponseImpl>> responses;
+	runner.run("cookies.read_login_cookies", [&responses](size_t count) {
+		responses.clear();
+		for (size_t i = 0; i < count; ++i) {
+			responses.push_back(std::make_unique<WebResponseImpl>());
+		}
+	}, [&responses, &cookieList, &cookieJar](size_t i) {
+		for (struct curl_slist *cookie = &cookieList[0]; cookie != nullptr; cookie = cookie->next) {
+			Benchmark::readSingleCookie(*responses[i], cookie, &cookieJar);
+		}
+	});
+}
+
+void benchmarkAuthentication(BenchmarkRunner &runner, const Responses &responses)
+{
+	std::vector<std::string> bodies;
+	auto copies = [&bodies](const std::string &body) {
+		return [&bodies, &body](size_t count) {
+			bodies.assign(count, body);
+		};
+	};
+	const std::string stsEndpoint(endpoint);
+	runner.run("auth.parse_sts_response", copies(responses.sts), [&bodies, &stsEndpoint](size_t i) {
+		BenchmarkRunner::keep(Benchmark::parseSTSResponse(std::move(bodies[i]), stsEndpoint).length());
+	});
+
+	Authentication authentication;
+	runner.run("auth.parse_context_info", copies(responses.contextInfo), [&bodies, &authentication](size_t i) {
+		Benchmark::parseContextInfoResponse(authentication, std::move(bodies[i]));
+	});
+}
+
+void benchmarkXml(BenchmarkRunner &runner, const Responses &responses)
+{
+	static const XmlPath::NamespaceContainerType namespaces {
+		{"m", "http://schemas.microsoft.com/ado/2007/08/dataservices/metadata"},
+		{"d", "http://schemas.microsoft.com/ado/2007/08/dataservices"}
+	};
+	static const XmlPath titlePath("content/m:properties/d:Title", namespaces);
+	std::vector<std::string> bodies;
+	// a page of 100 list items, every title is read
+	runner.run("xml.parse_list_items_feed", [&bodies, &responses](size_t count) {
+		bodies.assign(count, responses.listItems);
+	}, [&bodies](size_t i) {
+		XmlDocumentPool::DocumentLease doc(XmlDocumentPool::document());
+		doc->ParseInSitu(std::move(bodies[i]));
+		const tinyxml2::XMLElement *feed = doc->FirstChildElement("feed");
+		if (feed == nullptr) {
+			return;
+		}
+		for (const tinyxml2::XMLElement *entry = feed->FirstChildElement("entry");
+			entry != nullptr;
+			entry = entry->NextSiblingElement("entry")) {
+			const char *title = titlePath.text(*entry);
+			BenchmarkRunner::keep(title != nullptr ? strlen(title) : 0);
+		}
+	});
+}
+
+void printUsage(const char *program)
+{
+	fprintf(stderr,
+		"usage: %s [filter] [--min-time milliseconds] [--baseline file] [--tolerance percent]\n"
+		"  filter      runs only the benchmarks containing it in their name\n"
+		"  --min-time  how long every benchmark runs at least, 500 by default\n"
+		"  --baseline  compares with the saved output of an earlier run, fails on regressions\n"
+		"  --tolerance how much slower than the baseline is accepted, 10 by default\n",
+		program);
+}
+}  // namespace
+
+int main(int argc, char *argv[])
+{
+	std::string filter;
+	std::string baseline;
+	long minimumTime = 500;
+	double tolerance = 10.0;
+	for (int i = 1; i < argc; ++i) {
+		std::string argument(argv[i]);
+		if (argument == "--min-time" && i + 1 < argc) {
+			minimumTime = strtol(argv[++i], nullptr, 10);
+		} else if (argument == "--baseline" && i + 1 < argc) {
+			baseline = argv[++i];
+		} else if (argument == "--tolerance" && i + 1 < argc) {
+			tolerance = strtod(argv[++i], nullptr);
+		} else if (argument.length() > 0 && argument[0] != '-' && filter.empty()) {
+			filter = argument;
+		} else {
+			printUsage(argv[0]);
+			return 2;
+		}
+	}
+
+	Responses responses = collectResponses();
+	if (responses.sts.empty() || responses.contextInfo.empty() || responses.listItems.empty()) {
+		fprintf(stderr, "the mock sharepoint didn't answer the login\n");
+		return 1;
+	}
+
+	BenchmarkRunner runner(std::chrono::milliseconds(minimumTime), filter);
+	if (!benchmarkUrl(runner)) {
+		return 1;
+	}
+	benchmarkHeaders(runner);
+	benchmarkCookies(runner);
+	benchmarkAuthentication(runner, responses);
+	benchmarkXml(runner, responses);
+	benchmarkCoroutines(runner);
+
+	if (!baseline.empty() && !runner.compare(baseline, tolerance)) {
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,268 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "LoadGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "../SharepointPP/common/Url.h"
+
+using Microsoft::Sharepoint::LoadGenerator;
+using Microsoft::Sharepoint::WebRequest;
+using Microsoft::Sharepoint::WebResponse;
+
+LoadGenerator::LoadGenerator(AsyncEngine &engine, const WebRequest &preparedRequest, const Options &options) :
+	m_engine(engine),
+	m_options(options),
+	m_readRequest(preparedRequest),
+	m_updateRequest(preparedRequest),
+	m_downloadRequest(preparedRequest),
+	m_uploadRequest(preparedRequest),
+	m_issued(0),
+	m_inFlight(0)
+{
+	if (m_options.concurrency == 0) {
+		m_options.concurrency = 1;
+	}
+	std::string list = m_options.siteUrl + "/_api/web/lists/getbytitle('" + m_options.listTitle + "')";
+	m_readUrl = list + "/items?%24top=" + std::to_string(m_options.pageSize);
+	m_downloadUrl = m_options.siteUrl + "/_api/web/GetFileByServerRelativeUrl('" +
+		m_options.downloadFile + "')/$value";
+
+	// a merge changes only the given fields of the item
+	std::string itemType = m_options.itemType;
+	if (itemType.empty()) {
+		itemType = "SP.Data." + m_options.listTitle + "ListItem";
+	}
+	m_updateBody = "{\"__metadata\":{\"type\":\"" + itemType + "\"},\"Title\":\"updated by the load generator\"}";
+	m_updateRequest.setContentType("application/json;odata=verbose");
+	m_updateRequest.addHeader("X-HTTP-Method", "MERGE");
+	m_updateRequest.addHeader("IF-MATCH", "*");
+
+	m_uploadBody.assign(m_options.uploadSize, 'x');
+	m_uploadRequest.setContentType("application/octet-stream");
+
+	// spreads the operations evenly over the schedule by their weights
+	// (smooth weighted round robin), so every part of a run sees the mix
+	std::array<long, OperationCount> current {};
+	long totalWeight = 0;
+	for (unsigned weight : m_options.mix) {
+		totalWeight += weight;
+	}
+	for (long step = 0; step < totalWeight; ++step) {
+		size_t chosen = 0;
+		for (size_t operation = 0; operation < OperationCount; ++operation) {
+			current[operation] += m_options.mix[operation];
+			if (current[operation] > current[chosen]) {
+				chosen = operation;
+			}
+		}
+		current[chosen] -= totalWeight;
+		m_schedule.push_back(static_cast<Operation>(chosen));
+	}
+	if (m_schedule.empty()) {
+		m_schedule.push_back(Operation::ListRead);
+	}
+}
+
+LoadGenerator::Report LoadGenerator::run()
+{
+	Report report;
+	std::chrono::microseconds cpuBefore = processCpuTime();
+	Clock::time_point start = Clock::now();
+	m_deadline = start + m_options.duration;
+
+	if (m_options.requestsPerSecond <= 0.0) {
+		// every answer issues the next request until the time is up
+		for (size_t i = 0; i < m_options.concurrency; ++i) {
+			issue(start);
+		}
+	} else {
+		std::chrono::duration<double> interval(1.0 / m_options.requestsPerSecond);
+		for (size_t number = 0; ; ++number) {
+			Clock::time_point scheduledStart = start +
+				std::chrono::duration_cast<Clock::duration>(interval * static_cast<double>(number));
+			if (scheduledStart >= m_deadline) {
+				break;
+			}
+			std::this_thread::sleep_until(scheduledStart);
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_slotFree.wait(lock, [this]() { return m_inFlight < m_options.concurrency; });
+			}
+			issue(scheduledStart);
+		}
+	}
+	m_engine.wait();
+
+	report.elapsed = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start);
+	report.cpuTime = processCpuTime() - cpuBefore;
+	std::lock_guard<std::mutex> lock(m_mutex);
+	std::vector<Sample> all;
+	for (size_t operation = 0; operation < OperationCount; ++operation) {
+		all.insert(all.end(), m_samples[operation].begin(), m_samples[operation].end());
+		report.operations[operation] = statistics(m_samples[operation]);
+	}
+	report.total = statistics(all);
+	return report;
+}
+
+const char *LoadGenerator::operationName(Operation operation)
+{
+	switch (operation) {
+	case Operation::ListRead:
+		return "list read";
+	case Operation::ItemUpdate:
+		return "item update";
+	case Operation::FileDownload:
+		return "file download";
+	case Operation::FileUpload:
+		return "file upload";
+	}
+	return "";
+}
+
+void LoadGenerator::issue(Clock::time_point scheduledStart)
+{
+	size_t number = m_issued.fetch_add(1);
+	Operation operation = m_schedule[number % m_schedule.size()];
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		++m_inFlight;
+	}
+	auto completion = [this, operation, scheduledStart](WebResponse &&response) {
+		finished(operation, scheduledStart, response);
+	};
+	switch (operation) {
+	case Operation::ListRead:
+		m_engine.get(m_readRequest, Url(m_readUrl), completion);
+		break;
+	case Operation::ItemUpdate:
+		m_engine.post(m_updateRequest, Url(itemUrl(number)), m_updateBody, completion);
+		break;
+	case Operation::FileDownload:
+		m_engine.get(m_downloadRequest, Url(m_downloadUrl), completion);
+		break;
+	case Operation::FileUpload:
+		m_engine.post(m_uploadRequest, Url(uploadUrl(number)), m_uploadBody, completion);
+		break;
+	}
+}
+
+void LoadGenerator::finished(Operation operation, Clock::time_point scheduledStart, const WebResponse &response)
+{
+	// runs on the engine thread
+	Clock::time_point now = Clock::now();
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_samples[static_cast<size_t>(operation)].push_back(Sample {
+			std::chrono::duration_cast<std::chrono::microseconds>(now - scheduledStart),
+			response.httpStatusCode()});
+		--m_inFlight;
+	}
+	m_slotFree.notify_one();
+	if (m_options.requestsPerSecond <= 0.0 && now < m_deadline) {
+		issue(now);
+	}
+}
+
+std::string LoadGenerator::itemUrl(size_t requestNumber) const
+{
+	size_t item = m_options.itemCount > 0 ? requestNumber % m_options.itemCount + 1 : 1;
+	return m_options.siteUrl + "/_api/web/lists/getbytitle('" + m_options.listTitle +
+		"')/items(" + std::to_string(item) + ")";
+}
+
+std::string LoadGenerator::uploadUrl(size_t requestNumber) const
+{
+	// every upload writes its own file, they don't wait for each other's lock
+	return m_options.siteUrl + "/_api/web/GetFolderByServerRelativeUrl('" + m_options.uploadFolder +
+		"')/Files/add(url='load-" + std::to_string(requestNumber) + ".bin',overwrite=true)";
+}
+
+LoadGenerator::Statistics LoadGenerator::statistics(std::vector<Sample> &samples)
+{
+	Statistics result;
+	result.requests = samples.size();
+	if (samples.empty()) {
+		return result;
+	}
+	for (const Sample &sample : samples) {
+		if (sample.httpStatusCode == 429 || sample.httpStatusCode == 503) {
+			++result.throttled;
+		} else if (sample.httpStatusCode < 0 || sample.httpStatusCode >= 400) {
+			++result.errors;
+		}
+	}
+	std::sort(samples.begin(), samples.end(), [](const Sample &left, const Sample &right) {
+		return left.latency < right.latency;
+	});
+	// nearest rank
+	auto quantile = [&samples](double q) {
+		size_t rank = static_cast<size_t>(std::ceil(q * static_cast<double>(samples.size())));
+		return samples[rank > 0 ? rank - 1 : 0].latency;
+	};
+	result.p50 = quantile(0.5);
+	result.p99 = quantile(0.99);
+	result.p999 = quantile(0.999);
+	result.max = samples.back().latency;
+	return result;
+}
+
+std::chrono::microseconds LoadGenerator::processCpuTime()
+{
+#ifdef _WIN32
+	FILETIME creation;
+	FILETIME exitTime;
+	FILETIME kernel;
+	FILETIME user;
+	if (!GetProcessTimes(GetCurrentProcess(), &creation, &exitTime, &kernel, &user)) {
+		return std::chrono::microseconds(0);
+	}
+	// in units of 100 nanoseconds
+	auto toMicroseconds = [](const FILETIME &time) {
+		ULARGE_INTEGER value;
+		value.LowPart = time.dwLowDateTime;
+		value.HighPart = time.dwHighDateTime;
+		return static_cast<long long>(value.QuadPart / 10);
+	};
+	return std::chrono::microseconds(toMicroseconds(kernel) + toMicroseconds(user));
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) {
+		return std::chrono::microseconds(0);
+	}
+	auto toMicroseconds = [](const struct timeval &time) {
+		return static_cast<long long>(time.tv_sec) * 1000000 + time.tv_usec;
+	};
+	return std::chrono::microseconds(toMicroseconds(usage.ru_utime) + toMicroseconds(usage.ru_stime));
+#endif
+}
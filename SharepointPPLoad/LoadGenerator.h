@@ -0,0 +1,157 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+#ifndef LOAD_LOADGENERATOR_H_
+#define LOAD_LOADGENERATOR_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../SharepointPP/common/AsyncEngine.h"
+#include "../SharepointPP/common/WebRequest.h"
+#include "../SharepointPP/common/WebResponse.h"
+
+namespace Microsoft {
+namespace Sharepoint {
+// Drives a mix of list reads, item updates, file downloads and uploads
+// through an AsyncEngine and collects the latency of every request.
+// Without a request rate it keeps the given number of requests in
+// flight (closed loop). With a rate it starts the requests on schedule,
+// at most the given number at once, and measures from the scheduled
+// start, so a server falling behind shows in the latencies (open loop).
+class LoadGenerator
+{
+ public:
+	enum class Operation
+	{
+		ListRead,
+		ItemUpdate,
+		FileDownload,
+		FileUpload
+	};
+	static constexpr size_t OperationCount = 4;
+
+	struct Options
+	{
+		// the site the list and the files belong to
+		std::string siteUrl;
+		std::string listTitle {"Documents"};
+		// the entity type of the list items, SP.Data.<list>ListItem if empty
+		std::string itemType;
+		// the updates go round robin over the items 1..itemCount
+		size_t itemCount {100};
+		size_t pageSize {100};
+		// server relative, percent encoded
+		std::string downloadFile {"/Shared%20Documents/load.bin"};
+		std::string uploadFolder {"/Shared%20Documents"};
+		size_t uploadSize {64 * 1024};
+		// the weights of the operations
+		std::array<unsigned, OperationCount> mix {{70, 10, 15, 5}};
+		size_t concurrency {16};
+		// 0 runs the closed loop
+		double requestsPerSecond {0.0};
+		std::chrono::seconds duration {30};
+	};
+
+	struct Statistics
+	{
+		size_t requests {0};
+		// failed transfers and error answers, throttling not included
+		size_t errors {0};
+		// answered with 429 or 503
+		size_t throttled {0};
+		std::chrono::microseconds p50 {0};
+		std::chrono::microseconds p99 {0};
+		std::chrono::microseconds p999 {0};
+		std::chrono::microseconds max {0};
+	};
+
+	struct Report
+	{
+		std::array<Statistics, OperationCount> operations;
+		Statistics total;
+		// from the first request until the last one has been answered
+		std::chrono::microseconds elapsed {0};
+		// the cpu time the process spent meanwhile, in all threads
+		std::chrono::microseconds cpuTime {0};
+	};
+
+ public:
+	// the prepared request carries the cookies and the request digest
+	LoadGenerator(AsyncEngine &engine, const WebRequest &preparedRequest, const Options &options);
+	LoadGenerator(const LoadGenerator &other) = delete;
+	LoadGenerator &operator=(const LoadGenerator &other) = delete;
+
+ public:
+	Report run();
+
+ public:
+	static const char *operationName(Operation operation);
+
+ private:
+	typedef std::chrono::steady_clock Clock;
+
+	struct Sample
+	{
+		std::chrono::microseconds latency;
+		long httpStatusCode;
+	};
+
+ private:
+	void issue(Clock::time_point scheduledStart);
+	void finished(Operation operation, Clock::time_point scheduledStart, const WebResponse &response);
+	std::string itemUrl(size_t requestNumber) const;
+	std::string uploadUrl(size_t requestNumber) const;
+	static Statistics statistics(std::vector<Sample> &samples);
+	static std::chrono::microseconds processCpuTime();
+
+ private:
+	AsyncEngine &m_engine;
+	Options m_options;
+	WebRequest m_readRequest;
+	WebRequest m_updateRequest;
+	WebRequest m_downloadRequest;
+	WebRequest m_uploadRequest;
+	std::string m_readUrl;
+	std::string m_downloadUrl;
+	std::string m_updateBody;
+	std::string m_uploadBody;
+	// the operations spread by their weights, request n runs m_schedule[n % size]
+	std::vector<Operation> m_schedule;
+	Clock::time_point m_deadline;
+	std::atomic<size_t> m_issued;
+
+	std::mutex m_mutex;
+	std::condition_variable m_slotFree;
+	size_t m_inFlight;
+	std::array<std::vector<Sample>, OperationCount> m_samples;
+};
+}  // namespace Sharepoint
+}  // namespace Microsoft
+
+#endif  // LOAD_LOADGENERATOR_H_
@@ -0,0 +1,267 @@
+// MIT License
+//
+// Copyright (c) 2018 Lukas Luedke
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "LoadGenerator.h"
+
+#include "../SharepointPP/authentication/Authentication.h"
+#include "../SharepointPP/common/AsyncEngine.h"
+#include "../SharepointPP/common/ConsoleUtil.h"
+#include "../SharepointPP/common/RequestMetrics.h"
+#include "../SharepointPP/common/Transport.h"
+#include "../SharepointPP/mock/MockSharepointTransport.h"
+
+using Microsoft::Sharepoint::AsyncEngine;
+using Microsoft::Sharepoint::Authentication;
+using Microsoft::Sharepoint::LoadGenerator;
+using Microsoft::Sharepoint::MockSharepointTransport;
+using Microsoft::Sharepoint::RequestMetrics;
+using Microsoft::Sharepoint::Transport;
+
+namespace {
+struct Arguments
+{
+	LoadGenerator::Options load;
+	std::string username;
+	bool mock {false};
+	long mockLatency {20};
+	size_t mockThrottleEveryNth {0};
+	std::string metricsFile;
+};
+
+void printUsage(const char *program)
+{
+	fprintf(stderr,
+		"usage: %s [options]\n"
+		"  --site url           the site to load, https://contoso.sharepoint.com with --mock\n"
+		"  --user name          the account to sign in with, the password is read from\n"
+		"                       SHAREPOINT_PASSWORD or the console\n"
+		"  --mock               runs against the in-process mock sharepoint\n"
+		"  --latency ms         the latency of the mock, 20 by default\n"
+		"  --throttle n         the mock throttles every n-th request\n"
+		"  --list title         the list read and updated, Documents by default\n"
+		"  --item-type type     the entity type of its items, SP.Data.<list>ListItem by default\n"
+		"  --items n            the items 1..n are updated round robin, 100 by default\n"
+		"  --page-size n        the items a list read asks for, 100 by default\n"
+		"  --file url           the server relative url of the downloaded file\n"
+		"  --folder url         the server relative url of the upload folder\n"
+		"  --upload-size bytes  65536 by default\n"
+		"  --mix r,u,d,w        the weights of reads, updates, downloads and uploads,\n"
+		"                       70,10,15,5 by default\n"
+		"  --concurrency n      the requests in flight, 16 by default\n"
+		"  --rps n              starts the requests at this rate instead, with at most\n"
+		"                       --concurrency in flight\n"
+		"  --duration seconds   30 by default\n"
+		"  --metrics file       writes the request metrics of the library in the\n"
+		"                       prometheus text format\n",
+		program);
+}
+
+bool parseMix(const std::string &value, std::array<unsigned, LoadGenerator::OperationCount> &mix)
+{
+	std::istringstream input(value);
+	std::string weight;
+	size_t operation = 0;
+	while (std::getline(input, weight, ',')) {
+		if (operation >= mix.size() || weight.empty()) {
+			return false;
+		}
+		mix[operation++] = static_cast<unsigned>(strtoul(weight.c_str(), nullptr, 10));
+	}
+	return operation == mix.size();
+}
+
+bool parseArguments(int argc, char *argv[], Arguments &arguments)
+{
+	for (int i = 1; i < argc; ++i) {
+		std::string option(argv[i]);
+		if (option == "--mock") {
+			arguments.mock = true;
+			continue;
+		}
+		if (i + 1 >= argc) {
+			return false;
+		}
+		std::string value(argv[++i]);
+		if (option == "--site") {
+			arguments.load.siteUrl = value;
+		} else if (option == "--user") {
+			arguments.username = value;
+		} else if (option == "--latency") {
+			arguments.mockLatency = strtol(value.c_str(), nullptr, 10);
+		} else if (option == "--throttle") {
+			arguments.mockThrottleEveryNth = strtoul(value.c_str(), nullptr, 10);
+		} else if (option == "--list") {
+			arguments.load.listTitle = value;
+		} else if (option == "--item-type") {
+			arguments.load.itemType = value;
+		} else if (option == "--items") {
+			arguments.load.itemCount = strtoul(value.c_str(), nullptr, 10);
+		} else if (option == "--page-size") {
+			arguments.load.pageSize = strtoul(value.c_str(), nullptr, 10);
+		} else if (option == "--file") {
+			arguments.load.downloadFile = value;
+		} else if (option == "--folder") {
+			arguments.load.uploadFolder = value;
+		} else if (option == "--upload-size") {
+			arguments.load.uploadSize = strtoul(value.c_str(), nullptr, 10);
+		} else if (option == "--mix") {
+			if (!parseMix(value, arguments.load.mix)) {
+				return false;
+			}
+		} else if (option == "--concurrency") {
+			arguments.load.concurrency = strtoul(value.c_str(), nullptr, 10);
+		} else if (option == "--rps") {
+			arguments.load.requestsPerSecond = strtod(value.c_str(), nullptr);
+		} else if (option == "--duration") {
+			arguments.load.duration = std::chrono::seconds(strtol(value.c_str(), nullptr, 10));
+		} else if (option == "--metrics") {
+			arguments.metricsFile = value;
+		} else {
+			return false;
+		}
+	}
+	if (arguments.mock) {
+		if (arguments.load.siteUrl.empty()) {
+			arguments.load.siteUrl = "https://contoso.sharepoint.com";
+		}
+		if (arguments.username.empty()) {
+			arguments.username = "load@contoso.onmicrosoft.com";
+		}
+	}
+	if (!arguments.load.siteUrl.empty() && arguments.load.siteUrl.back() == '/') {
+		arguments.load.siteUrl.pop_back();
+	}
+	return !arguments.load.siteUrl.empty() && !arguments.username.empty();
+}
+
+std::string readPassword(bool mock)
+{
+	if (mock) {
+		return "mock";
+	}
+	if (const char *password = getenv("SHAREPOINT_PASSWORD")) {
+		return password;
+	}
+	std::string password;
+	std::cout << "please enter your password: ";
+	SetStdinEcho(false);
+	std::cin >> password;
+	SetStdinEcho(true);
+	std::cout << std::endl;
+	return password;
+}
+
+double milliseconds(std::chrono::microseconds value)
+{
+	return static_cast<double>(value.count()) / 1000.0;
+}
+
+void printStatistics(const char *name, const LoadGenerator::Statistics &statistics)
+{
+	printf("%-14s %10zu %8zu %10zu %10.2f %10.2f %10.2f %10.2f\n", name, statistics.requests,
+		statistics.errors, statistics.throttled, milliseconds(statistics.p50), milliseconds(statistics.p99),
+		milliseconds(statistics.p999), milliseconds(statistics.max));
+}
+
+void printReport(const LoadGenerator::Report &report)
+{
+	printf("%-14s %10s %8s %10s %10s %10s %10s %10s\n", "operation", "requests", "errors",
+		"throttled", "p50 ms", "p99 ms", "p999 ms", "max ms");
+	for (size_t operation = 0; operation < LoadGenerator::OperationCount; ++operation) {
+		printStatistics(LoadGenerator::operationName(static_cast<LoadGenerator::Operation>(operation)),
+			report.operations[operation]);
+	}
+	printStatistics("total", report.total);
+
+	double seconds = static_cast<double>(report.elapsed.count()) / 1e6;
+	double requests = static_cast<double>(report.total.requests);
+	if (seconds <= 0.0 || requests <= 0.0) {
+		return;
+	}
+	printf("\nthroughput     %.1f requests/s over %.1f s\n", requests / seconds, seconds);
+	printf("error rate     %.2f %%\n", 100.0 * static_cast<double>(report.total.errors) / requests);
+	printf("throttle rate  %.2f %%\n", 100.0 * static_cast<double>(report.total.throttled) / requests);
+	printf("client cpu     %.1f us/request, %.2f cores\n",
+		static_cast<double>(report.cpuTime.count()) / requests,
+		static_cast<double>(report.cpuTime.count()) / static_cast<double>(report.elapsed.count()));
+}
+}  // namespace
+
+int main(int argc, char *argv[])
+{
+	Arguments arguments;
+	if (!parseArguments(argc, argv, arguments)) {
+		printUsage(argv[0]);
+		return 2;
+	}
+
+	std::shared_ptr<MockSharepointTransport> mock;
+	if (arguments.mock) {
+		mock = std::make_shared<MockSharepointTransport>();
+		mock->setLatency(std::chrono::milliseconds(arguments.mockLatency));
+		mock->setThrottling(arguments.mockThrottleEveryNth, std::chrono::seconds(1));
+		mock->setListSize(arguments.load.itemCount, arguments.load.pageSize);
+		Transport::setDefaultTransport(mock);
+	}
+
+	// signs in once, every request of the run shares the cookies and the digest
+	Authentication authentication;
+	authentication.setSharepointEndpoint(arguments.load.siteUrl);
+	if (!authentication.authenticate(std::string(arguments.username), readPassword(arguments.mock))) {
+		fprintf(stderr, "authentication failed\n");
+		return 1;
+	}
+
+	LoadGenerator::Report report;
+	{
+		AsyncEngine engine(static_cast<long>(arguments.load.concurrency));
+		LoadGenerator generator(engine, authentication.getPreparedRequest(), arguments.load);
+		if (arguments.load.requestsPerSecond > 0.0) {
+			printf("running %.1f requests/s, at most %zu in flight, for %lld s\n",
+				arguments.load.requestsPerSecond, arguments.load.concurrency,
+				static_cast<long long>(arguments.load.duration.count()));
+		} else {
+			printf("running %zu requests in flight for %lld s\n", arguments.load.concurrency,
+				static_cast<long long>(arguments.load.duration.count()));
+		}
+		report = generator.run();
+	}
+	printReport(report);
+
+	if (!arguments.metricsFile.empty()) {
+		std::ofstream metrics(arguments.metricsFile);
+		metrics << RequestMetrics::prometheusText();
+	}
+	if (mock) {
+		Transport::setDefaultTransport(nullptr);
+	}
+	return 0;
+}
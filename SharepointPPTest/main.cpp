@@ -11,6 +11,7 @@
 #include "../SharepointPP/common/ConsoleUtil.h"
 #include "../SharepointPP/common/WebRequest.h"
 #include "../SharepointPP/common/WebResponse.h"
+#include "../SharepointPP/common/XmlDocumentPool.h"
 
 using namespace tinyxml2;
 
@@ -42,13 +43,14 @@ int main(int argc, char *argv[]) {
 	Microsoft::Sharepoint::WebRequest newRequest = authentication.getPreparedRequest();
 	Microsoft::Sharepoint::WebResponse response = newRequest.get(Url("https://microsoft.sharepoint.com", "/teams/DeDOC/_api/web/lists"));
 	if (response.httpStatusCode() >= 0) {
-		std::string responseData = response.response();
-		tinyxml2::XMLDocument doc;
-		doc.Parse(responseData.data());
-		tinyxml2::XMLPrinter printer;
-		doc.Print(&printer);
-		std::cout << "response: " << printer.CStr() << std::endl;
-		tinyxml2::XMLElement *entry = doc.FirstChildElement("entry");
+		Microsoft::Sharepoint::XmlDocumentPool::DocumentLease doc(
+			Microsoft::Sharepoint::XmlDocumentPool::document());
+		doc->ParseInSitu(response.takeResponse());
+		Microsoft::Sharepoint::XmlDocumentPool::PrinterLease printer(
+			Microsoft::Sharepoint::XmlDocumentPool::printer());
+		doc->Print(printer.get());
+		std::cout << "response: " << printer->CStr() << std::endl;
+		tinyxml2::XMLElement *entry = doc->FirstChildElement("entry");
 		if(entry != nullptr) {
 			for (tinyxml2::XMLElement* child = entry->FirstChildElement(); child != nullptr; child = child->NextSiblingElement()) {
 				if (child != nullptr) {